@@ -31,6 +31,7 @@
 #include <QMutex>
 
 #include "AudioBuffer.h"
+#include "LatencyCompensator.h"
 #include "PlayHandle.h"
 
 namespace lmms
@@ -74,6 +75,14 @@ public:
 	EffectChain* effects() { return m_effects.get(); }
 	bool processEffects();
 
+	//! Latency of the effect chain, see Effect::latencyFrames()
+	f_cnt_t latencyFrames() const;
+	//! Delay the output, so it lines up with slower signals into the same mixer channel
+	void setLatencyCompensation(f_cnt_t frames) { m_latencyCompensator.setDelay(frames); }
+
+	//! Copy the output of every period into @p tap, which must hold a period, or stop copying if nullptr
+	void setTap(SampleFrame* tap) { m_tap = tap; }
+
 	// ThreadableJob stuff
 	void doProcessing() override;
 	bool requiresProcessing() const override { return true; }
@@ -92,6 +101,8 @@ private:
 	QString m_name;
 
 	std::unique_ptr<EffectChain> m_effects;
+	LatencyCompensator m_latencyCompensator;
+	SampleFrame* m_tap = nullptr;
 
 	PlayHandleList m_playHandles;
 	QMutex m_playHandleLock;
@@ -59,6 +59,12 @@ public:
 		return m_supportsCapture;
 	}
 
+	//! Whether the device reads its buffers through AudioEngine::renderNextBuffer(), which may render them ahead
+	inline bool readsRenderedBuffers() const
+	{
+		return m_readsRenderedBuffers;
+	}
+
 	inline sample_rate_t sampleRate() const
 	{
 		return m_sampleRate;
@@ -89,6 +95,7 @@ protected:
 	static void stopProcessingThread( QThread * thread );
 protected:
 	bool m_supportsCapture;
+	bool m_readsRenderedBuffers;
 
 private:
 	virtual void startProcessingImpl() = 0;
@@ -40,6 +40,8 @@ public:
 	AudioDummy( bool & _success_ful, AudioEngine* audioEngine ) :
 		AudioDevice( DEFAULT_CHANNELS, audioEngine )
 	{
+		// renders the periods itself, see run()
+		m_readsRenderedBuffers = false;
 		_success_ful = true;
 	}
 
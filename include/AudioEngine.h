@@ -25,6 +25,9 @@
 #ifndef LMMS_AUDIO_ENGINE_H
 #define LMMS_AUDIO_ENGINE_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <mutex>
 
 #include <QThread>
@@ -39,15 +42,20 @@
 #include "SampleFrame.h"
 #include "LocklessList.h"
 #include "AudioEngineProfiler.h"
+#include "MidiEvent.h"
 #include "PlayHandle.h"
+#include "TimePos.h"
 
 
 namespace lmms
 {
 
 class MidiClient;
+class MidiPort;
 class AudioBusHandle;  // IWYU pragma: keep
 class AudioEngineWorkerThread;
+template<class T> class LocklessRingBuffer;
+template<class T> class LocklessRingBufferReader;
 
 constexpr f_cnt_t MINIMUM_BUFFER_SIZE = 32;
 constexpr f_cnt_t DEFAULT_BUFFER_SIZE = 256;
@@ -158,6 +166,25 @@ public:
 		return m_midiClient;
 	}
 
+	/**
+	 * @brief Queue an event which just arrived at @p port, to be processed at the start of a period
+	 *
+	 * Can be called from any thread without blocking. The event is timestamped on arrival and
+	 * starts at the matching frame of a later period, delayed by one audio buffer, so notes keep
+	 * the timing they were played with instead of all starting at period boundaries.
+	 *
+	 * Events are dropped and counted if the queue is full, as passing them on right away would
+	 * reorder them with the ones still queued, and so are system exclusive messages, whose data
+	 * does not outlive the call.
+	 */
+	void queueMidiInput(MidiPort* port, const MidiEvent& event, const TimePos& time);
+
+	//! Forget all queued events of @p port, which is about to be destroyed
+	void dropMidiInput(const MidiPort* port);
+
+	//! Number of MIDI input events @ref queueMidiInput() had to drop
+	std::size_t droppedMidiInput() const { return m_droppedMidiInput.load(std::memory_order_relaxed); }
+
 
 	// play-handle stuff
 	bool addPlayHandle( PlayHandle* handle );
@@ -242,7 +269,8 @@ public:
 
 	/**
 	 * @returns The internal buffer size used by audio plugins and other processing done within the audio engine.
-	 * Its value is @ref DEFAULT_BUFFER_SIZE or @ref framesPerAudioBuffer(), whichever is lower.
+	 * Its value is @ref DEFAULT_BUFFER_SIZE or @ref framesPerAudioBuffer(), whichever is lower, unless
+	 * changed for offline rendering with @ref setOfflinePeriodSize().
 	 * @see renderNextPeriod()
 	 */
 	f_cnt_t framesPerPeriod() const { return m_framesPerPeriod; }
@@ -298,6 +326,70 @@ public:
 		return RequestChangesGuard{this};
 	}
 
+	/**
+	 * @brief Commit a structural change without waiting for the audio thread
+	 *
+	 * Unlike @ref requestChangeInModel(), this never blocks. @p apply runs on the rendering thread at the start
+	 * of the next period, before anything is processed, so it should only publish what the caller prepared,
+	 * e.g. by swapping in a new list. Changes are applied in the order they were committed.
+	 *
+	 * Afterwards, @p release runs and both functions are destroyed on the main thread, so they can free whatever
+	 * the change unlinked from the audio graph. If the engine is destroyed first, @p release runs without
+	 * @p apply ever running.
+	 */
+	void commitChange(std::function<void()> apply, std::function<void()> release = {});
+
+	//! Delete @p object once all changes committed so far are applied, see @ref commitChange()
+	void retire(QObject* object);
+
+	//! Apply all committed changes right away, blocking like @ref requestChangeInModel()
+	void flushChanges();
+
+	/**
+	 * Hold back the faster paths through the mixer by what the effects report now, see
+	 * Mixer::compensateLatency(). This is done at the start of every period anyway, but
+	 * some effects only report their latency once they ran.
+	 * @returns The latency of the master channel in frames
+	 */
+	f_cnt_t compensateLatency();
+
+	//! Set the number of threads rendering audio, including the audio thread
+	//! itself. Only affects audio engines created afterwards, 0 means one
+	//! thread per core.
+	static void setThreadCount(int threads);
+
+	int threadCount() const { return m_numWorkers + 1; }
+
+	//! Set the period size of render-only audio engines created afterwards,
+	//! 0 means the default. Larger periods render faster, but automation and
+	//! everything else updated once per period gets coarser.
+	static void setOfflinePeriodSize(f_cnt_t frames);
+
+	//! Upper limit for the "renderahead" setting
+	static constexpr int MaxRenderAheadPeriods = 16;
+
+	//! Counters of the render-ahead mode, see @ref renderAheadPeriods()
+	struct RenderAheadStatistics
+	{
+		std::size_t underruns; //!< periods the audio device had to play silence, as none was rendered yet
+		std::size_t xruns; //!< periods which took longer to render than to play
+	};
+
+	/**
+	 * @returns How many periods a dedicated render thread may render ahead of the audio device, or 0 if the
+	 * audio device renders the periods itself.
+	 *
+	 * With render-ahead enabled, the device callback only copies periods out of a lock-free ring buffer, so
+	 * it never waits for rendering or for @ref requestChangeInModel(). The price is the additional latency.
+	 */
+	int renderAheadPeriods() const { return m_renderAheadPeriods; }
+
+	RenderAheadStatistics renderAheadStatistics() const
+	{
+		return {m_renderAheadUnderruns.load(std::memory_order_relaxed),
+			m_renderAheadXruns.load(std::memory_order_relaxed)};
+	}
+
 	static bool isAudioDevNameValid(QString name);
 	static bool isMidiDevNameValid(QString name);
 
@@ -314,7 +406,7 @@ private:
 		for (auto frame = f_cnt_t{0}; frame < dst.frames(); ++frame)
 		{
 			if (m_outputBufferReadIndex == m_framesPerPeriod) { m_outputBufferReadIndex = 0; }
-			if (m_outputBufferReadIndex == 0) { renderNextPeriod(); }
+			if (m_outputBufferReadIndex == 0) { nextOutputPeriod(); }
 
 			switch (dst.channels())
 			{
@@ -322,15 +414,15 @@ private:
 				assert(false);
 				break;
 			case 1:
-				dst.sample(0, frame) = m_outputBufferRead[m_outputBufferReadIndex].average();
+				dst.sample(0, frame) = m_outputPeriod[m_outputBufferReadIndex].average();
 				break;
 			case 2:
-				dst.sample(0, frame) = m_outputBufferRead[m_outputBufferReadIndex][0];
-				dst.sample(1, frame) = m_outputBufferRead[m_outputBufferReadIndex][1];
+				dst.sample(0, frame) = m_outputPeriod[m_outputBufferReadIndex][0];
+				dst.sample(1, frame) = m_outputPeriod[m_outputBufferReadIndex][1];
 				break;
 			default:
-				dst.sample(0, frame) = m_outputBufferRead[m_outputBufferReadIndex][0];
-				dst.sample(1, frame) = m_outputBufferRead[m_outputBufferReadIndex][1];
+				dst.sample(0, frame) = m_outputPeriod[m_outputBufferReadIndex][0];
+				dst.sample(1, frame) = m_outputPeriod[m_outputBufferReadIndex][1];
 				for (auto channel = 2; channel < dst.channels(); ++channel)
 				{
 					dst.sample(channel, frame) = 0.f;
@@ -345,16 +437,42 @@ private:
 	AudioEngine( bool renderOnly );
 	~AudioEngine() override;
 
-	void startProcessing() { m_audioDev->startProcessing(); }
-	void stopProcessing() { m_audioDev->stopProcessing(); }
+	void startProcessing();
+	void stopProcessing();
+
+	//! Point m_outputPeriod to the next period for the audio device
+	void nextOutputPeriod();
+
+	void startRenderAhead();
+	void stopRenderAhead();
+	void renderAhead();
+
+	struct Change;
+	//! Apply @p changes, a list in reverse order of committing, and hand them to collectGarbage()
+	void applyChanges(Change* changes);
+	//! Release the applied changes, must run on the main thread
+	void collectGarbage();
+	static void releaseChanges(Change* changes);
 
 
 	AudioDevice * tryAudioDevices();
 	MidiClient * tryMidiClients();
 
+	struct MidiInput
+	{
+		MidiPort* port;
+		MidiEvent event;
+		TimePos time;
+		std::int64_t arrival; //!< nanoseconds on a steady clock
+	};
+
+	//! Move the events queued so far to m_pendingMidiInput
+	void takeMidiInput();
+	//! Pass the events which fall into the current period on to their ports
+	void processMidiInput();
+
 	void renderStageNoteSetup();
-	void renderStageInstruments();
-	void renderStageEffects();
+	void renderStageProcessing();
 	void renderStageMix();
 
 
@@ -379,6 +497,23 @@ private:
 	std::unique_ptr<SampleFrame[]> m_outputBufferRead;
 	std::unique_ptr<SampleFrame[]> m_outputBufferWrite;
 	f_cnt_t m_outputBufferReadIndex;
+	//! Period the audio device currently reads from
+	const SampleFrame* m_outputPeriod;
+
+	// render-ahead mode: m_renderAheadThread renders periods into m_renderAheadBuffer,
+	// the audio device copies them into m_renderAheadPeriod
+	int m_renderAheadPeriods;
+	std::unique_ptr<LocklessRingBuffer<SampleFrame>> m_renderAheadBuffer;
+	std::unique_ptr<LocklessRingBufferReader<SampleFrame>> m_renderAheadReader;
+	std::unique_ptr<SampleFrame[]> m_renderAheadPeriod;
+	std::unique_ptr<QThread> m_renderAheadThread;
+	std::atomic_bool m_renderAheadQuit;
+	//! Whether the render thread delivered anything since it started
+	bool m_renderAheadPrimed;
+	//! Incremented and notified whenever the audio device takes a period
+	std::atomic<std::uint64_t> m_periodsRead;
+	std::atomic_size_t m_renderAheadUnderruns;
+	std::atomic_size_t m_renderAheadXruns;
 
 	// worker thread stuff
 	std::vector<AudioEngineWorkerThread *> m_workers;
@@ -403,12 +538,24 @@ private:
 	MidiClient * m_midiClient;
 	QString m_midiClientName;
 
+	LocklessList<MidiInput> m_midiInput;
+	//! Events taken from m_midiInput which were not processed yet, in order of arrival
+	std::vector<MidiInput> m_pendingMidiInput;
+	//! Start of the current period on a clock which advances by exactly one period per period,
+	//! so MIDI input keeps its timing even if several periods are rendered at once
+	std::int64_t m_midiInputClock;
+	std::atomic_size_t m_droppedMidiInput;
+
 	AudioEngineProfiler m_profiler;
 
 	bool m_clearSignal;
 
 	std::recursive_mutex m_changeMutex;
 
+	// changes committed with commitChange(), both lists in reverse order
+	std::atomic<Change*> m_pendingChanges;
+	std::atomic<Change*> m_appliedChanges;
+
 	friend class Engine;
 	friend class AudioEngineWorkerThread;
 	friend class ProjectRenderer;
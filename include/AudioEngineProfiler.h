@@ -27,8 +27,16 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <QFile>
+#include <QString>
 
+#include "BufferManager.h"
 #include "LmmsTypes.h"
 #include "MicroTimer.h"
 
@@ -39,26 +47,40 @@ class AudioEngineProfiler
 {
 public:
 	AudioEngineProfiler();
-	~AudioEngineProfiler() = default;
+	~AudioEngineProfiler();
 
 	void startPeriod()
 	{
 		m_periodTimer.reset();
+		m_periodStart = now();
 	}
 
 	void finishPeriod( sample_rate_t sampleRate, f_cnt_t framesPerPeriod );
 
+	/**
+	 * @brief Move the jobs recorded during the period into the statistics and the trace
+	 *
+	 * Names the jobs by their sources, so it must be called once all jobs of the
+	 * period are done, but before any of their sources may be deleted.
+	 */
+	void collectJobs();
+
 	int cpuLoad() const
 	{
 		return m_cpuLoad;
 	}
 
+	/**
+	 * @brief Write profiling information to @p outputFile
+	 *
+	 * If the file name ends in ".json", every job of every period is written as a
+	 * Chrome trace (chrome://tracing, Perfetto), otherwise the duration of each period.
+	 */
 	void setOutputFile( const QString& outputFile );
 
 	enum class DetailType {
 		NoteSetup,
-		Instruments,
-		Effects,
+		Processing,
 		Mixing,
 		Count
 	};
@@ -70,6 +92,98 @@ public:
 		return m_detailLoad[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
 	}
 
+	//! Usage of the buffers play handles render into, see BufferManager
+	BufferManager::Statistics bufferStatistics() const
+	{
+		return BufferManager::statistics();
+	}
+
+	//! Kinds of jobs which are timed individually, see @ref JobProbe
+	enum class JobType
+	{
+		Instrument, //!< notes and samples played on a track, identified by its AudioBusHandle
+		//! collecting the output of an instrument playing asynchronously, see InstrumentPlayHandle::finishJob()
+		InstrumentOutput,
+		Track, //!< a track's AudioBusHandle, including its effects
+		Effect,
+		MixerChannel, //!< a mixer channel, including its effects
+		RemotePlugin, //!< waiting for a plugin running in another process, see RemotePlugin::finishProcess()
+		Count
+	};
+
+	struct JobStatistics
+	{
+		JobType type;
+		const void* source; //!< the timed object, only meant to identify it
+		QString name;
+		//! Microseconds spent in the job per period
+		float minTime;
+		float averageTime;
+		float p99Time;
+	};
+
+	//! Number of periods @ref jobStatistics covers
+	static constexpr auto StatisticsPeriods = std::size_t{256};
+
+	//! Time each job individually, which adds a little overhead to every job
+	void setJobProfiling(bool enabled);
+
+	bool jobProfiling() const
+	{
+		return m_jobProfiling.load(std::memory_order_acquire);
+	}
+
+	//! Time spent per period in each job over the last @ref StatisticsPeriods periods, most expensive first
+	std::vector<JobStatistics> jobStatistics() const;
+
+	struct MidiLatencyStatistics
+	{
+		std::size_t notes; //!< notes measured since the measurement was enabled
+		//! Milliseconds from the arrival of a note to the frame it starts at, not including the audio device's latency
+		float minLatency;
+		float averageLatency;
+		float maxLatency;
+	};
+
+	//! Measure how long notes played on MIDI inputs take until they start, see AudioEngine::queueMidiInput
+	void setMidiLatencyMeasurement(bool enabled);
+
+	bool midiLatencyMeasurement() const
+	{
+		return m_midiLatencyMeasurement.load(std::memory_order_relaxed);
+	}
+
+	MidiLatencyStatistics midiLatencyStatistics() const;
+
+	//! Called by the audio thread for every note if the measurement is enabled
+	void recordMidiLatency(std::int64_t nanoseconds);
+
+	//! Times the job @p source from construction to destruction, if job profiling is enabled
+	class JobProbe
+	{
+	public:
+		JobProbe(AudioEngineProfiler& profiler, JobType type, const void* source)
+			: m_profiler(source && profiler.jobProfiling() ? &profiler : nullptr)
+			, m_type(type)
+			, m_source(source)
+			, m_start(m_profiler ? now() : 0)
+		{
+		}
+		~JobProbe()
+		{
+			if (m_profiler) { m_profiler->recordJob(m_type, m_source, m_start, now()); }
+		}
+		JobProbe& operator=(const JobProbe&) = delete;
+		JobProbe(const JobProbe&) = delete;
+		JobProbe(JobProbe&&) = delete;
+
+	private:
+		AudioEngineProfiler* m_profiler;
+		const JobType m_type;
+		const void* m_source;
+		const std::int64_t m_start;
+	};
+
 	class Probe
 	{
 	public:
@@ -96,9 +210,55 @@ private:
 		m_detailTime[static_cast<std::size_t>(type)] = m_detailTimer[static_cast<std::size_t>(type)].elapsed();
 	}
 
+	struct JobSample
+	{
+		JobType type;
+		const void* source;
+		std::int64_t start;
+		std::int64_t end;
+	};
+
+	struct ThreadLog;
+	struct JobEntry;
+
+	//! Nanoseconds on a steady clock
+	static std::int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void recordJob(JobType type, const void* source, std::int64_t start, std::int64_t end);
+	JobEntry* findJob(JobType type, const void* source);
+	//! Drop the jobs which didn't run during the last @ref StatisticsPeriods periods
+	void ageJobs();
+	//! Remove the job in @p slot of m_jobs
+	void removeJob(std::size_t slot);
+	void writeTraceEvent(const QString& name, const char* category, int thread, std::int64_t start, std::int64_t end);
+
 	MicroTimer m_periodTimer;
 	std::atomic<float> m_cpuLoad;
 	QFile m_outputFile;
+	bool m_traceOutput = false;
+	bool m_firstTraceEvent = true;
+	std::int64_t m_periodStart = 0;
+
+	std::atomic_bool m_jobProfiling = false;
+	//! One log per thread which ran jobs, only allocated once job profiling is enabled
+	std::unique_ptr<ThreadLog[]> m_threadLogs;
+	std::atomic_int m_threadLogCount = 0;
+	//! Hash table of all jobs seen, only updated if the audio thread gets hold of the mutex
+	std::vector<JobEntry> m_jobs;
+	std::size_t m_historyIndex = 0;
+	std::size_t m_period = 0; //!< periods collected since job profiling was enabled
+	mutable std::mutex m_jobsMutex;
+
+	std::atomic_bool m_midiLatencyMeasurement = false;
+	// only written by the audio thread, in nanoseconds
+	std::atomic_size_t m_midiLatencyNotes = 0;
+	std::atomic<std::int64_t> m_midiLatencySum = 0;
+	std::atomic<std::int64_t> m_midiLatencyMin = 0;
+	std::atomic<std::int64_t> m_midiLatencyMax = 0;
 
 	// Use arrays to avoid dynamic allocations in realtime code
 	std::array<MicroTimer, DetailCount> m_detailTimer;
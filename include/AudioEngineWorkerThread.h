@@ -28,6 +28,9 @@
 #include <QThread>
 
 #include <atomic>
+#include <vector>
+
+#include "WorkStealingQueue.h"
 
 class QWaitCondition;
 
@@ -41,78 +44,61 @@ class AudioEngineWorkerThread : public QThread
 {
 	Q_OBJECT
 public:
-	// internal representation of the job queue - all functions are thread-safe
-	class JobQueue
-	{
-	public:
-		enum class OperationMode
-		{
-			Static,	// no jobs added while processing queue
-			Dynamic	// jobs can be added while processing queue
-		} ;
-
-		static constexpr size_t JOB_QUEUE_SIZE = 8192;
-
-		JobQueue() :
-			m_items(),
-			m_writeIndex( 0 ),
-			m_itemsDone( 0 ),
-			m_opMode( OperationMode::Static )
-		{
-			std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
-		}
-
-		void reset( OperationMode _opMode );
-
-		void addJob( ThreadableJob * _job );
-
-		void run();
-		void wait();
-
-	private:
-		std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
-		std::atomic_size_t m_writeIndex;
-		std::atomic_size_t m_itemsDone;
-		OperationMode m_opMode;
-	} ;
-
+	//! Capacity of each worker's job queue
+	static constexpr size_t JOB_QUEUE_SIZE = 8192;
 
 	AudioEngineWorkerThread( AudioEngine* audioEngine );
 	~AudioEngineWorkerThread() override;
 
 	virtual void quit();
 
-	static void resetJobQueue( JobQueue::OperationMode _opMode =
-													JobQueue::OperationMode::Static )
-	{
-		globalJobQueue.reset( _opMode );
-	}
+	//! Add a job to the job graph of the current period. Jobs which don't
+	//! require processing are ignored. Not thread-safe, must not be called
+	//! while jobs are being processed.
+	static void addJob( ThreadableJob * _job );
 
-	static void addJob( ThreadableJob * _job )
-	{
-		globalJobQueue.addJob( _job );
-	}
+	//! Make @p job wait until @p dependency has been processed. Both jobs
+	//! must have been added to the graph before, otherwise this is a no-op.
+	static void addDependency( ThreadableJob * job, ThreadableJob * dependency );
 
 	// a convenient helper function allowing to pass a container with pointers
 	// to ThreadableJob objects
 	template<typename T>
-	static void fillJobQueue( const T & _vec,
-							JobQueue::OperationMode _opMode = JobQueue::OperationMode::Static )
+	static void addJobs( const T & _vec )
 	{
-		resetJobQueue( _opMode );
 		for (const auto& job : _vec)
 		{
 			addJob(job);
 		}
 	}
 
+	//! Process all jobs of the graph and return once every job is done.
+	//! Jobs without pending dependencies start right away, all others as
+	//! soon as their last dependency is done. Idle workers steal jobs from
+	//! the queues of busy workers.
 	static void startAndWaitForJobs();
 
 
 private:
 	void run() override;
 
-	static JobQueue globalJobQueue;
+	using Queue = WorkStealingQueue<ThreadableJob*>;
+
+	void processJobs();
+	void runJob( ThreadableJob * job );
+	void queueJob( ThreadableJob * job );
+	bool stealJob( ThreadableJob * & job, Queue AudioEngineWorkerThread::* queue );
+
+	// jobs which became ready on this worker - only this worker pushes and
+	// pops, every other worker may steal
+	Queue m_jobs;
+	// same for jobs which wait for work outside of the engine, see
+	// ThreadableJob::waitsExternally()
+	Queue m_waitingJobs;
+	int m_index;
+
+	static std::vector<ThreadableJob*> jobGraph;
+	static std::atomic_size_t jobsLeft;
 	static QWaitCondition * queueReadyWaitCond;
 	static QList<AudioEngineWorkerThread *> workerThreads;
 
@@ -26,6 +26,13 @@
 #ifndef LMMS_AUDIO_FILE_DEVICE_H
 #define LMMS_AUDIO_FILE_DEVICE_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
 #include <QFile>
 
 #include "AudioDevice.h"
@@ -34,6 +41,11 @@
 namespace lmms
 {
 
+template<class T>
+class LocklessRingBuffer;
+template<class T>
+class LocklessRingBufferReader;
+
 class AudioFileDevice : public AudioDevice
 {
 public:
@@ -52,9 +64,34 @@ public:
 	//! Write `size` sample frames from `buf` into the output file.
 	virtual void writeBuffer(const SampleFrame* buf, const f_cnt_t frames) = 0;
 
+	/**
+	 * @brief Encode on a thread of its own from now on, see @ref queueBuffer
+	 *
+	 * @param queueFrames number of frames which can be queued before @ref queueBuffer blocks
+	 */
+	void startEncoderThread(f_cnt_t queueFrames);
+
+	//! Queue @p frames for the encoder thread, or write them right away if it isn't running
+	void queueBuffer(const SampleFrame* buf, f_cnt_t frames);
+
+	/**
+	 * @brief Encode everything queued and stop the encoder thread
+	 *
+	 * Must be called before the device is destroyed, as the encoder thread
+	 * calls into the derived class.
+	 */
+	void finishEncoderThread();
+
 protected:
 	int writeData( const void* data, int len );
 
+	/**
+	 * @brief Convert @p frames to interleaved 16-bit PCM, dithered as set in the output settings
+	 *
+	 * The returned samples are valid until the next call.
+	 */
+	std::span<const int_sample_t> toS16(const SampleFrame* buf, f_cnt_t frames);
+
 	inline bool outputFileOpened() const
 	{
 		return m_outputFile.isOpen();
@@ -69,8 +106,24 @@ private:
 	void startProcessingImpl() override {}
 	void stopProcessingImpl() override {}
 
+	void encode();
+
 	QFile m_outputFile;
 	OutputSettings m_outputSettings;
+
+	// reused by toS16()
+	std::vector<int_sample_t> m_s16Buffer;
+	std::vector<float> m_ditherBuffer;
+	std::uint32_t m_ditherState = 0x9e3779b9;
+
+	std::unique_ptr<LocklessRingBuffer<SampleFrame>> m_queue;
+	std::unique_ptr<LocklessRingBufferReader<SampleFrame>> m_queueReader;
+	std::thread m_encoderThread;
+	std::atomic_bool m_encoderQuit = false;
+	//! Bumped on every write to the queue, so the encoder thread can wait for data
+	std::atomic<std::uint64_t> m_queueWrites = 0;
+	//! Bumped on every read from the queue, so a full queue can be waited on
+	std::atomic<std::uint64_t> m_queueReads = 0;
 } ;
 
 using AudioFileDeviceInstantiaton
@@ -27,6 +27,8 @@
 
 #include "lmmsconfig.h"
 
+#include <vector>
+
 #include "AudioFileDevice.h"
 #include <sndfile.h>
 
@@ -64,6 +66,7 @@ private:
 
 	SF_INFO  m_sfinfo;
 	SNDFILE* m_sf;
+	std::vector<float> m_floatBuffer; //!< reused by writeBuffer()
 
 	void writeBuffer(const SampleFrame* _ab, f_cnt_t const frames) override;
 
@@ -30,6 +30,8 @@
 
 #ifdef LMMS_HAVE_MP3LAME
 
+#include <vector>
+
 #include "AudioFileDevice.h"
 
 #include "lame/lame.h"
@@ -67,6 +69,7 @@ private:
 
 private:
 	lame_t m_lame;
+	std::vector<unsigned char> m_encodingBuffer; //!< reused by writeBuffer()
 };
 
 } // namespace lmms
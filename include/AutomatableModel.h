@@ -25,6 +25,7 @@
 #ifndef LMMS_AUTOMATABLE_MODEL_H
 #define LMMS_AUTOMATABLE_MODEL_H
 
+#include <atomic>
 #include <cmath>
 #include <QMap>
 #include <QMutex>
@@ -177,6 +178,15 @@ public:
 	//! @return pointer to model's valueBuffer when s.ex.data exists, NULL otherwise
 	ValueBuffer * valueBuffer();
 
+	/**
+	 * @brief Sets sample-exact values of the current period, as rendered by automation
+	 *
+	 * The values are scaled like in setValue() and passed on to the linked models.
+	 * valueBuffer() returns them for the rest of the period, frames before
+	 * @p offset keep the value of the last period.
+	 */
+	void setAutomatedValues(const float* values, f_cnt_t offset, f_cnt_t frames);
+
 	template<class T>
 	T initValue() const
 	{
@@ -412,7 +422,8 @@ private:
 
 
 	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
+	//! written last, so valueBuffer() can return the cached buffer without locking
+	std::atomic<long> m_lastUpdatedPeriod;
 	static long s_periodCounter;
 
 	bool m_hasSampleExactData;
@@ -68,6 +68,8 @@ public:
 	~AutomationClip() override = default;
 
 	bool addObject( AutomatableModel * _obj, bool _search_dup = true );
+	//! Disconnect @p obj, if it's connected
+	void removeObject(AutomatableModel* obj);
 
 	const AutomatableModel * firstObject() const;
 	const objectVector& objects() const;
@@ -169,6 +171,14 @@ public:
 	float valueAt( const TimePos & _time ) const;
 	float *valuesAfter( const TimePos & _time ) const;
 
+	/**
+	 * @brief Renders the curve sample by sample, like valueAt() at fractional times
+	 *
+	 * @param time position of the first value, in ticks relative to the clip
+	 * @param step ticks between two values
+	 */
+	void renderValues(float time, float step, float* values, std::size_t count) const;
+
 	QString name() const;
 
 	// settings-management
@@ -197,7 +207,7 @@ public:
 		return new AutomationClip(*this);
 	}
 
-	void clearObjects() { m_objects.clear(); }
+	void clearObjects();
 
 public slots:
 	void clear();
@@ -211,6 +221,8 @@ protected:
 
 private:
 	void cleanObjects();
+	//! Invalidate the AutomationTimeline if it depends on what changed
+	void updateTimeline();
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
 	float valueAt( timeMap::const_iterator v, int offset ) const;
@@ -247,6 +259,9 @@ private:
 	bool m_isRecording;
 	float m_lastRecordedValue;
 
+	// state of the clip the AutomationTimeline was last invalidated for
+	bool m_timelineHasAutomation = false;
+
 	static int s_quantization;
 
 	static const float DEFAULT_MIN_VALUE;
@@ -0,0 +1,160 @@
+/*
+ * AutomationTimeline.h - automation of a track container, compiled for playback
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUTOMATION_TIMELINE_H
+#define LMMS_AUTOMATION_TIMELINE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QHash>
+#include <QPointer>
+
+#include "TimePos.h"
+#include "TrackContainer.h"
+
+namespace lmms
+{
+
+class AutomatableModel;
+class AutomationClip;
+class PatternClip;
+
+/**
+	@brief The automation of a track container, compiled into a sorted list of segments per automated model
+
+	Finding the value of a model is a binary search at most, and usually just a
+	step of the model's playback cursor, so processing a tick neither depends on
+	the song's length nor allocates. After @ref invalidate was called, i.e. after
+	clips, tracks or their automated models were changed, @ref update compiles
+	the timeline again on the main thread, and the audio thread picks it up at
+	the start of the next period. Until then, the automated models keep their
+	values, since the old timeline may refer to deleted clips.
+
+	A model follows the clip which starts last at or before the current time,
+	just like TrackContainer::automatedValuesAt(). Between ticks, @ref render
+	passes the curves on to the models' value buffers sample by sample.
+*/
+class AutomationTimeline
+{
+public:
+	//! Sizes the buffer @ref render uses for the audio engine's period, so rendering never allocates
+	AutomationTimeline();
+
+	//! Mark all timelines outdated, to be called whenever automation or pattern clips change. Has the song
+	//! update its timeline on the main thread soon.
+	static void invalidate();
+
+	/**
+	 * @brief Compile the automation of @p container, unless that was done since the last change already
+	 *
+	 * Must not run concurrently with changes to the tracks, i.e. usually on the main thread. The result is
+	 * used from the start of the next period on.
+	 *
+	 * @param clipNum the pattern to play, like in PatternStore::automatedValuesAt(), or -1 for the song
+	 * @param globalAutomationTrack processed before the tracks of @p container, like in Song::automatedValuesAt()
+	 */
+	void update(const TrackContainer* container, int clipNum, Track* globalAutomationTrack = nullptr);
+
+	//! Apply the automation of @p container at @p time to the automated models, if it is compiled already
+	void process(const TrackContainer* container, TimePos time, int clipNum);
+
+	/**
+	 * @brief Render the automation of the last processed tick into the value buffers of the automated models
+	 *
+	 * @param tickOffset position of the first frame, in ticks after the processed tick
+	 * @param ticksPerFrame ticks between two frames
+	 * @param offset position of the first frame in the current period
+	 * @param frames number of frames to render, none of which may be in the next tick or the next period
+	 */
+	void render(float tickOffset, float ticksPerFrame, f_cnt_t offset, f_cnt_t frames);
+
+	//! Hand all models which are automated right now back to their controllers
+	void release();
+
+	//! Forget everything, without touching the models. Must not run concurrently with the audio thread.
+	void clear();
+
+private:
+	struct Segment
+	{
+		tick_t start;
+		AutomationClip* clip;
+		//! The pattern clip playing @ref clip, if it belongs to a pattern
+		const PatternClip* pattern;
+		int patternIndex;
+	};
+
+	struct Target
+	{
+		QPointer<AutomatableModel> model;
+		std::vector<Segment> segments; //!< sorted by start
+		std::size_t cursor = 0;
+		TimePos clipTime; //!< position in the clip of the current segment on the last tick
+		float value = 0.f; //!< unscaled value at @ref clipTime
+		bool active = false; //!< whether a clip set the model's value on the last tick
+		bool recording = false; //!< whether the model is recorded into on this tick
+		bool rendered = false; //!< whether @ref render passes the curve on to the model
+		bool held = false; //!< whether the value stays the same until the next tick, e.g. after the clip's end
+	};
+
+	//! Everything compiled by @ref update, only changed by the audio thread once it was handed over
+	struct Program
+	{
+		const TrackContainer* container;
+		int clipNum;
+		unsigned revision;
+		std::vector<Target> targets;
+		QHash<const AutomatableModel*, std::size_t> targetIndex; //!< position of each model in targets
+		//! Clips which may be recorded into
+		std::vector<AutomationClip*> recordableClips;
+	};
+
+	static constexpr auto NoSegment = static_cast<std::size_t>(-1);
+
+	//! Make @p program the current one on the audio thread and return the previous one
+	std::unique_ptr<Program> adopt(std::unique_ptr<Program> program);
+	static void addTrack(Program& program, Track* track, int clipNum);
+	static void addClip(Program& program, AutomationClip* clip, tick_t start, const PatternClip* pattern,
+		int patternIndex);
+	static std::size_t findSegment(Target& target, tick_t time);
+	static TimePos clipTime(const Segment& segment, TimePos time, bool& held);
+
+	//! The program used by the audio thread
+	std::unique_ptr<Program> m_program;
+	//! Whether the last tick was processed, so its automation can be rendered
+	bool m_processed = false;
+	std::vector<float> m_renderBuffer; //!< one period long
+
+	//! Key of the last program compiled by @ref update
+	const TrackContainer* m_compiledContainer = nullptr;
+	int m_compiledClipNum = -1;
+	unsigned m_compiledRevision = 0;
+
+	static std::atomic<unsigned> s_revision;
+	static std::atomic<bool> s_updateQueued;
+};
+
+} // namespace lmms
+
+#endif // LMMS_AUTOMATION_TIMELINE_H
@@ -26,6 +26,8 @@
 #ifndef LMMS_BUFFER_MANAGER_H
 #define LMMS_BUFFER_MANAGER_H
 
+#include <cstddef>
+
 #include "lmms_export.h"
 #include "LmmsTypes.h"
 
@@ -34,13 +36,33 @@ namespace lmms
 
 class SampleFrame;
 
+/**
+	@brief Pool of period-sized, cache-line aligned sample buffers
+
+	Buffers are taken from a lock-free free list, with a small cache per
+	thread in front of it, so @ref acquire and @ref release never lock or
+	allocate as long as the pool has free buffers. The pool is grown by a
+	background thread once it runs low. Only if it runs dry, a buffer is
+	allocated on the heap (counted as miss).
+*/
 class LMMS_EXPORT BufferManager
 {
 public:
+	struct Statistics
+	{
+		std::size_t capacity;      //!< number of buffers in the pool
+		std::size_t inUse;         //!< number of buffers acquired right now
+		std::size_t highWaterMark; //!< maximum of inUse so far
+		std::size_t misses;        //!< number of acquires the pool could not serve
+	};
+
+	//! Must be called before the first buffer is acquired
 	static void init( f_cnt_t fpp );
 	static SampleFrame* acquire();
 	static void release( SampleFrame* buf );
 
+	static Statistics statistics();
+
 private:
 	static f_cnt_t s_framesPerPeriod;
 };
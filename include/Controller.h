@@ -26,6 +26,8 @@
 #ifndef LMMS_CONTROLLER_H
 #define LMMS_CONTROLLER_H
 
+#include <atomic>
+
 #include "lmms_export.h"
 #include "Engine.h"
 #include "Model.h"
@@ -161,7 +163,8 @@ protected:
 
 	float m_currentValue;
 	bool  m_sampleExact;
-	int m_connectionCount;
+	//! read by triggerFrameCounter() on the audio thread
+	std::atomic<int> m_connectionCount;
 
 	QString m_name;
 	ControllerType m_type;
@@ -130,6 +130,16 @@ public:
 		return m_autoQuitEnabled;
 	}
 
+	/**
+	 * Number of frames the output of the effect lags behind its input, e.g.
+	 * because of lookahead. The mixer delays all parallel signals by the same
+	 * amount, so they stay in phase.
+	 */
+	virtual f_cnt_t latencyFrames() const
+	{
+		return 0;
+	}
+
 	EffectChain * effectChain() const
 	{
 		return m_parent;
@@ -29,6 +29,7 @@
 #include "Model.h"
 #include "SerializingObject.h"
 #include "AutomatableModel.h"
+#include "LmmsTypes.h"
 
 namespace lmms
 {
@@ -65,12 +66,20 @@ public:
 	void moveUp( Effect * _effect );
 	bool processAudioBuffer(AudioBuffer& buffer);
 
+	//! Sum of the latencies of all effects which process audio, see Effect::latencyFrames()
+	f_cnt_t latencyFrames() const;
+
 	void clear();
 
 
 private:
+	//! Hand a copy of m_effects to the audio thread, see AudioEngine::commitChange()
+	void publishEffects();
+
 	using EffectList = std::vector<Effect*>;
 	EffectList m_effects;
+	//! What the audio thread processes, only changed by publishEffects()
+	EffectList m_processedEffects;
 
 	BoolModel m_enabledModel;
 
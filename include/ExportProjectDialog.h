@@ -77,9 +77,15 @@ private:
 	QLabel* m_compressionLevelLabel = nullptr;
 	QComboBox* m_compressionLevelComboBox = nullptr;
 
+	QLabel* m_ditherLabel = nullptr;
+	QComboBox* m_ditherComboBox = nullptr;
+
 	QGroupBox* m_fileFormatSettingsGroupBox = nullptr;
 	QFormLayout* m_fileFormatSettingsLayout = nullptr;
 
+	QLabel* m_stemModeLabel = nullptr;
+	QComboBox* m_stemModeComboBox = nullptr;
+
 	QCheckBox* m_exportAsLoopBox = nullptr;
 	QCheckBox* m_exportBetweenLoopMarkersBox = nullptr;
 	QLabel* m_loopRepeatLabel = nullptr;
@@ -78,6 +78,16 @@ public:
 	// output buffer only once per audio engine period
 	virtual void play( SampleFrame* _working_buffer );
 
+	// instruments rendering in another process can return true here, so
+	// startPlay() is called once all notes of the period are processed and
+	// play() as late as possible, when no other job of the audio engine is
+	// ready - in the meantime the other process renders alongside the engine.
+	// play() then only collects what startPlay() started. Asked once per
+	// period on the audio thread, so it must not block.
+	virtual bool playsAsynchronously() const { return false; }
+
+	virtual void startPlay() {}
+
 	// to be implemented by actual plugin
 	virtual void playNote( NotePlayHandle * /* _note_to_play */,
 					SampleFrame* /* _working_buf */ )
@@ -64,6 +64,9 @@ public:
 
 	void processNote( NotePlayHandle* n );
 
+	//! Number of notes played for each note, including the note itself
+	int notesPerNote() const;
+
 
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 	void loadSettings( const QDomElement & _this ) override;
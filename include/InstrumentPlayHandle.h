@@ -26,6 +26,7 @@
 #define LMMS_INSTRUMENT_PLAY_HANDLE_H
 
 #include "PlayHandle.h"
+#include "ThreadableJob.h"
 #include "lmms_export.h"
 
 namespace lmms
@@ -50,8 +51,48 @@ public:
 
 	bool isFromTrack(const Track* track) const override;
 
+	//! Decide whether the instrument's output is collected by @ref finishJob in this period, see
+	//! Instrument::playsAsynchronously(). Called while the period's jobs are queued, play() sticks to it.
+	bool startPeriod();
+
+	//! The second half of an asynchronously playing instrument's period, calling Instrument::play().
+	//! If it's queued along with the play handle, the play handle only calls Instrument::startPlay().
+	ThreadableJob* finishJob()
+	{
+		return &m_finishJob;
+	}
+
 private:
+	class FinishJob : public ThreadableJob
+	{
+	public:
+		FinishJob(InstrumentPlayHandle* handle) :
+			m_handle(handle)
+		{
+		}
+
+		bool requiresProcessing() const override
+		{
+			return true;
+		}
+
+		bool waitsExternally() const override
+		{
+			return true;
+		}
+
+	private:
+		void doProcessing() override;
+
+		InstrumentPlayHandle* m_handle;
+	};
+
+	void processNotes();
+	void finishPlay(SampleFrame* working_buffer);
+
 	Instrument* m_instrument;
+	FinishJob m_finishJob;
+	bool m_playsAsynchronously = false;
 };
 
 } // namespace lmms
@@ -195,6 +195,9 @@ public:
 		return m_arpeggio.m_arpEnabledModel.value();
 	}
 
+	//! Estimate of how many notes this track plays at once at most
+	int maxPolyphony() const;
+
 	// simple helper for removing midiport-XML-node when loading presets
 	static void removeMidiPortNode( DataFile& dataFile );
 
@@ -0,0 +1,75 @@
+/*
+ * LatencyCompensator.h - delays a signal to line it up with slower signal paths
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_LATENCY_COMPENSATOR_H
+#define LMMS_LATENCY_COMPENSATOR_H
+
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+
+namespace lmms
+{
+
+/**
+	@brief Delays a stereo signal by a whole number of frames
+
+	Used by the mixer to compensate the latency of effects: every signal
+	going into a mixer channel is delayed to match the slowest one, so that
+	parallel paths stay in phase. See Mixer::compensateLatency().
+*/
+class LatencyCompensator
+{
+public:
+	//! Longest delay, longer latencies are only compensated partly
+	static constexpr auto MaxDelay = f_cnt_t{16384};
+
+	//! Allocates the buffer for #MaxDelay frames, so the delay can be changed on the audio thread
+	LatencyCompensator();
+
+	f_cnt_t delay() const { return m_delay; }
+
+	//! Changing the delay drops the signal delayed so far. Never allocates,
+	//! @p frames is limited to #MaxDelay.
+	void setDelay(f_cnt_t frames);
+
+	//! Whether delayed signal is still due to come out
+	bool hasSignal() const { return m_signalFrames > 0; }
+
+	/**
+		@brief Feed @p frames frames and read as many delayed ones
+		@param in Input frames, or nullptr for silence
+		@param out Output frames, may be the same as @p in
+	*/
+	void process(const SampleFrame* in, SampleFrame* out, f_cnt_t frames);
+
+private:
+	std::vector<SampleFrame> m_buffer;
+	f_cnt_t m_delay = 0;
+	f_cnt_t m_position = 0;
+	f_cnt_t m_signalFrames = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_LATENCY_COMPENSATOR_H
@@ -0,0 +1,175 @@
+/*
+ * LocklessFreeList.h - lock-free stack of free slots of a pool
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_LOCKLESS_FREE_LIST_H
+#define LMMS_LOCKLESS_FREE_LIST_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lmms
+{
+
+/**
+	@brief Lock-free stack of slot indices, used to keep track of the free slots of a pool
+
+	Slots are addressed by index, so the head of the stack fits into a single
+	atomic together with a tag which changes on every update, which protects
+	against the ABA problem without needing a double-width CAS.
+*/
+class LocklessFreeList
+{
+public:
+	static constexpr auto Empty = std::uint32_t{0xffffffff};
+
+	explicit LocklessFreeList(std::size_t capacity) :
+		m_next(std::make_unique<std::atomic<std::uint32_t>[]>(capacity))
+	{
+	}
+
+	//! Number of free slots, never less than the real number
+	std::size_t size() const
+	{
+		return m_size.load(std::memory_order_relaxed);
+	}
+
+	//! Prepare a chain of slots to be pushed at once with @ref pushChain
+	void link(std::uint32_t index, std::uint32_t next)
+	{
+		m_next[index].store(next, std::memory_order_relaxed);
+	}
+
+	//! Push the chain of @p count slots from @p first to @p last, see @ref link
+	void pushChain(std::uint32_t first, std::uint32_t last, std::size_t count)
+	{
+		// count first, so size() never drops below the real number
+		m_size.fetch_add(count, std::memory_order_relaxed);
+
+		auto head = m_head.load(std::memory_order_relaxed);
+		auto newHead = Head{};
+		do
+		{
+			m_next[last].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+			newHead = nextTag(head) | first;
+		}
+		while (!m_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	void push(std::uint32_t index)
+	{
+		pushChain(index, index, 1);
+	}
+
+	//! Returns @ref Empty if there is no free slot
+	std::uint32_t pop()
+	{
+		auto head = m_head.load(std::memory_order_acquire);
+		auto newHead = Head{};
+		do
+		{
+			const auto index = static_cast<std::uint32_t>(head);
+			if (index == Empty) { return Empty; }
+			newHead = nextTag(head) | m_next[index].load(std::memory_order_relaxed);
+		}
+		while (!m_head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire));
+
+		m_size.fetch_sub(1, std::memory_order_relaxed);
+		return static_cast<std::uint32_t>(head);
+	}
+
+private:
+	// index of the first free slot in the lower, tag in the upper 32 bits
+	using Head = std::uint64_t;
+
+	static Head nextTag(Head head)
+	{
+		return ((head >> 32) + 1) << 32;
+	}
+
+	std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+	std::atomic<Head> m_head = Head{Empty};
+	std::atomic_size_t m_size = 0;
+};
+
+
+
+
+/**
+	@brief A few free slots kept by one thread, in front of a shared LocklessFreeList
+
+	Meant to be used as `thread_local`, so most pops and pushes don't touch
+	memory shared with other threads. The slots are handed back to the list
+	once the cache overflows or its thread ends.
+*/
+template<std::size_t Size>
+class LocalFreeListCache
+{
+public:
+	~LocalFreeListCache()
+	{
+		if (m_list) { flush(m_size); }
+	}
+
+	std::uint32_t pop(LocklessFreeList& list)
+	{
+		m_list = &list;
+		return m_size > 0 ? m_indices[--m_size] : list.pop();
+	}
+
+	void push(LocklessFreeList& list, std::uint32_t index)
+	{
+		m_list = &list;
+		if (m_size == Size)
+		{
+			// hand the older half back in one go
+			flush(Size / 2);
+		}
+		m_indices[m_size++] = index;
+	}
+
+private:
+	//! Hand the @p count oldest slots back to the list
+	void flush(std::size_t count)
+	{
+		if (count == 0) { return; }
+		for (auto i = std::size_t{0}; i < count - 1; ++i)
+		{
+			m_list->link(m_indices[i], m_indices[i + 1]);
+		}
+		m_list->pushChain(m_indices[0], m_indices[count - 1], count);
+		std::copy(m_indices.begin() + count, m_indices.begin() + m_size, m_indices.begin());
+		m_size -= count;
+	}
+
+	LocklessFreeList* m_list = nullptr;
+	std::array<std::uint32_t, Size> m_indices;
+	std::size_t m_size = 0;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_LOCKLESS_FREE_LIST_H
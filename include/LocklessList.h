@@ -53,9 +53,11 @@ public:
 		delete m_allocator;
 	}
 
-	void push( T value )
+	//! @returns false if the list is full
+	bool push( T value )
 	{
 		Element * e = m_allocator->alloc();
+		if (!e) { return false; }
 		e->value = value;
 		e->next = m_first.load(std::memory_order_relaxed);
 
@@ -65,6 +67,7 @@ public:
 		{
 			// Empty loop (compare_exchange_weak updates e->next)
 		}
+		return true;
 	}
 
 	Element * popList()
@@ -137,6 +137,8 @@ protected:
 	std::size_t controlCount() const;
 	QString nodeName() const { return "lv2controls"; }
 	bool hasNoteInput() const;
+	//! Largest latency of all processors, in frames
+	f_cnt_t latencyFrames() const;
 	void handleMidiInputEvent(const class MidiEvent &event,
 		const class TimePos &time, f_cnt_t offset);
 
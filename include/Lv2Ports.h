@@ -119,6 +119,8 @@ struct Meta
 
 	bool m_optional = false;
 	bool m_used = true;
+	//! Control output reporting the plugin's latency in frames
+	bool m_reportsLatency = false;
 
 	std::vector<PluginIssue> get(const LilvPlugin* plugin, std::size_t portNum);
 
@@ -26,6 +26,9 @@
 #ifndef LMMS_MIDI_CLIP_H
 #define LMMS_MIDI_CLIP_H
 
+#include <atomic>
+#include <span>
+
 #include "Clip.h"
 #include "Note.h"
 
@@ -75,6 +78,17 @@ public:
 		return m_notes;
 	}
 
+	/**
+	 * @brief Returns the notes starting at @p time
+	 *
+	 * The notes are looked up from a playback cursor, which follows increasing
+	 * times in constant time and only searches again after jumps. Meant for
+	 * the audio thread, while the instrument track is locked.
+	 */
+	auto notesStartingAt(const TimePos& time) -> std::span<Note* const>;
+	//! Returns the notes starting before @p time and ending after it, valid until the next call
+	auto notesOverlapping(const TimePos& time) -> const NoteVector&;
+
 	Note * addStepNote( int step );
 	void setStep( int step, bool enabled );
 
@@ -151,10 +165,28 @@ private:
 
 	Type m_clipType;
 
+	//! Rebuild the note schedule on the next lookup, to be called while the instrument track is locked
+	void invalidateSchedule()
+	{
+		m_scheduleOutdated.store(true, std::memory_order_release);
+	}
+	void updateSchedule();
+
 	// data-stuff
 	NoteVector m_notes;
 	int m_steps;
 
+	//! The notes sorted by position, with positions and ends in arrays of their own, for playback
+	struct Schedule
+	{
+		std::vector<tick_t> positions;
+		std::vector<tick_t> ends;
+		NoteVector notes;
+		std::size_t cursor = 0; //!< first note at or after the last looked up time
+		NoteVector overlapping;
+	} m_schedule;
+	std::atomic_bool m_scheduleOutdated = true;
+
 	MidiClip * adjacentMidiClipByOffset(int offset) const;
 
 	friend class gui::MidiClipView;
@@ -84,6 +84,10 @@ public:
 			Mode mode = Mode::Disabled );
 	~MidiPort() override;
 
+	//! Stop receiving events and forget the queued ones, for event processors which start
+	//! destroying themselves before the port is destroyed. Also done by the destructor.
+	void unregister();
+
 	void setName( const QString& name );
 
 	Mode mode() const
@@ -111,7 +115,10 @@ public:
 		return outputChannel() ? outputChannel() - 1 : 0;
 	}
 
+	//! Called by the MIDI client when @p event arrives, which is then queued for the audio thread
 	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos() );
+	//! Pass an event queued by processInEvent() on to the event processor, starting @p offset frames into the period
+	void processQueuedInEvent(const MidiEvent& event, const TimePos& time, f_cnt_t offset);
 	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos() );
 
 
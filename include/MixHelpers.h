@@ -93,6 +93,13 @@ void multiplyAndAddMultiplied( SampleFrame* dst, const SampleFrame* src, float c
 /*! \brief Multiply dst by coeffDst and add samples from srcLeft/srcRight multiplied by coeffSrc */
 void multiplyAndAddMultipliedJoined( SampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
 
+/**
+ * @brief Convert interleaved samples to signed 16-bit integers, rounded and clipped
+ *
+ * @param dither noise in LSBs added to each sample before rounding, may be null
+ */
+void convertToS16(int_sample_t* dst, const sample_t* src, const float* dither, std::size_t samples);
+
 } // namespace MixHelpers
 
 
@@ -28,17 +28,20 @@
 #include "AudioBuffer.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
+#include "LatencyCompensator.h"
 #include "Model.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
 #include <optional>
+#include <vector>
 #include <QColor>
 
 namespace lmms
 {
 
 
+class AudioBusHandle;
 class MixerRoute;
 using MixerRouteVector = std::vector<MixerRoute*>;
 
@@ -62,7 +65,6 @@ public:
 	FloatModel m_volumeModel;
 	QString m_name;
 	QMutex m_lock;
-	bool m_queued; // are we queued up for rendering yet?
 	bool m_muted; // are we muted? updated per period so we don't have to call m_muteModel.value() twice
 
 	// pointers to other channels that this one sends to
@@ -71,6 +73,13 @@ public:
 	// pointers to other channels that send to this one
 	MixerRouteVector m_receives;
 
+	// latency of the slowest signal path into this channel, and of its own effects
+	f_cnt_t m_inputLatency = 0;
+	f_cnt_t m_latency = 0;
+
+	// if set, receives the output of every period, after effects and fader
+	SampleFrame* m_tap = nullptr;
+
 	int index() const { return m_channelIndex; }
 	void setIndex(int index) { m_channelIndex = index; }
 
@@ -84,10 +93,6 @@ public:
 	auto color() const -> const std::optional<QColor>& { return m_color; }
 	void setColor(const std::optional<QColor>& color) { m_color = color; }
 
-	std::atomic_size_t m_dependenciesMet;
-	void incrementDeps();
-	void processed();
-
 private:
 	void doProcessing() override;
 	int m_channelIndex;
@@ -128,10 +133,23 @@ public:
 
 	void updateName();
 
+	LatencyCompensator& latencyCompensator()
+	{
+		return m_latencyCompensator;
+	}
+
+	//! Where the sender's output is delayed to, if the route has latency compensation
+	SampleFrame* delayedBuffer()
+	{
+		return m_delayedBuffer.data();
+	}
+
 	private:
 		MixerChannel * m_from;
 		MixerChannel * m_to;
 		FloatModel m_amount;
+		LatencyCompensator m_latencyCompensator;
+		std::vector<SampleFrame> m_delayedBuffer;
 };
 
 
@@ -145,8 +163,19 @@ public:
 	void mixToChannel(const AudioBuffer& buffer, mix_ch_t dest);
 
 	void prepareMasterMix();
+	//! Delay all signals into each channel to the slowest one among them,
+	//! see Effect::latencyFrames()
+	void compensateLatency(const std::vector<AudioBusHandle*>& busHandles);
+	//! Add all channels to the job graph, each one depending on the channels sending to it
+	void addJobs();
 	void masterMix( SampleFrame* _buf );
 
+	//! How many frames the master output lags behind the song because of effect latency
+	f_cnt_t latencyFrames() const
+	{
+		return m_latency;
+	}
+
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 	void loadSettings( const QDomElement & _this ) override;
 
@@ -222,6 +251,8 @@ private:
 	void allocateChannelsTo(int num);
 
 	int m_lastSoloed;
+
+	std::atomic<f_cnt_t> m_latency = 0;
 } ;
 
 
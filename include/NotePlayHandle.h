@@ -26,6 +26,7 @@
 #ifndef LMMS_NOTE_PLAY_HANDLE_H
 #define LMMS_NOTE_PLAY_HANDLE_H
 
+#include <cstddef>
 #include <memory>
 
 #include "BasicFilters.h"
@@ -33,7 +34,6 @@
 #include "PlayHandle.h"
 #include "Track.h"
 
-class QReadWriteLock;
 
 namespace lmms
 {
@@ -333,9 +333,14 @@ private:
 } ;
 
 
-const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
+/**
+	@brief Pool of note play handles
 
+	Handles are recycled without locking, and every thread keeps a few of them
+	at hand, so notes can be created from the audio threads. The pool only
+	grows in @ref reserve, which is called before playback starts - should it
+	still run dry, single handles are allocated instead.
+*/
 class NotePlayHandleManager
 {
 public:
@@ -348,16 +353,16 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::Origin::MidiClip );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
-	static void free();
 
-private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
-};
+	//! Make sure at least @p count handles are available in total. Allocates,
+	//! so don't call this from the audio threads.
+	static void reserve( std::size_t count );
 
+	//! Number of handles which had to be allocated because the pool ran dry
+	static std::size_t misses();
+
+	static void free();
+};
 
 } // namespace lmms
 
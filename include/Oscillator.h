@@ -165,6 +165,16 @@ public:
 		return fastRandInc(-1.f, 1.f);
 	}
 
+	/**
+	 * @brief Fills @p buffer with a wave like the routines above would give it, e.g. for LFOs
+	 *
+	 * @param phase phase of the first sample
+	 * @param increment phase difference between two samples
+	 *
+	 * WhiteNoise and UserDefined are not supported, they depend on state and buffers.
+	 */
+	static void fillLfo(WaveShape shape, float* buffer, float phase, float increment, f_cnt_t frames);
+
 	static sample_t userWaveSample(const SampleBuffer* buffer, const float sample)
 	{
 		if (buffer == nullptr || buffer->size() == 0) { return 0; }
@@ -172,7 +182,7 @@ public:
 		const auto frame = absFraction(sample) * frames;
 		const auto f1 = static_cast<f_cnt_t>(frame);
 
-		return std::lerp(buffer->data()[f1][0], buffer->data()[(f1 + 1) % frames][0], fraction(frame));
+		return std::lerp(buffer->frame(f1).left(), buffer->frame((f1 + 1) % frames).left(), fraction(frame));
 	}
 
 	struct wtSampleControl {
@@ -313,6 +323,9 @@ private:
 	template<WaveShape W>
 	inline sample_t getSample( const float _sample );
 
+	template<WaveShape W>
+	static void fillLfo(float* buffer, float phase, float increment, f_cnt_t frames);
+
 	inline void recalcPhase();
 
 } ;
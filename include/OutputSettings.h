@@ -51,6 +51,14 @@ public:
 		Count
 	};
 
+	//! Noise added when reducing the bit depth to integer PCM
+	enum class Dither
+	{
+		None,
+		Triangular, //!< TPDF dither of +/- 1 LSB
+		Count
+	};
+
 public:
 	OutputSettings(sample_rate_t sampleRate, bitrate_t bitRate, BitDepth bitDepth, StereoMode stereoMode)
 		: m_sampleRate(sampleRate)
@@ -58,6 +66,7 @@ public:
 		, m_bitDepth(bitDepth)
 		, m_stereoMode(stereoMode)
 		, m_compressionLevel(0.625) // 5/8
+		, m_dither(Dither::None)
 	{
 	}
 
@@ -79,6 +88,9 @@ public:
 	void setStereoMode(StereoMode stereoMode) { m_stereoMode = stereoMode; }
 
 
+	Dither getDither() const { return m_dither; }
+	void setDither(Dither dither) { m_dither = dither; }
+
 	double getCompressionLevel() const{ return m_compressionLevel; }
 	void setCompressionLevel(double level){
 		// legal range is 0.0 to 1.0.
@@ -91,6 +103,7 @@ private:
 	BitDepth m_bitDepth;
 	StereoMode m_stereoMode;
 	double m_compressionLevel;
+	Dither m_dither;
 };
 
 
@@ -69,9 +69,14 @@ class PerfLogTimer
 	void begin();
 	void end();
 
+	/// Amount of audio processed so far, makes end() report how much faster
+	/// than realtime it was processed
+	void setAudioDuration(double seconds);
+
  private:
 	QString name;
 	PerfTime begin_time;
+	double audio_duration = 0;
 };
 
 
@@ -109,6 +109,10 @@ public:
 	virtual void play( SampleFrame* buffer ) = 0;
 	virtual bool isFinished() const = 0;
 
+	//! Called on the audio thread once the handle was unlinked by AudioEngine::removePlayHandle(), which
+	//! deletes it only later, so anything to be heard right away, like a note off, has to happen here
+	virtual void onRemoved() {}
+
 	// returns the frameoffset at the start of the playhandle,
 	// ie. how many empty frames should be inserted at the start of the first period
 	f_cnt_t offset() const
@@ -49,6 +49,7 @@ public:
 
 	void play( SampleFrame* buffer ) override;
 	bool isFinished() const override;
+	void onRemoved() override;
 
 	bool isFromTrack( const Track * _track ) const override;
 
@@ -60,6 +61,8 @@ public:
 
 
 private:
+	void stopPreviewNote();
+
 	static PreviewTrackContainer* s_previewTC;
 
 	NotePlayHandle* m_previewNote;
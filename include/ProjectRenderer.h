@@ -25,6 +25,9 @@
 #ifndef LMMS_PROJECT_RENDERER_H
 #define LMMS_PROJECT_RENDERER_H
 
+#include <memory>
+#include <vector>
+
 #include "AudioFileDevice.h"
 #include "AudioEngine.h"
 #include "OutputSettings.h"
@@ -34,6 +37,9 @@
 namespace lmms
 {
 
+class AudioBusHandle;
+class MixerChannel;
+
 
 class LMMS_EXPORT ProjectRenderer : public QThread
 {
@@ -67,6 +73,17 @@ public:
 		return m_fileDev != nullptr;
 	}
 
+	/**
+	 * @brief Also render the output of @p busHandle into @p outputFilename, in the same pass
+	 *
+	 * The stem is taken after the track's effects, before the mixer. All stems are encoded in parallel.
+	 * @returns false if the file could not be opened
+	 */
+	bool addStem(AudioBusHandle* busHandle, const QString& outputFilename);
+
+	//! Like @ref addStem(AudioBusHandle*, const QString&), for the output of @p channel after its effects and fader
+	bool addStem(MixerChannel* channel, const QString& outputFilename);
+
 	static ExportFileFormat getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -86,9 +103,31 @@ signals:
 
 
 private:
+	struct Stem
+	{
+		std::unique_ptr<AudioFileDevice> device;
+		AudioBusHandle* busHandle = nullptr;
+		MixerChannel* channel = nullptr;
+		std::vector<SampleFrame> tap; //!< written by the audio engine every period
+		std::vector<SampleFrame> block; //!< collected output, encoded in one go
+		std::size_t framesToSkip = 0;
+		std::size_t framesWritten = 0;
+	};
+
+	static AudioFileDevice* createFileDevice(
+		const OutputSettings& outputSettings, ExportFileFormat exportFileFormat, const QString& outputFilename);
+
 	void run() override;
 
+	void setStemTaps(bool enabled);
+	//! Append up to @p maxFrames of the current period to each stem's block, after skipping its latency
+	void collectStems(std::size_t maxFrames);
+	void writeStems();
+
 	AudioFileDevice * m_fileDev;
+	const OutputSettings m_outputSettings;
+	const ExportFileFormat m_exportFileFormat;
+	std::vector<Stem> m_stems;
 
 	volatile int m_progress;
 	volatile bool m_abort;
@@ -25,6 +25,10 @@
 #ifndef LMMS_REMOTE_PLUGIN_H
 #define LMMS_REMOTE_PLUGIN_H
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
 #include <QThread>
 #include <QProcess>
 #include <QRecursiveMutex>
@@ -98,10 +102,42 @@ public:
 
 	bool processMessage( const message & _m ) override;
 
+	//! Process one period and wait for the client, same as startProcess() followed by finishProcess().
+	//! Used by effects, which don't overlap with the rest of the engine yet.
 	bool process( const SampleFrame* _in_buf, SampleFrame* _out_buf );
 
+	/**
+	 * @brief Hand @p _in_buf to the client and let it start processing the current period
+	 *
+	 * Returns without waiting for the client, so the caller can go on with other
+	 * work while the plugin renders in its own process. Has to be followed by
+	 * finishProcess() in the same period, which may be called from another thread.
+	 * @return whether the client started processing
+	 */
+	bool startProcess( const SampleFrame* _in_buf );
+
+	/**
+	 * @brief Wait for the period started by startProcess() and copy the client's output to @p _out_buf
+	 *
+	 * The time spent waiting is recorded by the AudioEngineProfiler as a job of
+	 * type AudioEngineProfiler::JobType::RemotePlugin, identified by this plugin.
+	 * @return whether @p _out_buf was filled by the client
+	 */
+	bool finishProcess( SampleFrame* _out_buf );
+
 	void processMidiEvent( const MidiEvent&, const f_cnt_t _offset );
 
+	/**
+	 * @brief Send @p event to the client, which processes it before the next period
+	 *
+	 * Uses the shared @ref RemoteEventRing if the client supports it, or else the next message.
+	 * Can be called from any thread without waiting for the client.
+	 */
+	void sendEvent(const RemoteEvent& event);
+
+	//! Have the client process the events sent so far right away, e.g. before asking it for its state
+	void drainEvents();
+
 	void updateSampleRate( sample_rate_t _sr )
 	{
 		lock();
@@ -170,9 +206,22 @@ private:
 	SharedMemory<float[]> m_audioBuffer;
 	std::size_t m_audioBufferSize;
 
+	SharedMemory<RemoteEventRing> m_eventRing;
+	//! Whether the client attached to m_eventRing
+	bool m_eventRingReady;
+	//! Serializes the threads pushing to m_eventRing, which only supports one producer
+	std::mutex m_eventRingMutex;
+
 	int m_inputCount;
 	int m_outputCount;
 
+	//! Whether startProcess() was called and finishProcess() wasn't yet
+	bool m_processing;
+	//! Periods the client was asked to process and periods it reported done,
+	//! so replies of periods nobody waited for aren't mistaken for the current one
+	std::uint64_t m_periodsStarted;
+	std::atomic<std::uint64_t> m_periodsDone;
+
 #ifndef SYNC_WITH_SHM_FIFO
 	int m_server;
 	QString m_socketFile;
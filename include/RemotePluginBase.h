@@ -27,10 +27,12 @@
 
 #include <atomic>  // IWYU pragma: keep
 #include <vector>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <type_traits>
 
 #include "lmmsconfig.h"
 
@@ -344,10 +346,124 @@ enum RemoteMessageIDs
 	IdLoadPresetFile,
 	IdDebugMessage,
 	IdIdle,
+	IdProtocolVersion,
+	IdEvents,
+	IdEventRingKey,
+	IdDrainEvents,
 	IdUserBase = 64
 } ;
 
 
+/**
+ * Version of the binary parts of the protocol, see @ref RemoteEvent
+ *
+ * The host announces its version with IdProtocolVersion, which is answered by clients that know
+ * the message. Until then, and with older clients, only the text messages are used.
+ *
+ * 1. events are sent in batches with IdEvents
+ * 2. events are passed through a @ref RemoteEventRing, once the client answered IdEventRingKey
+ *
+ * Events which don't fit into the ring fall back to IdEvents, along with the ring's write position
+ * at the time, so the client processes the events pushed before them first.
+ */
+constexpr int RemoteProtocolVersion = 2;
+
+
+//! A MIDI event or parameter change, sent in batches with IdEvents
+struct RemoteEvent
+{
+	enum class Type : std::int32_t
+	{
+		Midi,
+		Parameter
+	};
+
+	Type type;
+	std::int32_t offset; //!< frames into the next processed period
+	union
+	{
+		struct
+		{
+			std::int32_t type;
+			std::int32_t channel;
+			std::int32_t param[2];
+		} midi;
+		struct
+		{
+			std::int32_t index;
+			float value;
+		} parameter;
+	};
+};
+
+static_assert(std::is_trivially_copyable_v<RemoteEvent>);
+
+
+/**
+ * Single-producer single-consumer queue of events in shared memory
+ *
+ * The host pushes events whenever they occur, the client drains them at the start of
+ * processing a period or on IdDrainEvents, so sending them neither needs a message nor a lock
+ * which is shared with the other process.
+ */
+struct RemoteEventRing
+{
+	static constexpr std::uint32_t Capacity = 1024; // a power of two, so the indices may wrap around
+
+	//! Only called by the host, @returns false if the ring is full
+	bool push(const RemoteEvent& event)
+	{
+		const auto write = std::atomic_ref{writeIndex}.load(std::memory_order_relaxed);
+		if (write - std::atomic_ref{readIndex}.load(std::memory_order_acquire) == Capacity) { return false; }
+
+		events[write % Capacity] = event;
+		std::atomic_ref{writeIndex}.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	//! Only called by the host
+	bool empty()
+	{
+		return std::atomic_ref{writeIndex}.load(std::memory_order_relaxed)
+			== std::atomic_ref{readIndex}.load(std::memory_order_relaxed);
+	}
+
+	//! Only called by the host, the position of the next event pushed
+	std::uint32_t writePosition()
+	{
+		return std::atomic_ref{writeIndex}.load(std::memory_order_relaxed);
+	}
+
+	//! Only called by the client, passes all events pushed so far on to @p process
+	template<class Process>
+	void drain(Process&& process)
+	{
+		drainUntil(std::atomic_ref{writeIndex}.load(std::memory_order_acquire), process);
+	}
+
+	//! Only called by the client, passes the events pushed before @ref writePosition() was @p position on to @p process
+	template<class Process>
+	void drainUntil(std::uint32_t position, Process&& process)
+	{
+		const auto read = std::atomic_ref{readIndex}.load(std::memory_order_relaxed);
+		const auto write = std::atomic_ref{writeIndex}.load(std::memory_order_acquire);
+		// the events before position may have been drained already
+		if (position - read > write - read) { return; }
+
+		for (auto index = read; index != position; ++index)
+		{
+			process(events[index % Capacity]);
+		}
+		std::atomic_ref{readIndex}.store(position, std::memory_order_release);
+	}
+
+	// only accessed through std::atomic_ref, as shared memory must hold trivial types
+	alignas(64) std::uint32_t writeIndex;
+	alignas(64) std::uint32_t readIndex;
+	RemoteEvent events[Capacity];
+};
+
+
 
 class LMMS_EXPORT RemotePluginBase
 {
@@ -385,12 +501,22 @@ public:
 
 		message & addFloat( float _f )
 		{
+			// enough digits to get the very same float back
 			char buf[32];
-			std::snprintf(buf, 32, "%f", _f);
+			std::snprintf(buf, 32, "%.9g", _f);
 			data.emplace_back( buf );
 			return *this;
 		}
 
+		//! Add @p count plain objects as a single binary item
+		template<class T>
+		message& addData(const T* items, std::size_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			data.emplace_back(reinterpret_cast<const char*>(items), count * sizeof(T));
+			return *this;
+		}
+
 		inline std::string getString( int _p = 0 ) const
 		{
 			return data[_p];
@@ -413,6 +539,15 @@ public:
 			return (float) atof( data[_p].c_str() );
 		}
 
+		//! Copy the objects added with addData() into @p items
+		template<class T>
+		void getData(int p, std::vector<T>& items) const
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			items.resize(data[p].size() / sizeof(T));
+			std::memcpy(items.data(), data[p].data(), items.size() * sizeof(T));
+		}
+
 		inline bool operator==( const message & _m ) const
 		{
 			return( id == _m.id );
@@ -444,9 +579,29 @@ public:
 	}
 #endif
 
+	//! Send the queued events, if there are any, and then @p _m
 	int sendMessage( const message & _m );
 	message receiveMessage();
 
+	/**
+	 * @brief Queue @p event, to be sent in a single IdEvents message with all others right before the next message
+	 *
+	 * Only to be used once the other side announced a @ref peerProtocolVersion() of at least 1.
+	 *
+	 * @param ringPosition @ref RemoteEventRing::writePosition() of the ring in use, if any, so the
+	 * events pushed to it before are processed first; only the first event of a message sets it
+	 */
+	void queueEvent(const RemoteEvent& event, std::uint32_t ringPosition = 0);
+
+	//! Whether events were queued which weren't sent yet
+	bool hasQueuedEvents();
+
+	//! @ref RemoteProtocolVersion of the other side, 0 if it did not announce one (yet)
+	int peerProtocolVersion() const
+	{
+		return m_peerProtocolVersion.load(std::memory_order_relaxed);
+	}
+
 	inline bool isInvalid() const
 	{
 #ifdef SYNC_WITH_SHM_FIFO
@@ -561,12 +716,26 @@ protected:
 	}
 
 
+	void setPeerProtocolVersion(int version)
+	{
+		m_peerProtocolVersion.store(version, std::memory_order_relaxed);
+	}
+
+
 #ifndef SYNC_WITH_SHM_FIFO
 	int m_socket;
 #endif
 
 
 private:
+	//! Write @p _m, the send lock must be held
+	int writeMessage(const message& _m);
+
+	std::vector<RemoteEvent> m_events;
+	//! Ring position sent along with m_events, see queueEvent()
+	std::uint32_t m_eventsRingPosition = 0;
+	std::atomic_int m_peerProtocolVersion;
+
 #ifndef BUILD_REMOTE_PLUGIN_CLIENT
 	static int & waitDepthCounter()
 	{
@@ -69,6 +69,10 @@ public:
 	{
 	}
 
+	virtual void processParameterChange(int /* index */, float /* value */, const f_cnt_t /* offset */)
+	{
+	}
+
 	virtual void updateSampleRate()
 	{
 	}
@@ -127,6 +131,8 @@ public:
 private:
 	void setShmKey(const std::string& key);
 	void doProcessing();
+	void processEvent(const RemoteEvent& event);
+	void drainEvents();
 
 	SharedMemory<float[]> m_audioBuffer;
 	SharedMemory<const VstSyncData> m_vstSyncData;
@@ -136,6 +142,9 @@ private:
 
 	sample_rate_t m_sampleRate;
 	f_cnt_t m_bufferSize;
+
+	std::vector<RemoteEvent> m_receivedEvents;
+	SharedMemory<RemoteEventRing> m_eventRing;
 } ;
 
 #ifndef LMMS_BUILD_WIN32
@@ -295,6 +304,42 @@ bool RemotePluginClient::processMessage( const message & _m )
 							_m.getInt( 4 ) );
 			break;
 
+		case IdEvents:
+			// these events didn't fit into the ring, so the ones pushed to it before come first
+			if (m_eventRing)
+			{
+				m_eventRing->drainUntil(static_cast<std::uint32_t>(_m.getInt(1)),
+					[this](const RemoteEvent& event) { processEvent(event); });
+			}
+			_m.getData(0, m_receivedEvents);
+			for (const auto& event : m_receivedEvents)
+			{
+				processEvent(event);
+			}
+			break;
+
+		case IdEventRingKey:
+			try
+			{
+				m_eventRing.attach(_m.getString(0));
+				reply = true;
+			}
+			catch (const std::runtime_error& error)
+			{
+				debugMessage(std::string{"Failed to attach event ring: "} + error.what() + '\n');
+			}
+			break;
+
+		case IdDrainEvents:
+			drainEvents();
+			break;
+
+		case IdProtocolVersion:
+			setPeerProtocolVersion(_m.getInt());
+			reply_message.addInt(RemoteProtocolVersion);
+			reply = true;
+			break;
+
 		case IdStartProcessing:
 			doProcessing();
 			reply_message.id = IdProcessingDone;
@@ -342,8 +387,38 @@ void RemotePluginClient::setShmKey(const std::string& key)
 
 
 
+void RemotePluginClient::processEvent(const RemoteEvent& event)
+{
+	switch (event.type)
+	{
+	case RemoteEvent::Type::Midi:
+		processMidiEvent(MidiEvent(static_cast<MidiEventTypes>(event.midi.type), event.midi.channel,
+			event.midi.param[0], event.midi.param[1]), event.offset);
+		break;
+	case RemoteEvent::Type::Parameter:
+		processParameterChange(event.parameter.index, event.parameter.value, event.offset);
+		break;
+	}
+}
+
+
+
+
+void RemotePluginClient::drainEvents()
+{
+	if (m_eventRing)
+	{
+		m_eventRing->drain([this](const RemoteEvent& event) { processEvent(event); });
+	}
+}
+
+
+
+
 void RemotePluginClient::doProcessing()
 {
+	drainEvents();
+
 	if (m_audioBuffer)
 	{
 		process( (SampleFrame*)( m_inputCount > 0 ? m_audioBuffer.get() : nullptr ),
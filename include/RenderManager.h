@@ -35,6 +35,8 @@
 namespace lmms
 {
 
+class MixerChannel;
+
 
 class RenderManager : public QObject
 {
@@ -50,6 +52,16 @@ public:
 	/// Export all unmuted tracks into individual file
 	void renderTracks();
 
+	enum class StemSource
+	{
+		Tracks, //!< one stem per unmuted track, taken before the mixer
+		MixerChannels //!< one stem per mixer channel, after its effects and fader
+	};
+
+	/// Export stems along with the full mix in a single pass, instead of one
+	/// pass per track like renderTracks()
+	void renderStems(StemSource source);
+
 	void abortProcessing();
 
 signals:
@@ -62,9 +74,12 @@ private slots:
 
 private:
 	QString pathForTrack( const Track *track, int num );
+	QString pathForChannel(const MixerChannel* channel);
 	void restoreMutedState();
 
 	void render( QString outputPath );
+	//! Start m_activeRenderer
+	void startRenderer();
 
 	const OutputSettings m_outputSettings;
 	ProjectRenderer::ExportFileFormat m_format;
@@ -80,6 +80,12 @@ public:
 	auto play(SampleFrame* dst, PlaybackState* state, size_t numFrames, Loop loopMode = Loop::Off,
 		double ratio = 1.0) const -> bool;
 
+	//! Have the frames played from @p frameIndex on read from disk soon, if the sample is streamed
+	void prefetch(int frameIndex, bool backwards = false) const;
+
+	//! Like prefetch(), for a clip which starts playing from @p frameIndex soon
+	void prefetchUpcoming(int frameIndex) const;
+
 	auto sampleDuration() const -> std::chrono::milliseconds;
 	auto sampleFile() const -> const QString& { return m_buffer->audioFile(); }
 	auto sampleRate() const -> int { return m_buffer->sampleRate(); }
@@ -87,7 +93,8 @@ public:
 
 	auto toBase64() const -> QString { return m_buffer->toBase64(); }
 
-	auto data() const -> const SampleFrame* { return m_buffer->data(); }
+	//! The stereo frame at @p index, see SampleBuffer::frame()
+	auto frame(size_t index) const -> SampleFrame { return m_buffer->frame(index); }
 	auto buffer() const -> std::shared_ptr<const SampleBuffer> { return m_buffer; }
 	auto startFrame() const -> int { return m_startFrame.load(std::memory_order_relaxed); }
 	auto endFrame() const -> int { return m_endFrame.load(std::memory_order_relaxed); }
@@ -108,6 +115,8 @@ public:
 
 private:
 	f_cnt_t render(SampleFrame* dst, f_cnt_t size, PlaybackState* state, Loop loop) const;
+	//! The buffer frame played at @p frameIndex, used for prefetching
+	auto bufferIndex(int frameIndex) const -> int;
 	std::shared_ptr<const SampleBuffer> m_buffer = SampleBuffer::emptyBuffer();
 	std::atomic<int> m_startFrame = 0;
 	std::atomic<int> m_endFrame = 0;
@@ -26,12 +26,14 @@
 #define LMMS_SAMPLE_BUFFER_H
 
 #include <QString>
+#include <iterator>
 #include <memory>
 #include <vector>
 
 #include "AudioEngine.h"
 #include "Engine.h"
 #include "LmmsTypes.h"
+#include "SampleStream.h"
 #include "lmms_export.h"
 
 namespace lmms {
@@ -39,19 +41,23 @@ class LMMS_EXPORT SampleBuffer
 {
 public:
 	using value_type = SampleFrame;
-	using reference = SampleFrame&;
+	using reference = const SampleFrame&;
 	using const_reference = const SampleFrame&;
-	using iterator = std::vector<SampleFrame>::iterator;
-	using const_iterator = std::vector<SampleFrame>::const_iterator;
-	using difference_type = std::vector<SampleFrame>::difference_type;
-	using size_type = std::vector<SampleFrame>::size_type;
-	using reverse_iterator = std::vector<SampleFrame>::reverse_iterator;
-	using const_reverse_iterator = std::vector<SampleFrame>::const_reverse_iterator;
+	using iterator = const SampleFrame*;
+	using const_iterator = const SampleFrame*;
+	using difference_type = std::ptrdiff_t;
+	using size_type = std::size_t;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
 	SampleBuffer() = default;
 	SampleBuffer(std::vector<SampleFrame> data, int sampleRate, const QString& audioFile = "");
 	SampleBuffer(
 		const SampleFrame* data, size_t numFrames, int sampleRate = Engine::audioEngine()->outputSampleRate());
+	SampleBuffer(std::shared_ptr<const SampleStream> stream, const QString& audioFile);
+	//! A buffer of a file which isn't stereo, see channelLevels()
+	SampleBuffer(std::vector<sample_t> samples, std::vector<SampleFrame> levels, int sampleRate,
+		const QString& audioFile = "");
 
 	friend void swap(SampleBuffer& first, SampleBuffer& second) noexcept;
 	auto toBase64() const -> QString;
@@ -59,36 +65,110 @@ public:
 	auto audioFile() const -> const QString& { return m_audioFile; }
 	auto sampleRate() const -> sample_rate_t { return m_sampleRate; }
 
-	auto begin() -> iterator { return m_data.begin(); }
-	auto end() -> iterator { return m_data.end(); }
-
-	auto begin() const -> const_iterator { return m_data.begin(); }
-	auto end() const -> const_iterator { return m_data.end(); }
-
-	auto cbegin() const -> const_iterator { return m_data.cbegin(); }
-	auto cend() const -> const_iterator { return m_data.cend(); }
-
-	auto rbegin() -> reverse_iterator { return m_data.rbegin(); }
-	auto rend() -> reverse_iterator { return m_data.rend(); }
-
-	auto rbegin() const -> const_reverse_iterator { return m_data.rbegin(); }
-	auto rend() const -> const_reverse_iterator { return m_data.rend(); }
-
-	auto crbegin() const -> const_reverse_iterator { return m_data.crbegin(); }
-	auto crend() const -> const_reverse_iterator { return m_data.crend(); }
-
-	auto data() const -> const SampleFrame* { return m_data.data(); }
-	auto size() const -> size_type { return m_data.size(); }
-	auto empty() const -> bool { return m_data.empty(); }
+	auto begin() const -> const_iterator { return data(); }
+	auto end() const -> const_iterator { return data() + size(); }
+
+	auto cbegin() const -> const_iterator { return begin(); }
+	auto cend() const -> const_iterator { return end(); }
+
+	auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+	auto rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+	auto crbegin() const -> const_reverse_iterator { return rbegin(); }
+	auto crend() const -> const_reverse_iterator { return rend(); }
+
+	//! The stereo frames, nullptr if the buffer keeps other channels, see frame()
+	auto data() const -> const SampleFrame* { return m_stream ? m_stream->data() : m_data.data(); }
+	auto size() const -> size_type
+	{
+		if (m_stream) { return m_stream->size(); }
+		return m_levels.empty() ? m_data.size() : m_samples.size() / m_levels.size();
+	}
+	auto empty() const -> bool { return size() == 0; }
+
+	//! Number of channels kept, samples of mono and multichannel files are only mixed to stereo by frame()
+	auto channels() const -> int { return m_levels.empty() ? DEFAULT_CHANNELS : static_cast<int>(m_levels.size()); }
+
+	//! The samples of all channels, interleaved
+	auto samples() const -> const sample_t*
+	{
+		return m_levels.empty() ? reinterpret_cast<const sample_t*>(data()) : m_samples.data();
+	}
+
+	//! Level of each channel in the left and right channel of frame(), empty if the buffer is stereo
+	auto channelLevels() const -> const std::vector<SampleFrame>& { return m_levels; }
+
+	//! The stereo frame at @p index, whatever the channels kept
+	auto frame(size_type index) const -> SampleFrame
+	{
+		if (m_levels.empty()) { return data()[index]; }
+
+		const auto channels = m_levels.size();
+		const auto samples = m_samples.data() + index * channels;
+		auto frame = SampleFrame{};
+		for (auto channel = std::size_t{0}; channel < channels; ++channel)
+		{
+			frame += m_levels[channel] * samples[channel];
+		}
+		return frame;
+	}
+
+	//! Whether the frames are read from disk while playing instead of being kept in memory, see fromFile()
+	auto isStreamed() const -> bool { return m_stream != nullptr; }
+
+	//! The stream the frames are read from if the buffer is streamed, whose SampleStream::Reader the audio thread uses
+	auto stream() const -> const SampleStream* { return m_stream.get(); }
+
+	//! Have the frames following @p frame read from disk soon if the buffer is streamed, see SampleStream
+	void prefetch(f_cnt_t frame, bool backwards = false) const
+	{
+		if (m_stream) { m_stream->prefetch(frame, backwards); }
+	}
+
+	//! Like prefetch(), for frames which start playing soon, see SampleStream::prefetchUpcoming()
+	void prefetchUpcoming(f_cnt_t frame, bool backwards = false) const
+	{
+		if (m_stream) { m_stream->prefetchUpcoming(frame, backwards); }
+	}
 
 	static auto emptyBuffer() -> std::shared_ptr<const SampleBuffer>;
 
+	/**
+	 * @brief Decode the audio file at @p path
+	 *
+	 * Samples which decode to more than the configured threshold ("app",
+	 * "samplestreamingthreshold" in MiB, 0 to never stream) are streamed
+	 * from a temporary file instead of being kept in memory. Files decoded
+	 * ahead by a SampleLoader aren't decoded again.
+	 */
 	static std::shared_ptr<const SampleBuffer> fromFile(const QString& path);
+
+	//! Like fromFile(), but returns nullptr on failure without reporting it, so it may run on any thread
+	static std::shared_ptr<const SampleBuffer> decodeFile(const QString& path);
+
+	/**
+	 * @brief Bytes of samples currently saved by sharing buffers
+	 *
+	 * Buffers are shared while they are in use: fromFile() returns the same
+	 * buffer for a file until the file is modified, and fromBase64() for the
+	 * same data and sample rate. Each buffer in use counts once for every
+	 * handle returned for it beyond the first one, as long as that handle
+	 * (or a copy of it) is kept. Copies don't count themselves.
+	 */
+	static auto sharedBytes() -> std::size_t;
+
+	//! Decoded size in MiB from which fromFile() streams samples by default
+	static constexpr auto DefaultStreamingThreshold = 256;
 	static std::shared_ptr<const SampleBuffer> fromBase64(
 		const QString& str, int sampleRate = Engine::audioEngine()->outputSampleRate());
 
 private:
 	std::vector<SampleFrame> m_data;
+	//! Replaces m_data for long samples
+	std::shared_ptr<const SampleStream> m_stream;
+	//! Replaces m_data for files which aren't stereo, with the level of each channel in m_levels
+	std::vector<sample_t> m_samples;
+	std::vector<SampleFrame> m_levels;
 	QString m_audioFile;
 	sample_rate_t m_sampleRate = Engine::audioEngine()->outputSampleRate();
 };
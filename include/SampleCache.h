@@ -0,0 +1,113 @@
+/*
+ * SampleCache.h - decoded samples kept on disk between sessions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_CACHE_H
+#define LMMS_SAMPLE_CACHE_H
+
+#include <QDateTime>
+#include <QString>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class SampleBuffer;
+class SampleStream;
+
+/**
+	@brief Decoded compressed samples, kept on disk so they don't have to be decoded again
+
+	There is one file per decoded audio file, named after the audio file's
+	path, size and modification time, so a changed audio file never matches
+	an old entry. The file holds the frames just like they are in memory,
+	behind a small header, so loading a cached sample means mapping the
+	file, and LMMS instances playing the same sample share its pages. Short
+	samples are read into memory instead, so playing them never waits for the
+	disk, and so are mono and multichannel samples, which keep their channels
+	like in memory, see SampleBuffer::channels().
+
+	Only compressed formats are cached, uncompressed ones decode about as fast
+	as they are read. The cache is enabled by "app"/"samplecache" and limited
+	to "app"/"samplecachesize" MiB, dropping the entries used longest ago.
+*/
+class LMMS_EXPORT SampleCache
+{
+public:
+	//! Size limit in MiB if none is configured
+	static constexpr auto DefaultSize = 4096;
+
+	//! Frames found in the cache, either mapped or read into memory
+	struct Frames
+	{
+		std::shared_ptr<const SampleStream> stream;
+		std::vector<SampleFrame> data; //!< empty if @ref stream is set or the sample isn't stereo
+		int sampleRate = 0;
+		std::vector<sample_t> samples; //!< samples of mono and multichannel samples, see @ref levels
+		std::vector<SampleFrame> levels; //!< see SampleBuffer::channelLevels()
+	};
+
+	//! Size limit in MiB, as configured
+	static qint64 sizeLimit();
+
+	//! Whether samples decoded from @p audioFile are cached, which depends on its format and the settings
+	static bool isCached(const QString& audioFile);
+
+	/**
+	 * @brief The cached frames of @p audioFile, if there are any
+	 *
+	 * @param mapThreshold size in bytes from which the frames are mapped instead of read into memory,
+	 *   like the streaming threshold of SampleBuffer::fromFile()
+	 */
+	static auto find(const QString& audioFile, std::size_t mapThreshold) -> std::optional<Frames>;
+
+	//! Add @p buffer, decoded from @p audioFile, to the cache
+	static void store(const QString& audioFile, const SampleBuffer& buffer);
+
+	//! Decode @p audioFile straight into the cache, a block at a time, and map it
+	static auto decode(const QString& audioFile) -> std::shared_ptr<const SampleStream>;
+
+	//! The directory holding the cache
+	static QString directory();
+
+private:
+	struct SampleCacheEntry
+	{
+		QString filePath;
+		qint64 size;
+		QDateTime lastModified;
+
+		explicit SampleCacheEntry(const QString& audioFile);
+		QString fileName() const;
+	};
+
+	//! Count @p addedBytes to the cache's size, and if it gets too large, drop the entries used longest ago
+	static void trim(qint64 addedBytes);
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_CACHE_H
@@ -30,16 +30,24 @@
 #include <string>
 #include <vector>
 
+#include "LmmsTypes.h"
 #include "SampleFrame.h"
 
+class QIODevice;
+
 namespace lmms {
 class SampleDecoder
 {
 public:
 	struct Result
 	{
+		//! Frames of stereo files, empty for other files
 		std::vector<SampleFrame> data;
 		int sampleRate;
+		//! Samples of mono and multichannel files, interleaved like in the file
+		std::vector<sample_t> samples = {};
+		//! Level of each channel of @ref samples in the left and right channel, see SampleBuffer::frame()
+		std::vector<SampleFrame> levels = {};
 	};
 
 	struct AudioType
@@ -48,7 +56,40 @@ public:
 		std::string extension;
 	};
 
+	//! The libraries decode() tries in this order, the first one which reads a file decodes it
+	enum class Library
+	{
+		SndFile,
+		OggVorbis, //!< only if LMMS is built with it
+		DrumSynth
+	};
+
+	/**
+	 * @brief Decode @p audioFile into memory in one pass
+	 *
+	 * Stereo files are decoded into frames, other files keep their channels
+	 * and are only mixed to stereo while they are played, so mono samples
+	 * take half the memory and surround samples don't lose any channels.
+	 */
 	static auto decode(const QString& audioFile) -> std::optional<Result>;
+
+	//! Decode @p audioFile with @p library only, e.g. to check a library which another one comes before
+	static auto decode(const QString& audioFile, Library library) -> std::optional<Result>;
+
+	/**
+	 * @brief Decode @p audioFile into @p output, a block of frames at a time
+	 *
+	 * Unlike decode(), this never holds the whole sample in memory, so it also
+	 * works for files which decode to more than the available memory. The
+	 * frames are written from the current position of @p output on, mixed
+	 * to stereo.
+	 * @return the sample rate, or nothing if decoding or writing failed
+	 */
+	static auto decode(const QString& audioFile, QIODevice& output) -> std::optional<int>;
+
+	//! Number of frames @p audioFile decodes to, if the file tells without being decoded
+	static auto frameCount(const QString& audioFile) -> std::optional<f_cnt_t>;
+
 	static auto supportedAudioTypes() -> const std::vector<AudioType>&;
 };
 } // namespace lmms
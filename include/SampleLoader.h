@@ -0,0 +1,83 @@
+/*
+ * SampleLoader.h - decodes the samples of a project while it is loaded
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_LOADER_H
+#define LMMS_SAMPLE_LOADER_H
+
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <future>
+#include <memory>
+
+#include "lmms_export.h"
+
+class QDomElement;
+
+namespace lmms
+{
+
+class SampleBuffer;
+
+/**
+	@brief Decodes the samples of a project concurrently while the project is loaded
+
+	Created from the project's DOM before its settings are loaded, the loader
+	collects the audio files of sample clips and sample based instruments and
+	decodes them on ThreadPool::instance(). While it exists,
+	SampleBuffer::fromFile() hands out these buffers on the thread which
+	created the loader instead of decoding the files again, waiting for them if
+	they aren't done yet. Files the loader failed on are decoded like before, so
+	errors are still reported where the sample is loaded.
+*/
+class LMMS_EXPORT SampleLoader
+{
+public:
+	explicit SampleLoader(const QDomElement& content);
+	//! Waits for the files which are being decoded and skips the others
+	~SampleLoader();
+
+	SampleLoader(const SampleLoader&) = delete;
+	SampleLoader& operator=(const SampleLoader&) = delete;
+
+	//! The buffer decoded from @p audioFile by the current loader, or nullptr if there is none
+	static auto find(const QString& audioFile) -> std::shared_ptr<const SampleBuffer>;
+
+	//! Number of files the current loader decoded so far
+	static int decodedCount();
+	//! Number of files the current loader decodes, 0 without a loader
+	static int fileCount();
+
+private:
+	//! Decoded buffers by absolute path
+	QHash<QString, std::shared_future<std::shared_ptr<const SampleBuffer>>> m_buffers;
+	std::atomic<int> m_decoded = 0;
+	std::atomic<bool> m_done = false;
+	SampleLoader* m_previous;
+
+	//! The loader of the thread, so other threads never wait for it
+	static thread_local SampleLoader* s_current;
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_LOADER_H
@@ -0,0 +1,185 @@
+/*
+ * SampleStream.h - decoded sample kept on disk instead of in memory
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_STREAM_H
+#define LMMS_SAMPLE_STREAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+
+class QFile;
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	@brief The decoded frames of a long sample, kept in a temporary file instead of memory
+
+	The file is decoded a block at a time and then mapped into memory, so
+	the system only keeps the parts of it in RAM which were read lately, no
+	matter how long the sample is. The audio thread doesn't read the mapping,
+	as that may wait for the disk: a background thread copies the blocks
+	following the positions passed to @ref prefetch and @ref prefetchUpcoming,
+	which is what Sample::play() and SampleTrack::play() do, into a fixed
+	amount of memory, which a @ref Reader reads from. Frames which weren't
+	copied in time, e.g. right after jumping to another position, are silent.
+*/
+class LMMS_EXPORT SampleStream
+{
+public:
+	//! Seconds of audio read ahead of each position passed to @ref prefetch
+	static constexpr auto PrefetchSeconds = 10;
+
+	//! Frames copied for the audio thread at once
+	static constexpr auto BlockFrames = std::size_t{16384};
+
+	//! Blocks kept in memory per stream, about 95 seconds of 44.1 kHz audio
+	static constexpr auto MaxLoadedBlocks = std::size_t{256};
+
+	/**
+	 * @brief Reads the frames copied for the audio thread, and silence for the others
+	 *
+	 * Real-time safe. Blocks aren't replaced while a reader exists, so it should
+	 * only be kept while rendering a period.
+	 */
+	class LMMS_EXPORT Reader
+	{
+	public:
+		explicit Reader(const SampleStream& stream);
+		~Reader();
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		auto frame(std::size_t index) const -> SampleFrame
+		{
+			const auto slot = m_stream.m_blockSlots[index / BlockFrames].load(std::memory_order_acquire);
+			return slot == NoSlot ? SampleFrame{} : m_stream.m_loaded[slot * BlockFrames + index % BlockFrames];
+		}
+
+	private:
+		const SampleStream& m_stream;
+		unsigned m_epoch; //!< which of SampleStream::m_readers counts this reader
+	};
+
+	//! Decode @p audioFile into a temporary file in SampleCache::directory(), or return nullptr if that fails
+	static auto decode(const QString& audioFile) -> std::shared_ptr<const SampleStream>;
+
+	/**
+	 * @brief Map @p size decoded frames stored at @p offset in @p file, which must be open
+	 *
+	 * Used for files which outlive the stream, see SampleCache.
+	 * @return the stream, or nullptr if the file couldn't be mapped
+	 */
+	static auto map(std::unique_ptr<QFile> file, qint64 offset, std::size_t size, int sampleRate)
+		-> std::shared_ptr<const SampleStream>;
+
+	~SampleStream();
+
+	SampleStream(const SampleStream&) = delete;
+	SampleStream& operator=(const SampleStream&) = delete;
+
+	//! All frames, read from disk when needed, so not to be used on the audio thread, see @ref Reader
+	auto data() const -> const SampleFrame* { return m_data; }
+	auto size() const -> std::size_t { return m_size; }
+	auto sampleRate() const -> int { return m_sampleRate; }
+
+	/**
+	 * @brief Have the frames following @p frame copied for the audio thread soon
+	 *
+	 * Real-time safe, the copying is left to a background thread.
+	 * @param backwards whether the frames before @p frame are played next instead
+	 */
+	void prefetch(f_cnt_t frame, bool backwards = false) const;
+
+	/**
+	 * @brief Like @ref prefetch, for a clip which starts playing at @p frame soon
+	 *
+	 * Kept apart from the positions being played, which are passed every
+	 * period and would replace it before the background thread gets to it.
+	 */
+	void prefetchUpcoming(f_cnt_t frame, bool backwards = false) const;
+
+private:
+	class Prefetcher;
+
+	//! Positions prefetched at once, e.g. for several clips playing the same sample
+	static constexpr auto MaxRequests = std::size_t{4};
+
+	//! Upcoming positions kept until they are read ahead of, e.g. for a recording split into many clips
+	static constexpr auto MaxUpcomingRequests = std::size_t{16};
+
+	//! Marks blocks which aren't in memory
+	static constexpr auto NoSlot = std::uint32_t(-1);
+
+	//! What the background thread knows about a slot of #m_loaded
+	struct Slot
+	{
+		std::size_t block;
+		//! Number of the last readAhead() call which wanted the block, 0 if the slot is free
+		std::uint64_t wanted = 0;
+	};
+
+	SampleStream() = default;
+
+	//! Copy the blocks following the requested positions into memory, nearest first
+	void readAhead() const;
+	//! Copy @p block into memory unless it is already, returns false if no slot is left
+	bool load(std::size_t block) const;
+
+	std::unique_ptr<QFile> m_file;
+	const SampleFrame* m_data = nullptr;
+	std::size_t m_size = 0;
+	int m_sampleRate = 0;
+
+	//! Positions passed to @ref prefetch plus one, so zero means none, negated for backwards playback
+	mutable std::array<std::atomic<std::int64_t>, MaxRequests> m_requests = {};
+	mutable std::atomic<unsigned> m_nextRequest = 0;
+
+	//! Positions passed to @ref prefetchUpcoming, stored like #m_requests
+	mutable std::array<std::atomic<std::int64_t>, MaxUpcomingRequests> m_upcomingRequests = {};
+
+	//! The slot of #m_loaded each block is copied to, or NoSlot
+	std::unique_ptr<std::atomic<std::uint32_t>[]> m_blockSlots;
+	//! Blocks copied for the audio thread, BlockFrames per slot
+	mutable std::vector<SampleFrame> m_loaded;
+	//! Only used by the background thread
+	mutable std::vector<Slot> m_slots;
+	mutable std::uint64_t m_readAheads = 0;
+	//! Number of @ref Reader objects created in even and odd epochs. Replacing a block starts
+	//! a new epoch and waits for the readers of the last one, which new readers don't delay.
+	mutable std::array<std::atomic<int>, 2> m_readers = {};
+	mutable std::atomic<unsigned> m_readEpoch = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_STREAM_H
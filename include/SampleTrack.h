@@ -25,6 +25,9 @@
 #ifndef LMMS_SAMPLE_TRACK_H
 #define LMMS_SAMPLE_TRACK_H
 
+#include <atomic>
+#include <QPointer>
+
 #include "AudioBusHandle.h"
 #include "Track.h"
 
@@ -32,6 +35,8 @@
 namespace lmms
 {
 
+class SampleClip;
+
 namespace gui
 {
 
@@ -97,6 +102,13 @@ private:
 	IntModel m_mixerChannelModel;
 	AudioBusHandle m_audioBusHandle;
 	bool m_isPlaying;
+	//! clips set playing by play(), so it can stop them without looking at all clips. Only
+	//! touched by play(), other threads ask for it to be cleared through m_resetPlayingClips
+	std::vector<QPointer<SampleClip>> m_playingClips;
+	std::atomic<bool> m_resetPlayingClips = false;
+	//! where play() last looked for clips to prefetch, and when it looks again
+	TimePos m_prefetchStart = -1;
+	TimePos m_nextPrefetch = -1;
 
 
 
@@ -105,10 +105,12 @@ private slots:
 	void updateBufferSizeWarning(int value);
 	void setBufferSize(int value);
 	void resetBufferSize();
+	void toggleJobProfiling(bool enabled);
 
 	// MIDI settings widget.
 	void midiInterfaceChanged(const QString & driver);
 	void toggleMidiAutoQuantization(bool enabled);
+	void toggleMidiLatencyMeasurement(bool enabled);
 
 	// Paths settings widget.
 	void openWorkingDir();
@@ -173,6 +175,8 @@ private:
 	QCheckBox * m_vstAlwaysOnTopCheckBox;
 	bool m_vstAlwaysOnTop;
 	bool m_disableAutoQuit;
+	int m_sampleStreamingThreshold;
+	bool m_sampleCache;
 
 	using AswMap = QMap<QString, AudioDeviceSetupWidget*>;
 	using MswMap = QMap<QString, MidiSetupWidget*>;
@@ -189,6 +193,9 @@ private:
 	QLabel * m_bufferSizeWarnLbl;
 	int m_sampleRate;
 	QSlider* m_sampleRateSlider;
+	int m_renderAheadPeriods;
+	QSlider* m_renderAheadSlider;
+	bool m_profileJobs;
 
 	// MIDI settings widgets.
 	QComboBox * m_midiInterfaces;
@@ -196,6 +203,7 @@ private:
 	trMap m_midiIfaceNames;
 	QComboBox * m_assignableMidiDevices;
 	bool m_midiAutoQuantize;
+	bool m_measureMidiLatency;
 
 	// Paths settings widgets.
 	QString m_workingDir;
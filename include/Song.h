@@ -32,6 +32,7 @@
 #include <QHash>  // IWYU pragma: keep
 
 #include "AudioEngine.h"
+#include "AutomationTimeline.h"
 #include "Controller.h"
 #include "Metronome.h"
 #include "lmms_constants.h"
@@ -326,6 +327,9 @@ public:
 
 	Metronome& metronome() { return m_metronome; }
 
+	//! Compile the automation for the current play mode, if it changed, see AutomationTimeline::update()
+	void updateAutomationTimeline();
+
 public slots:
 	void playSong();
 	void record();
@@ -455,7 +459,7 @@ private:
 	std::shared_ptr<Scale> m_scales[MaxScaleCount];
 	std::shared_ptr<Keymap> m_keymaps[MaxKeymapCount];
 
-	AutomatedValueMap m_oldAutomatedValues;
+	AutomationTimeline m_automationTimeline;
 
 	Metronome m_metronome;
 
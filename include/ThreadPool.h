@@ -57,10 +57,12 @@ public:
 			if constexpr (!std::is_same_v<ReturnType, void>)
 			{
 				promise->set_value(std::apply(fn, args));
-				return;
 			}
-			std::apply(fn, args);
-			promise->set_value();
+			else
+			{
+				std::apply(fn, args);
+				promise->set_value();
+			}
 		};
 
 		{
@@ -28,6 +28,7 @@
 #include "LmmsTypes.h"
 
 #include <atomic>
+#include <vector>
 
 namespace lmms
 {
@@ -81,11 +82,34 @@ public:
 
 	virtual bool requiresProcessing() const = 0;
 
+	//! Whether the job mostly waits for work done outside of the audio engine,
+	//! e.g. by another process. Such jobs are only picked up by workers which
+	//! find no other job ready, so the outside work overlaps with the engine's.
+	virtual bool waitsExternally() const
+	{
+		return false;
+	}
+
+	//! Jobs which may only be started after this one is done.
+	//! Maintained by AudioEngineWorkerThread while building the job graph.
+	const std::vector<ThreadableJob*>& dependents() const
+	{
+		return m_dependents;
+	}
+
 
 protected:
 	virtual void doProcessing() = 0;
 
 	std::atomic<ProcessingState> m_state;
+
+private:
+	// the vector is only cleared between periods, so its capacity is kept
+	// and no allocations happen once the graph has settled
+	std::vector<ThreadableJob*> m_dependents;
+	std::atomic_int m_pendingDependencies = 0;
+
+	friend class AudioEngineWorkerThread;
 } ;
 
 } // namespace lmms
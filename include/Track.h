@@ -25,6 +25,7 @@
 #ifndef LMMS_TRACK_H
 #define LMMS_TRACK_H
 
+#include <atomic>
 #include <vector>
 
 #include <QColor>
@@ -134,6 +135,22 @@ public:
 	}
 	void getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end );
+
+	/**
+	 * @brief Returns the clips overlapping @p time to @p time + @p length, sorted by position
+	 *
+	 * Like getClipsInRange(), but looks the clips up in an index sorted by position,
+	 * starting from where the last call left off. Meant for playback, where
+	 * it is called with slowly increasing times from the audio thread only.
+	 * The returned vector is valid until the next call.
+	 */
+	auto clipsAt(const TimePos& time, const TimePos& length) -> const clipVector&;
+	//! Mark the index of clipsAt() outdated, to be called whenever a clip was moved or resized
+	void invalidateClipIndex()
+	{
+		m_clipIndexOutdated.store(true, std::memory_order_release);
+	}
+
 	void swapPositionOfClips( int clipNum1, int clipNum2 );
 
 	void createClipsForPattern(int pattern);
@@ -226,6 +243,14 @@ private:
 
 	clipVector m_clips;
 
+	//! m_clips sorted by position, for clipsAt()
+	clipVector m_clipIndex;
+	tick_t m_maxClipLength = 0;
+	//! first clip of m_clipIndex which may reach the time of the last clipsAt() call
+	std::size_t m_clipCursor = 0;
+	clipVector m_clipsAt;
+	std::atomic_bool m_clipIndexOutdated = true;
+
 	QMutex m_processingLock;
 	
 	std::optional<QColor> m_color;
@@ -0,0 +1,146 @@
+/*
+ * WorkStealingQueue.h - bounded lock-free work-stealing deque
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_WORK_STEALING_QUEUE_H
+#define LMMS_WORK_STEALING_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "Hardware.h"
+
+namespace lmms
+{
+
+/**
+	@brief Bounded lock-free work-stealing deque (Chase-Lev)
+
+	The owning thread pushes and pops items at the bottom of the deque, while
+	any other thread may steal items from the top. No operation allocates or
+	blocks, so the queue can be used from realtime threads.
+
+	The capacity is fixed at construction and rounded up to a power of two.
+	@ref push returns false instead of growing when the queue is full.
+
+	@see "Correct and Efficient Work-Stealing for Weak Memory Models",
+	     Lê, Pop, Cohen, Zappa Nardelli (PPoPP 2013)
+*/
+template<typename T>
+class WorkStealingQueue
+{
+	static_assert(std::is_trivially_copyable_v<T>, "WorkStealingQueue requires trivially copyable items");
+
+public:
+	explicit WorkStealingQueue(std::size_t capacity) :
+		m_capacity(std::bit_ceil(capacity)),
+		m_mask(m_capacity - 1),
+		m_items(std::make_unique<std::atomic<T>[]>(m_capacity))
+	{
+	}
+
+	WorkStealingQueue(const WorkStealingQueue&) = delete;
+	WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+	std::size_t capacity() const { return m_capacity; }
+
+	//! Approximate number of items, only exact if no other thread accesses the queue
+	std::size_t size() const
+	{
+		const auto bottom = m_bottom.load(std::memory_order_relaxed);
+		const auto top = m_top.load(std::memory_order_relaxed);
+		return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+	}
+
+	bool empty() const { return size() == 0; }
+
+	//! Add an item at the bottom. Must only be called by the owning thread.
+	bool push(T item)
+	{
+		const auto bottom = m_bottom.load(std::memory_order_relaxed);
+		const auto top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<std::int64_t>(m_capacity)) { return false; }
+
+		m_items[bottom & m_mask].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	//! Remove an item from the bottom. Must only be called by the owning thread.
+	bool pop(T& item)
+	{
+		const auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// queue was empty
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = m_items[bottom & m_mask].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// last item - race against thieves
+			const bool won = m_top.compare_exchange_strong(top, top + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	//! Remove an item from the top. May be called by any thread.
+	bool steal(T& item)
+	{
+		auto top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto bottom = m_bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom) { return false; }
+
+		item = m_items[top & m_mask].load(std::memory_order_relaxed);
+		return m_top.compare_exchange_strong(top, top + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+private:
+	const std::size_t m_capacity;
+	const std::size_t m_mask;
+	std::unique_ptr<std::atomic<T>[]> m_items;
+
+	// top is written by thieves, bottom only by the owner - keep them apart
+	alignas(hardware_destructive_interference_size) std::atomic<std::int64_t> m_top{0};
+	alignas(hardware_destructive_interference_size) std::atomic<std::int64_t> m_bottom{0};
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_WORK_STEALING_QUEUE_H
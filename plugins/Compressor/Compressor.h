@@ -47,6 +47,12 @@ public:
 	ProcessStatus processImpl(SampleFrame* buf, const f_cnt_t frames) override;
 	void processBypassedImpl() override;
 
+	f_cnt_t latencyFrames() const override
+	{
+		// lookahead delays the signal by the whole lookahead buffer
+		return m_compressorControls.m_lookaheadModel.value() ? m_lookBufLength : 0;
+	}
+
 	EffectControls* controls() override
 	{
 		return &m_compressorControls;
@@ -47,6 +47,12 @@ public:
 
 	ProcessStatus processImpl(SampleFrame* buf, const f_cnt_t frames) override;
 
+	f_cnt_t latencyFrames() const override
+	{
+		// lookahead delays the signal by the whole lookahead buffer
+		return m_lommControls.m_lookaheadEnableModel.value() ? m_lookBufLength : 0;
+	}
+
 	EffectControls* controls() override
 	{
 		return &m_lommControls;
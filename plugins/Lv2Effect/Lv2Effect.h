@@ -46,6 +46,8 @@ public:
 
 	EffectControls* controls() override { return &m_controls; }
 
+	f_cnt_t latencyFrames() const override { return m_controls.latencyFrames(); }
+
 	Lv2FxControls* lv2Controls() { return &m_controls; }
 	const Lv2FxControls* lv2Controls() const { return &m_controls; }
 
@@ -159,7 +159,8 @@ void SlicerT::findSlices()
 	std::vector<float> singleChannel(m_originalSample.sampleSize(), 0);
 	for (auto i = std::size_t{0}; i < m_originalSample.sampleSize(); i++)
 	{
-		singleChannel[i] = (m_originalSample.data()[i][0] + m_originalSample.data()[i][1]) / 2;
+		const auto frame = m_originalSample.frame(i);
+		singleChannel[i] = (frame.left() + frame.right()) / 2;
 		maxMag = std::max(maxMag, singleChannel[i]);
 	}
 
@@ -393,6 +393,21 @@ void VestigeInstrument::loadFile( const QString & _file )
 
 
 
+void VestigeInstrument::startPlay()
+{
+	if (!m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0)) {return;}
+
+	if( m_plugin != nullptr )
+	{
+		m_plugin->startProcess( nullptr );
+	}
+
+	m_pluginMutex.unlock();
+}
+
+
+
+
 void VestigeInstrument::play( SampleFrame* _buf )
 {
 	if (!m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0)) {return;}
@@ -403,7 +418,8 @@ void VestigeInstrument::play( SampleFrame* _buf )
 		return;
 	}
 
-	m_plugin->process( nullptr, _buf );
+	// the period was started in startPlay()
+	m_plugin->finishProcess( _buf );
 
 	m_pluginMutex.unlock();
 }
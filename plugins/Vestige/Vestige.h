@@ -63,6 +63,13 @@ public:
 
 	virtual void play( SampleFrame* _working_buffer );
 
+	virtual bool playsAsynchronously() const
+	{
+		return true;
+	}
+
+	virtual void startPlay();
+
 	virtual void saveSettings( QDomDocument & _doc, QDomElement & _parent );
 	virtual void loadSettings( const QDomElement & _this );
 
@@ -190,6 +190,12 @@ public:
 
 	virtual void processMidiEvent( const MidiEvent& event, const f_cnt_t offset );
 
+	// VST 2 parameters are not sample accurate, so the change applies to the whole period
+	virtual void processParameterChange(int index, float value, const f_cnt_t /* offset */)
+	{
+		m_plugin->setParameter(m_plugin, index, value);
+	}
+
 	// set given sample-rate for plugin
 	virtual void updateSampleRate()
 	{
@@ -2304,6 +2310,9 @@ void * RemoteVstPlugin::processingThread(void * _param)
 		
 		if( m.id == IdStartProcessing
 			|| m.id == IdMidiEvent
+			|| m.id == IdEvents
+			|| m.id == IdEventRingKey
+			|| m.id == IdDrainEvents
 			|| m.id == IdVstSetParameter
 			|| m.id == IdVstSetTempo)
 		{
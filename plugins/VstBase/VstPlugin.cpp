@@ -363,6 +363,7 @@ int VstPlugin::currentProgram()
 
 const QMap<QString, QString> & VstPlugin::parameterDump()
 {
+	drainEvents();
 	lock();
 	sendMessage( IdVstGetParameterDump );
 	waitForMessage( IdVstParameterDump, true );
@@ -388,6 +389,7 @@ void VstPlugin::setParameterDump( const QMap<QString, QString> & _pdump )
 		m.addString( item.shortLabel );
 		m.addFloat( item.value );
 	}
+	drainEvents();
 	lock();
 	sendMessage( m );
 	unlock();
@@ -433,6 +435,7 @@ bool VstPlugin::processMessage( const message & _m )
 
 		case IdVstPluginName:
 			m_name = _m.getQString();
+			setObjectName( m_name );
 			break;
 
 		case IdVstPluginVersion:
@@ -652,6 +655,7 @@ void VstPlugin::savePreset()
 		{
 			fns = fns.left(fns.length() - 4) + (fns.right(4)).toLower();
 		}
+		drainEvents();
 		lock();
 		sendMessage(message(IdSavePresetFile).addString(QSTR_TO_STDSTR(QDir::toNativeSeparators(fns))));
 		waitForMessage(IdSavePresetFile, true);
@@ -664,6 +668,15 @@ void VstPlugin::savePreset()
 
 void VstPlugin::setParam( int i, float f )
 {
+	if (peerProtocolVersion() >= 1)
+	{
+		// processed before the next period, or on the next idle update
+		auto event = RemoteEvent{.type = RemoteEvent::Type::Parameter};
+		event.parameter = {i, f};
+		sendEvent(event);
+		return;
+	}
+
 	lock();
 	sendMessage( message( IdVstSetParameter ).addInt( i ).addFloat( f ) );
 	//waitForMessage( IdVstSetParameter, true );
@@ -674,6 +687,7 @@ void VstPlugin::setParam( int i, float f )
 
 void VstPlugin::idleUpdate()
 {
+	drainEvents();
 	lock();
 	sendMessage( message( IdVstIdleUpdate ) );
 	unlock();
@@ -724,6 +738,7 @@ void VstPlugin::loadChunk( const QByteArray & _chunk )
 		tf.write( _chunk );
 		tf.flush();
 
+		drainEvents();
 		lock();
 		sendMessage( message( IdLoadSettingsFromFile ).
 				addString(
@@ -744,6 +759,7 @@ QByteArray VstPlugin::saveChunk()
 	QTemporaryFile tf;
 	if( tf.open() )
 	{
+		drainEvents();
 		lock();
 		sendMessage( message( IdSaveSettingsToFile ).
 				addString(
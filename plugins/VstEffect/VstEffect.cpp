@@ -87,6 +87,8 @@ Effect::ProcessStatus VstEffect::processImpl(SampleFrame* buf, const f_cnt_t fra
 	std::memcpy(tempBuf.data(), buf, sizeof(SampleFrame) * frames);
 	if (m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0))
 	{
+		// unlike remote instruments, effects wait for the plugin process right away: the
+		// rest of the effect chain and the mixer channels it feeds need the output first
 		m_plugin->process(tempBuf.data(), tempBuf.data());
 		m_pluginMutex.unlock();
 	}
@@ -330,12 +330,34 @@ QString ZynAddSubFxInstrument::nodeName() const
 
 
 
+bool ZynAddSubFxInstrument::playsAsynchronously() const
+{
+	return m_remote.load(std::memory_order_relaxed);
+}
+
+
+
+
+void ZynAddSubFxInstrument::startPlay()
+{
+	if (!m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0)) {return;}
+	if( m_remotePlugin )
+	{
+		m_remotePlugin->startProcess( nullptr );
+	}
+	m_pluginMutex.unlock();
+}
+
+
+
+
 void ZynAddSubFxInstrument::play( SampleFrame* _buf )
 {
 	if (!m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0)) {return;}
 	if( m_remotePlugin )
 	{
-		m_remotePlugin->process( nullptr, _buf );
+		// the period was started in startPlay()
+		m_remotePlugin->finishProcess( _buf );
 	}
 	else
 	{
@@ -434,6 +456,7 @@ void ZynAddSubFxInstrument::initPlugin()
 	delete m_remotePlugin;
 	m_plugin = nullptr;
 	m_remotePlugin = nullptr;
+	m_remote = false;
 
 	if( m_hasGUI )
 	{
@@ -469,6 +492,7 @@ void ZynAddSubFxInstrument::initPlugin()
 		m_plugin->setBufferSize( Engine::audioEngine()->framesPerPeriod() );
 	}
 
+	m_remote = m_remotePlugin != nullptr;
 	m_pluginMutex.unlock();
 }
 
@@ -25,6 +25,8 @@
 #ifndef ZYNADDSUBFX_H
 #define ZYNADDSUBFX_H
 
+#include <atomic>
+
 #include <QMap>
 #include <QMutex>
 
@@ -76,6 +78,10 @@ public:
 
 	void play( SampleFrame* _working_buffer ) override;
 
+	bool playsAsynchronously() const override;
+
+	void startPlay() override;
+
 	bool handleMidiEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) override;
 
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
@@ -111,6 +117,8 @@ private:
 	QMutex m_pluginMutex;
 	LocalZynAddSubFx * m_plugin;
 	ZynAddSubFxRemotePlugin * m_remotePlugin;
+	//! Whether m_remotePlugin is set, readable without locking m_pluginMutex
+	std::atomic<bool> m_remote = false;
 
 	FloatModel m_portamentoModel;
 	FloatModel m_filterFreqModel;
@@ -36,11 +36,13 @@ namespace lmms
 
 #ifdef SYNC_WITH_SHM_FIFO
 RemotePluginBase::RemotePluginBase(shmFifo * _in, shmFifo * _out) :
+	m_peerProtocolVersion(0),
 	m_in(_in),
 	m_out(_out)
 #else
 RemotePluginBase::RemotePluginBase() :
 	m_socket(-1),
+	m_peerProtocolVersion(0),
 	m_invalid(false)
 #endif
 {
@@ -76,6 +78,72 @@ int RemotePluginBase::sendMessage(const message & _m)
 {
 #ifdef SYNC_WITH_SHM_FIFO
 	m_out->lock();
+#else
+	pthread_mutex_lock(&m_sendMutex);
+#endif
+
+	int j = 0;
+	if (!m_events.empty())
+	{
+		j += writeMessage(message(IdEvents).addData(m_events.data(), m_events.size())
+			.addInt(static_cast<int>(m_eventsRingPosition)));
+		m_events.clear();
+	}
+	j += writeMessage(_m);
+
+#ifdef SYNC_WITH_SHM_FIFO
+	m_out->unlock();
+#else
+	pthread_mutex_unlock(&m_sendMutex);
+#endif
+
+	return j;
+}
+
+
+
+
+void RemotePluginBase::queueEvent(const RemoteEvent& event, std::uint32_t ringPosition)
+{
+#ifdef SYNC_WITH_SHM_FIFO
+	m_out->lock();
+#else
+	pthread_mutex_lock(&m_sendMutex);
+#endif
+
+	if (m_events.empty()) { m_eventsRingPosition = ringPosition; }
+	m_events.push_back(event);
+
+#ifdef SYNC_WITH_SHM_FIFO
+	m_out->unlock();
+#else
+	pthread_mutex_unlock(&m_sendMutex);
+#endif
+}
+
+
+
+
+bool RemotePluginBase::hasQueuedEvents()
+{
+#ifdef SYNC_WITH_SHM_FIFO
+	m_out->lock();
+	const auto queued = !m_events.empty();
+	m_out->unlock();
+#else
+	pthread_mutex_lock(&m_sendMutex);
+	const auto queued = !m_events.empty();
+	pthread_mutex_unlock(&m_sendMutex);
+#endif
+	return queued;
+}
+
+
+
+
+int RemotePluginBase::writeMessage(const message& _m)
+{
+#ifdef SYNC_WITH_SHM_FIFO
 	m_out->writeInt(_m.id);
 	m_out->writeInt(_m.data.size());
 	int j = 8;
@@ -84,10 +152,8 @@ int RemotePluginBase::sendMessage(const message & _m)
 		m_out->writeString(_m.data[i]);
 		j += 4 + _m.data[i].size();
 	}
-	m_out->unlock();
 	m_out->messageSent();
 #else
-	pthread_mutex_lock(&m_sendMutex);
 	writeInt(_m.id);
 	writeInt(_m.data.size());
 	int j = 8;
@@ -96,7 +162,6 @@ int RemotePluginBase::sendMessage(const message & _m)
 		writeString(str);
 		j += 4 + str.size();
 	}
-	pthread_mutex_unlock(&m_sendMutex);
 #endif
 
 	return j;
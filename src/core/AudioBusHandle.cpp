@@ -25,6 +25,8 @@
 
 #include "AudioBusHandle.h"
 
+#include <algorithm>
+
 #include <QMutexLocker>
 
 #include "AudioDevice.h"
@@ -107,19 +109,29 @@ bool AudioBusHandle::processEffects()
 }
 
 
+f_cnt_t AudioBusHandle::latencyFrames() const
+{
+	return m_effects ? m_effects->latencyFrames() : 0;
+}
+
+
 void AudioBusHandle::doProcessing()
 {
+	const auto probe = AudioEngineProfiler::JobProbe{Engine::audioEngine()->profiler(),
+		AudioEngineProfiler::JobType::Track, this};
+	const f_cnt_t fpp = Engine::audioEngine()->framesPerPeriod();
+
 	if (m_mutedModel && m_mutedModel->value())
 	{
+		if (m_tap) { zeroSampleFrames(m_tap, fpp); }
 		return;
 	}
 
-	const f_cnt_t fpp = Engine::audioEngine()->framesPerPeriod();
-
 	// clear the buffer
 	m_buffer.silenceAllChannels();
 
-	//qDebug( "Playhandles: %d", m_playHandles.size() );
+	// notes may be added from other threads (e.g. MIDI input) meanwhile
+	m_playHandleLock.lock();
 	for (PlayHandle* ph : m_playHandles) // now we mix all playhandle buffers into our internal buffer
 	{
 		if (ph->buffer())
@@ -137,6 +149,7 @@ void AudioBusHandle::doProcessing()
 									// pointer to null, so if it doesn't get re-acquired we know to skip it next time
 		}
 	}
+	m_playHandleLock.unlock();
 
 	if (m_bufferUsage)
 	{
@@ -240,7 +253,25 @@ void AudioBusHandle::doProcessing()
 
 	// handle effects
 	const bool anyOutputAfterEffects = processEffects();
-	if (anyOutputAfterEffects || m_bufferUsage)
+	bool anyOutput = anyOutputAfterEffects || m_bufferUsage;
+
+	// delay the output to the latency of the other inputs of the mixer channel
+	if (m_latencyCompensator.delay() > 0 && (anyOutput || m_latencyCompensator.hasSignal()))
+	{
+		auto buffer = m_buffer.interleavedBuffer().asSampleFrames();
+		m_latencyCompensator.process(anyOutput ? buffer.data() : nullptr, buffer.data(), fpp);
+		toPlanar(m_buffer.interleavedBuffer(), m_buffer.groupBuffers(0));
+		m_buffer.updateAllSilenceFlags();
+		anyOutput = true;
+	}
+
+	if (m_tap)
+	{
+		const auto buffer = m_buffer.interleavedBuffer().asSampleFrames();
+		std::copy_n(buffer.data(), fpp, m_tap);
+	}
+
+	if (anyOutput)
 	{
 		// TODO: improve the flow here - convert to pull model
 		Engine::mixer()->mixToChannel(m_buffer, m_nextMixerChannel); // send output to mixer
@@ -24,6 +24,12 @@
 
 #include "AudioEngine.h"
 
+#include <algorithm>
+#include <chrono>
+
+#include <QPointer>
+#include <QTimer>
+
 #include "MixHelpers.h"
 
 #include "lmmsconfig.h"
@@ -31,9 +37,12 @@
 #include "AudioEngineWorkerThread.h"
 #include "AudioBusHandle.h"
 #include "Hardware.h"
+#include "LocklessRingBuffer.h"
+#include "MidiPort.h"
 #include "Mixer.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
+#include "InstrumentPlayHandle.h"
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
 
@@ -66,13 +75,32 @@ namespace lmms
 using LocklessListElement = LocklessList<PlayHandle*>::Element;
 
 static thread_local bool s_renderingThread = false;
+static int s_threadCount = 0;
+static f_cnt_t s_offlinePeriodSize = 0;
+
+//! How often applied changes are released, in milliseconds
+static constexpr auto GarbageCollectionInterval = 100;
+
+//! How many MIDI events can arrive during a single period
+static constexpr auto MaxMidiInput = std::size_t{1024};
+
+
+struct AudioEngine::Change
+{
+	std::function<void()> apply;
+	std::function<void()> release;
+	Change* next;
+};
+
 
 AudioEngine::AudioEngine(bool renderOnly)
 	: m_renderOnly(renderOnly)
 	, m_framesPerAudioBuffer(std::clamp(
 		  static_cast<f_cnt_t>(ConfigManager::inst()->value("audioengine", "framesperaudiobuffer").toULongLong()),
 		  MINIMUM_BUFFER_SIZE, MAXIMUM_BUFFER_SIZE))
-	, m_framesPerPeriod(std::min(m_framesPerAudioBuffer, DEFAULT_BUFFER_SIZE))
+	, m_framesPerPeriod(renderOnly && s_offlinePeriodSize > 0
+		  ? s_offlinePeriodSize
+		  : std::min(m_framesPerAudioBuffer, DEFAULT_BUFFER_SIZE))
 	, m_baseSampleRate(
 		  std::max(ConfigManager::inst()->value("audioengine", "samplerate").toInt(), SUPPORTED_SAMPLERATES.front()))
 	, m_inputBufferRead(0)
@@ -80,15 +108,28 @@ AudioEngine::AudioEngine(bool renderOnly)
 	, m_outputBufferRead(nullptr)
 	, m_outputBufferWrite(nullptr)
 	, m_outputBufferReadIndex(0)
+	, m_outputPeriod(nullptr)
+	, m_renderAheadPeriods(renderOnly ? 0 : std::clamp(
+		  ConfigManager::inst()->value("audioengine", "renderahead", "0").toInt(), 0, MaxRenderAheadPeriods))
+	, m_renderAheadQuit(false)
+	, m_renderAheadPrimed(false)
+	, m_periodsRead(0)
+	, m_renderAheadUnderruns(0)
+	, m_renderAheadXruns(0)
 	, m_workers()
-	, m_numWorkers(QThread::idealThreadCount() - 1)
+	, m_numWorkers((s_threadCount > 0 ? s_threadCount : QThread::idealThreadCount()) - 1)
 	, m_newPlayHandles(PlayHandle::MaxNumber)
 	, m_masterGain(1.0f)
 	, m_audioDev(nullptr)
 	, m_oldAudioDev(nullptr)
 	, m_audioDevStartFailed(false)
+	, m_midiInput(MaxMidiInput)
+	, m_midiInputClock(0)
+	, m_droppedMidiInput(0)
 	, m_profiler()
 	, m_clearSignal(false)
+	, m_pendingChanges(nullptr)
+	, m_appliedChanges(nullptr)
 {
 	for( int i = 0; i < 2; ++i )
 	{
@@ -98,10 +139,23 @@ AudioEngine::AudioEngine(bool renderOnly)
 		zeroSampleFrames(m_inputBuffer[i], m_inputBufferSize[i]);
 	}
 
+	m_pendingMidiInput.reserve(MaxMidiInput);
+	m_profiler.setMidiLatencyMeasurement(ConfigManager::inst()->value("midi", "measurelatency").toInt());
+	m_profiler.setJobProfiling(ConfigManager::inst()->value("audioengine", "profilejobs").toInt());
+
 	BufferManager::init( m_framesPerPeriod );
 	m_outputBufferRead = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
 	m_outputBufferWrite = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
 
+	if (m_renderAheadPeriods > 0)
+	{
+		// one more period than the lookahead, so the render thread can write while the device reads
+		m_renderAheadBuffer = std::make_unique<LocklessRingBuffer<SampleFrame>>(
+			m_framesPerPeriod * (m_renderAheadPeriods + 1));
+		m_renderAheadBuffer->mlock();
+		m_renderAheadReader = std::make_unique<LocklessRingBufferReader<SampleFrame>>(*m_renderAheadBuffer);
+		m_renderAheadPeriod = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
+	}
 
 	for( int i = 0; i < m_numWorkers+1; ++i )
 	{
@@ -112,6 +166,10 @@ AudioEngine::AudioEngine(bool renderOnly)
 		}
 		m_workers.push_back( wt );
 	}
+
+	auto garbageTimer = new QTimer{this};
+	connect(garbageTimer, &QTimer::timeout, this, &AudioEngine::collectGarbage);
+	garbageTimer->start(GarbageCollectionInterval);
 }
 
 
@@ -119,6 +177,8 @@ AudioEngine::AudioEngine(bool renderOnly)
 
 AudioEngine::~AudioEngine()
 {
+	stopRenderAhead();
+
 	for( int w = 0; w < m_numWorkers; ++w )
 	{
 		m_workers[w]->quit();
@@ -131,6 +191,9 @@ AudioEngine::~AudioEngine()
 		m_workers[w]->wait( 500 );
 	}
 
+	collectGarbage();
+	releaseChanges(m_pendingChanges.exchange(nullptr, std::memory_order_acquire));
+
 	delete m_midiClient;
 	delete m_audioDev;
 
@@ -144,6 +207,22 @@ AudioEngine::~AudioEngine()
 
 
 
+void AudioEngine::setThreadCount(int threads)
+{
+	s_threadCount = threads;
+}
+
+
+
+
+void AudioEngine::setOfflinePeriodSize(f_cnt_t frames)
+{
+	s_offlinePeriodSize = frames == 0 ? 0 : std::clamp(frames, MINIMUM_BUFFER_SIZE, MAXIMUM_BUFFER_SIZE);
+}
+
+
+
+
 void AudioEngine::initDevices()
 {
 	bool success_ful = false;
@@ -201,6 +280,12 @@ void AudioEngine::renderStageNoteSetup()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::NoteSetup);
 
+	// take the changes before the new play handles, so everything a change
+	// refers to has been added when it is applied below
+	const auto changes = m_pendingChanges.exchange(nullptr, std::memory_order_acquire);
+
+	processMidiInput();
+
 	if( m_clearSignal )
 	{
 		m_clearSignal = false;
@@ -246,28 +331,61 @@ void AudioEngine::renderStageNoteSetup()
 		m_newPlayHandles.free( e );
 		e = next;
 	}
+
+	applyChanges(changes);
 }
 
 
 
-void AudioEngine::renderStageInstruments()
+void AudioEngine::renderStageProcessing()
 {
-	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Instruments);
+	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Processing);
 
-	AudioEngineWorkerThread::fillJobQueue(m_playHandles);
-	AudioEngineWorkerThread::startAndWaitForJobs();
-}
+	// STAGE 1: run play handles, effects of all instrument- and sampletracks
+	// and mixer channels as one job graph, so e.g. a track's effects can
+	// start as soon as its own notes are done
+	Mixer * mixer = Engine::mixer();
 
+	// effect latencies may change any time, e.g. when lookahead is toggled
+	mixer->compensateLatency(m_audioBusHandles);
 
+	AudioEngineWorkerThread::addJobs(m_playHandles);
+	AudioEngineWorkerThread::addJobs(m_audioBusHandles);
+	mixer->addJobs();
 
-void AudioEngine::renderStageEffects()
-{
-	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Effects);
+	for (PlayHandle* ph : m_playHandles)
+	{
+		// instruments running in another process get started along with the
+		// other play handles and are collected once no other job is ready
+		if (ph->type() == PlayHandle::Type::InstrumentPlayHandle
+			&& ph->state() == ThreadableJob::ProcessingState::Queued)
+		{
+			auto iph = static_cast<InstrumentPlayHandle*>(ph);
+			if (iph->startPeriod())
+			{
+				ThreadableJob* finishJob = iph->finishJob();
+				AudioEngineWorkerThread::addJob(finishJob);
+				AudioEngineWorkerThread::addDependency(finishJob, ph);
+				AudioEngineWorkerThread::addDependency(ph->audioBusHandle(), finishJob);
+				continue;
+			}
+		}
+		AudioEngineWorkerThread::addDependency(ph->audioBusHandle(), ph);
+	}
+	for (AudioBusHandle* busHandle : m_audioBusHandles)
+	{
+		const mix_ch_t channelIndex = busHandle->nextMixerChannel();
+		if (channelIndex < mixer->numChannels() && !mixer->mixerChannel(channelIndex)->m_muted)
+		{
+			AudioEngineWorkerThread::addDependency(mixer->mixerChannel(channelIndex), busHandle);
+		}
+	}
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	AudioEngineWorkerThread::fillJobQueue(m_audioBusHandles);
 	AudioEngineWorkerThread::startAndWaitForJobs();
 
+	// while the play handles (and e.g. the bus handles of sample play handles) are still there
+	m_profiler.collectJobs();
+
 	// removed all play handles which are done
 	for( PlayHandleList::Iterator it = m_playHandles.begin();
 						it != m_playHandles.end(); )
@@ -324,17 +442,205 @@ std::span<const SampleFrame> AudioEngine::renderNextPeriod()
 	s_renderingThread = true;
 
 	renderStageNoteSetup();     // STAGE 0: clear old play handles and buffers, setup new play handles
-	renderStageInstruments();   // STAGE 1: run and render all play handles
-	renderStageEffects();       // STAGE 2: process effects of all instrument- and sampletracks
-	renderStageMix();           // STAGE 3: do master mix in mixer
+	renderStageProcessing();    // STAGE 1: render play handles, track effects and mixer channels
+	renderStageMix();           // STAGE 2: do master mix in mixer
 
 	s_renderingThread = false;
 	m_profiler.finishPeriod(outputSampleRate(), m_framesPerPeriod);
-	m_outputBufferReadIndex = 0;
 
 	return {m_outputBufferRead.get(), m_framesPerPeriod};
 }
 
+
+
+void AudioEngine::nextOutputPeriod()
+{
+	if (m_renderAheadPeriods == 0)
+	{
+		m_outputPeriod = renderNextPeriod().data();
+		return;
+	}
+
+	m_outputPeriod = m_renderAheadPeriod.get();
+	if (m_renderAheadReader->read_space() < m_framesPerPeriod)
+	{
+		// never wait for the render thread, a gap is better than blocking the device
+		zeroSampleFrames(m_renderAheadPeriod.get(), m_framesPerPeriod);
+		if (m_renderAheadPrimed) { m_renderAheadUnderruns.fetch_add(1, std::memory_order_relaxed); }
+		return;
+	}
+
+	m_renderAheadReader->read(m_framesPerPeriod).copy(m_renderAheadPeriod.get(), m_framesPerPeriod);
+	m_renderAheadPrimed = true;
+
+	m_periodsRead.fetch_add(1, std::memory_order_release);
+	m_periodsRead.notify_one();
+}
+
+
+
+void AudioEngine::startRenderAhead()
+{
+	if (m_renderAheadThread) { return; }
+
+	m_renderAheadQuit = false;
+	m_renderAheadPrimed = false;
+	m_renderAheadThread.reset(QThread::create([this] { renderAhead(); }));
+	m_renderAheadThread->start(QThread::TimeCriticalPriority);
+}
+
+
+
+void AudioEngine::stopRenderAhead()
+{
+	if (!m_renderAheadThread) { return; }
+
+	m_renderAheadQuit = true;
+	m_periodsRead.fetch_add(1, std::memory_order_release);
+	m_periodsRead.notify_one();
+	m_renderAheadThread->wait();
+	m_renderAheadThread.reset();
+
+	// drop what was rendered ahead, it belongs to the old playback state
+	m_renderAheadReader->read(m_renderAheadReader->read_space());
+}
+
+
+
+void AudioEngine::renderAhead()
+{
+	disableDenormals();
+
+	using namespace std::chrono;
+	const auto periodDuration = duration<double>{static_cast<double>(m_framesPerPeriod) / outputSampleRate()};
+
+	while (!m_renderAheadQuit)
+	{
+		const auto periodsRead = m_periodsRead.load(std::memory_order_acquire);
+		if (m_renderAheadBuffer->free() < m_framesPerPeriod)
+		{
+			m_periodsRead.wait(periodsRead, std::memory_order_acquire);
+			continue;
+		}
+
+		const auto start = steady_clock::now();
+		const auto period = renderNextPeriod();
+		if (steady_clock::now() - start > periodDuration)
+		{
+			m_renderAheadXruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		m_renderAheadBuffer->write(period.data(), period.size());
+	}
+}
+
+
+
+void AudioEngine::startProcessing()
+{
+	// started along with the device rather than from its callback, which must not create threads, and only for
+	// devices which call renderNextBuffer()
+	if (m_renderAheadPeriods > 0 && m_audioDev->readsRenderedBuffers()) { startRenderAhead(); }
+	m_audioDev->startProcessing();
+}
+
+
+
+void AudioEngine::stopProcessing()
+{
+	m_audioDev->stopProcessing();
+	// the device doesn't read anymore, so the render thread has to go as well,
+	// e.g. before ProjectRenderer starts rendering the periods itself
+	stopRenderAhead();
+}
+
+void AudioEngine::commitChange(std::function<void()> apply, std::function<void()> release)
+{
+	auto change = new Change{std::move(apply), std::move(release), m_pendingChanges.load(std::memory_order_relaxed)};
+	while (!m_pendingChanges.compare_exchange_weak(change->next, change,
+		std::memory_order_release, std::memory_order_relaxed))
+	{
+		// Empty loop (compare_exchange_weak updates change->next)
+	}
+}
+
+
+
+void AudioEngine::retire(QObject* object)
+{
+	commitChange({}, [object = QPointer<QObject>{object}] { delete object; });
+}
+
+
+
+void AudioEngine::flushChanges()
+{
+	// no period is being rendered while we hold the lock, so this is just as good as a period boundary
+	requestChangeInModel();
+	applyChanges(m_pendingChanges.exchange(nullptr, std::memory_order_acquire));
+	doneChangeInModel();
+
+	if (QThread::currentThread() == thread()) { collectGarbage(); }
+}
+
+
+
+f_cnt_t AudioEngine::compensateLatency()
+{
+	const auto lock = std::lock_guard{m_changeMutex};
+	Mixer* mixer = Engine::mixer();
+	mixer->compensateLatency(m_audioBusHandles);
+	return mixer->latencyFrames();
+}
+
+
+
+void AudioEngine::applyChanges(Change* changes)
+{
+	if (!changes) { return; }
+
+	Change* first = nullptr;
+	Change* last = changes;
+	while (changes)
+	{
+		const auto next = changes->next;
+		changes->next = first;
+		first = changes;
+		changes = next;
+	}
+
+	for (auto change = first; change; change = change->next)
+	{
+		if (change->apply) { change->apply(); }
+	}
+
+	last->next = m_appliedChanges.load(std::memory_order_relaxed);
+	while (!m_appliedChanges.compare_exchange_weak(last->next, first,
+		std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+
+
+void AudioEngine::collectGarbage()
+{
+	releaseChanges(m_appliedChanges.exchange(nullptr, std::memory_order_acquire));
+}
+
+
+
+void AudioEngine::releaseChanges(Change* changes)
+{
+	while (changes)
+	{
+		const auto next = changes->next;
+		if (changes->release) { changes->release(); }
+		delete changes;
+		changes = next;
+	}
+}
+
+
+
 void AudioEngine::swapBuffers()
 {
 	m_inputBufferWrite = (m_inputBufferWrite + 1) % 2;
@@ -458,6 +764,100 @@ void AudioEngine::removeAudioBusHandle(AudioBusHandle* busHandle)
 }
 
 
+void AudioEngine::queueMidiInput(MidiPort* port, const MidiEvent& event, const TimePos& time)
+{
+	using namespace std::chrono;
+	const auto arrival = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+
+	// the data of system exclusive messages only lives as long as the call, and processing
+	// any event right away would overtake the ones still queued
+	if (event.type() == MidiSysEx || !m_midiInput.push({port, event, time, arrival}))
+	{
+		m_droppedMidiInput.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+
+
+void AudioEngine::dropMidiInput(const MidiPort* port)
+{
+	// the audio thread waits meanwhile, so the queue can be taken from here
+	const auto guard = requestChangesGuard();
+	takeMidiInput();
+	std::erase_if(m_pendingMidiInput, [port](const MidiInput& input) { return input.port == port; });
+}
+
+
+
+
+void AudioEngine::takeMidiInput()
+{
+	// the list starts with the latest event
+	const auto taken = m_pendingMidiInput.size();
+	for (auto e = m_midiInput.popList(); e;)
+	{
+		m_pendingMidiInput.push_back(e->value);
+		const auto next = e->next;
+		m_midiInput.free(e);
+		e = next;
+	}
+	std::reverse(m_pendingMidiInput.begin() + taken, m_pendingMidiInput.end());
+}
+
+
+
+
+void AudioEngine::processMidiInput()
+{
+	using namespace std::chrono;
+	const auto now = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	const auto sampleRate = outputSampleRate();
+	const auto periodLength = static_cast<std::int64_t>(m_framesPerPeriod) * 1'000'000'000 / sampleRate;
+	// events which arrived while one buffer was rendered and played start in the next one
+	const auto delay = static_cast<std::int64_t>(std::max(m_framesPerAudioBuffer, m_framesPerPeriod)) * 1'000'000'000 / sampleRate;
+
+	// follow the real time only if the periods are rendered much earlier or later than
+	// expected, e.g. after an xrun, as audio devices often ask for several periods at once
+	m_midiInputClock += periodLength;
+	if (now - m_midiInputClock > delay || m_midiInputClock - now > delay + m_renderAheadPeriods * periodLength)
+	{
+		m_midiInputClock = now;
+	}
+
+	takeMidiInput();
+	if (m_pendingMidiInput.empty()) { return; }
+
+	const auto periodEnd = m_midiInputClock + periodLength;
+	const auto measureLatency = m_profiler.midiLatencyMeasurement();
+
+	auto kept = m_pendingMidiInput.begin();
+	for (const auto& input : m_pendingMidiInput)
+	{
+		const auto start = input.arrival + delay;
+		if (start >= periodEnd)
+		{
+			*kept++ = input;
+			continue;
+		}
+
+		// events which are late start right away
+		const auto offset = start > m_midiInputClock
+			? std::min(static_cast<f_cnt_t>((start - m_midiInputClock) * sampleRate / 1'000'000'000), m_framesPerPeriod - 1)
+			: f_cnt_t{0};
+		input.port->processQueuedInEvent(input.event, input.time, offset);
+
+		if (measureLatency && input.event.type() == MidiNoteOn && input.event.velocity() > 0)
+		{
+			m_profiler.recordMidiLatency(m_midiInputClock + static_cast<std::int64_t>(offset) * 1'000'000'000 / sampleRate - input.arrival);
+		}
+	}
+	m_pendingMidiInput.erase(kept, m_pendingMidiInput.end());
+}
+
+
+
+
 bool AudioEngine::addPlayHandle( PlayHandle* handle )
 {
 	// Only add play handles if we have the CPU capacity to process them.
@@ -482,57 +882,43 @@ bool AudioEngine::addPlayHandle( PlayHandle* handle )
 
 void AudioEngine::removePlayHandle(PlayHandle * ph)
 {
-	requestChangeInModel();
 	// check thread affinity as we must not delete play-handles
 	// which were created in a thread different than the audio engine thread
-	if (ph->affinityMatters() && ph->affinity() == QThread::currentThread())
-	{
-		ph->audioBusHandle()->removePlayHandle(ph);
-		bool removedFromList = false;
-		// Check m_newPlayHandles first because doing it the other way around
-		// creates a race condition
-		for( LocklessListElement * e = m_newPlayHandles.first(),
-				* ePrev = nullptr; e; ePrev = e, e = e->next )
-		{
-			if (e->value == ph)
+	if (!ph->affinityMatters() || ph->affinity() != QThread::currentThread())
+	{
+		requestChangeInModel();
+		m_playHandlesToRemove.push_back(ph);
+		doneChangeInModel();
+		return;
+	}
+
+	// unlink it on the rendering thread at the next period boundary, so we don't have to
+	// wait for the current period. When the change is applied, new play handles have been
+	// moved to m_playHandles already. Deleting happens on the main thread during the next
+	// garbage collection, so the handle gets to stop right away in onRemoved().
+	auto removedFromList = std::make_shared<bool>(false);
+	commitChange(
+		[this, ph, removedFromList] {
+			PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
+			if (it != m_playHandles.end())
 			{
-				if( ePrev )
-				{
-					ePrev->next = e->next;
-				}
-				else
-				{
-					m_newPlayHandles.setFirst( e->next );
-				}
-				m_newPlayHandles.free( e );
-				removedFromList = true;
-				break;
+				ph->audioBusHandle()->removePlayHandle(ph);
+				m_playHandles.erase(it);
+				ph->onRemoved();
+				*removedFromList = true;
 			}
-		}
-		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
-		if (it != m_playHandles.end())
-		{
-			m_playHandles.erase(it);
-			removedFromList = true;
-		}
-		// Only deleting PlayHandles that were actually found in the list
-		// "fixes crash when previewing a preset under high load"
-		// (See tobydox's 2008 commit 4583e48)
-		if ( removedFromList )
-		{
+		},
+		[ph, removedFromList] {
+			// Only deleting PlayHandles that were actually found in the list
+			// "fixes crash when previewing a preset under high load"
+			// (See tobydox's 2008 commit 4583e48)
+			if (!*removedFromList) { return; }
 			if (ph->type() == PlayHandle::Type::NotePlayHandle)
 			{
 				NotePlayHandleManager::release(dynamic_cast<NotePlayHandle*>(ph));
 			}
 			else { delete ph; }
-		}
-	}
-	else
-	{
-		m_playHandlesToRemove.push_back(ph);
-	}
-	doneChangeInModel();
+		});
 }
 
 
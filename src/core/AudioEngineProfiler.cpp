@@ -24,11 +24,96 @@
 
 #include "AudioEngineProfiler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+
+#include "AudioBusHandle.h"
+#include "Effect.h"
+#include "Mixer.h"
+#include "RemotePlugin.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+constexpr auto MaxThreads = 64;
+constexpr auto MaxJobSamples = std::size_t{4096}; // per thread and period
+constexpr auto MaxJobs = std::size_t{2048}; // power of two
+
+constexpr std::array<const char*, static_cast<std::size_t>(AudioEngineProfiler::JobType::Count)> JobTypeNames
+{
+	"Instrument",
+	"Instrument output",
+	"Track",
+	"Effect",
+	"Mixer channel",
+	"Remote plugin"
+};
+
+QString jobName(AudioEngineProfiler::JobType type, const void* source)
+{
+	switch (type)
+	{
+	case AudioEngineProfiler::JobType::Instrument:
+	case AudioEngineProfiler::JobType::InstrumentOutput:
+	case AudioEngineProfiler::JobType::Track:
+		return static_cast<const AudioBusHandle*>(source)->name();
+	case AudioEngineProfiler::JobType::Effect:
+		return static_cast<const Effect*>(source)->displayName();
+	case AudioEngineProfiler::JobType::MixerChannel:
+		return static_cast<const MixerChannel*>(source)->m_name;
+	case AudioEngineProfiler::JobType::RemotePlugin:
+		return static_cast<const RemotePlugin*>(source)->objectName();
+	default:
+		return {};
+	}
+}
+
+//! Home slot of a job in AudioEngineProfiler::m_jobs
+auto jobSlot(AudioEngineProfiler::JobType type, const void* source) -> std::size_t
+{
+	return (std::hash<const void*>{}(source) ^ static_cast<std::size_t>(type)) & (MaxJobs - 1);
+}
+
+QString escapeJson(QString text)
+{
+	return text.replace('\\', "\\\\").replace('"', "\\\"");
+}
+
+// the log of the current thread, assigned on its first job
+thread_local const AudioEngineProfiler* t_profiler = nullptr;
+thread_local int t_threadLog = -1;
+
+} // namespace
+
+
+struct AudioEngineProfiler::ThreadLog
+{
+	std::array<JobSample, MaxJobSamples> samples;
+	std::size_t size = 0;
+};
+
+
+struct AudioEngineProfiler::JobEntry
+{
+	JobType type = JobType::Count;
+	const void* source = nullptr;
+	QString name;
+	float periodTime = 0.f; //!< microseconds spent in the current period
+	std::array<float, StatisticsPeriods> history{};
+	std::size_t historySize = 0;
+	std::size_t lastPeriod = 0; //!< the last period the job ran in
+};
+
+
+
+
 AudioEngineProfiler::AudioEngineProfiler() :
 	m_periodTimer(),
 	m_cpuLoad( 0 ),
@@ -38,6 +123,17 @@ AudioEngineProfiler::AudioEngineProfiler() :
 
 
 
+
+AudioEngineProfiler::~AudioEngineProfiler()
+{
+	if (m_traceOutput && m_outputFile.isOpen())
+	{
+		m_outputFile.write("\n]\n");
+	}
+}
+
+
+
 void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, f_cnt_t framesPerPeriod )
 {
 	// Time taken to process all data and fill the audio buffer.
@@ -59,7 +155,13 @@ void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, f_cnt_t frames
 		m_detailLoad[i].store(newLoad * 0.05f + oldLoad * 0.95f, std::memory_order_relaxed);
 	}
 
-	if( m_outputFile.isOpen() )
+	if (m_traceOutput && jobProfiling())
+	{
+		const auto thread = t_profiler == this ? t_threadLog : 0;
+		writeTraceEvent("Period", "Period", thread, m_periodStart, now());
+	}
+
+	if( m_outputFile.isOpen() && !m_traceOutput )
 	{
 		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
 	}
@@ -69,9 +171,260 @@ void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, f_cnt_t frames
 
 void AudioEngineProfiler::setOutputFile( const QString& outputFile )
 {
+	if (m_traceOutput && m_outputFile.isOpen())
+	{
+		m_outputFile.write("\n]\n");
+	}
+
 	m_outputFile.close();
 	m_outputFile.setFileName( outputFile );
 	m_outputFile.open( QFile::WriteOnly | QFile::Truncate );
+
+	m_traceOutput = outputFile.endsWith(".json", Qt::CaseInsensitive);
+	if (m_traceOutput)
+	{
+		m_firstTraceEvent = true;
+		m_outputFile.write("[\n");
+		setJobProfiling(true);
+	}
+}
+
+
+
+
+void AudioEngineProfiler::setJobProfiling(bool enabled)
+{
+	if (enabled && !m_threadLogs)
+	{
+		// allocated once and kept, so threads which still record never see it go away
+		m_threadLogs = std::make_unique<ThreadLog[]>(MaxThreads);
+	}
+
+	if (enabled && !jobProfiling())
+	{
+		const auto lock = std::lock_guard{m_jobsMutex};
+		m_jobs.assign(MaxJobs, JobEntry{});
+		m_historyIndex = 0;
+		m_period = 0;
+	}
+
+	m_jobProfiling.store(enabled, std::memory_order_release);
+}
+
+
+
+
+void AudioEngineProfiler::setMidiLatencyMeasurement(bool enabled)
+{
+	m_midiLatencyMeasurement.store(false, std::memory_order_relaxed);
+	m_midiLatencyNotes.store(0, std::memory_order_relaxed);
+	m_midiLatencySum.store(0, std::memory_order_relaxed);
+	m_midiLatencyMeasurement.store(enabled, std::memory_order_relaxed);
+}
+
+
+
+
+AudioEngineProfiler::MidiLatencyStatistics AudioEngineProfiler::midiLatencyStatistics() const
+{
+	const auto notes = m_midiLatencyNotes.load(std::memory_order_relaxed);
+	if (notes == 0) { return {0, 0.f, 0.f, 0.f}; }
+
+	constexpr auto NanosecondsPerMillisecond = 1e6f;
+	return {notes,
+		m_midiLatencyMin.load(std::memory_order_relaxed) / NanosecondsPerMillisecond,
+		m_midiLatencySum.load(std::memory_order_relaxed) / NanosecondsPerMillisecond / notes,
+		m_midiLatencyMax.load(std::memory_order_relaxed) / NanosecondsPerMillisecond};
+}
+
+
+
+
+void AudioEngineProfiler::recordMidiLatency(std::int64_t nanoseconds)
+{
+	const auto notes = m_midiLatencyNotes.load(std::memory_order_relaxed);
+	if (notes == 0 || nanoseconds < m_midiLatencyMin.load(std::memory_order_relaxed))
+	{
+		m_midiLatencyMin.store(nanoseconds, std::memory_order_relaxed);
+	}
+	if (notes == 0 || nanoseconds > m_midiLatencyMax.load(std::memory_order_relaxed))
+	{
+		m_midiLatencyMax.store(nanoseconds, std::memory_order_relaxed);
+	}
+	m_midiLatencySum.fetch_add(nanoseconds, std::memory_order_relaxed);
+	m_midiLatencyNotes.store(notes + 1, std::memory_order_relaxed);
+}
+
+
+
+
+std::vector<AudioEngineProfiler::JobStatistics> AudioEngineProfiler::jobStatistics() const
+{
+	auto statistics = std::vector<JobStatistics>{};
+
+	const auto lock = std::lock_guard{m_jobsMutex};
+	auto times = std::vector<float>{};
+	for (const auto& job : m_jobs)
+	{
+		if (!job.source || job.historySize == 0) { continue; }
+
+		times.assign(job.history.begin(), job.history.begin() + job.historySize);
+		std::sort(times.begin(), times.end());
+
+		const auto sum = std::accumulate(times.begin(), times.end(), 0.f);
+		const auto p99 = static_cast<std::size_t>(std::ceil(times.size() * 0.99)) - 1;
+		statistics.push_back({job.type, job.source, job.name, times.front(), sum / times.size(), times[p99]});
+	}
+
+	std::sort(statistics.begin(), statistics.end(),
+		[](const JobStatistics& a, const JobStatistics& b) { return a.averageTime > b.averageTime; });
+	return statistics;
+}
+
+
+
+
+void AudioEngineProfiler::recordJob(JobType type, const void* source, std::int64_t start, std::int64_t end)
+{
+	if (t_profiler != this)
+	{
+		t_profiler = this;
+		t_threadLog = m_threadLogCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (t_threadLog >= MaxThreads) { return; }
+
+	// only the audio thread reads the logs, once all jobs of the period are done
+	auto& log = m_threadLogs[t_threadLog];
+	if (log.size < MaxJobSamples)
+	{
+		log.samples[log.size++] = {type, source, start, end};
+	}
+}
+
+
+
+
+void AudioEngineProfiler::collectJobs()
+{
+	if (!jobProfiling()) { return; }
+
+	// never wait for a thread reading the statistics, skip the period instead
+	auto lock = std::unique_lock{m_jobsMutex, std::try_to_lock};
+
+	const auto threads = std::min(m_threadLogCount.load(std::memory_order_relaxed), MaxThreads);
+	for (auto thread = 0; thread < threads; ++thread)
+	{
+		auto& log = m_threadLogs[thread];
+		for (auto& sample : std::span{log.samples}.first(log.size))
+		{
+			JobEntry* job = lock.owns_lock() ? findJob(sample.type, sample.source) : nullptr;
+			if (job)
+			{
+				job->periodTime += (sample.end - sample.start) / 1000.f;
+				job->lastPeriod = m_period;
+				// names may change, so they are looked up again every now and then
+				if (job->historySize == 0 || m_historyIndex == 0) { job->name = jobName(sample.type, sample.source); }
+			}
+
+			if (m_traceOutput)
+			{
+				writeTraceEvent(jobName(sample.type, sample.source), JobTypeNames[static_cast<std::size_t>(sample.type)],
+					thread, sample.start, sample.end);
+			}
+		}
+		log.size = 0;
+	}
+
+	if (!lock.owns_lock()) { return; }
+
+	for (auto& job : m_jobs)
+	{
+		if (!job.source) { continue; }
+		job.history[m_historyIndex] = job.periodTime;
+		job.historySize = std::min(job.historySize + 1, StatisticsPeriods);
+		job.periodTime = 0.f;
+	}
+	m_historyIndex = (m_historyIndex + 1) % StatisticsPeriods;
+	if (m_historyIndex == 0) { ageJobs(); }
+	++m_period;
+}
+
+
+
+
+void AudioEngineProfiler::ageJobs()
+{
+	for (auto slot = std::size_t{0}; slot < MaxJobs; ++slot)
+	{
+		// the sources are deleted at some point and their addresses reused, so jobs which
+		// didn't run for a whole interval go
+		auto& job = m_jobs[slot];
+		while (job.source && m_period - job.lastPeriod >= StatisticsPeriods)
+		{
+			removeJob(slot);
+		}
+	}
+}
+
+
+
+
+void AudioEngineProfiler::removeJob(std::size_t slot)
+{
+	// moves the following jobs of the probe sequence up, so findJob() never stops at the gap before them
+	for (auto next = (slot + 1) & (MaxJobs - 1); m_jobs[next].source; next = (next + 1) & (MaxJobs - 1))
+	{
+		// only jobs whose probe sequence starts outside of (slot, next] pass the gap
+		const auto home = jobSlot(m_jobs[next].type, m_jobs[next].source);
+		if (((next - home) & (MaxJobs - 1)) >= ((next - slot) & (MaxJobs - 1)))
+		{
+			m_jobs[slot] = std::move(m_jobs[next]);
+			slot = next;
+		}
+	}
+	m_jobs[slot] = JobEntry{};
+}
+
+
+
+
+AudioEngineProfiler::JobEntry* AudioEngineProfiler::findJob(JobType type, const void* source)
+{
+	const auto home = jobSlot(type, source);
+	for (auto i = std::size_t{0}; i < MaxJobs; ++i)
+	{
+		auto& job = m_jobs[(home + i) & (MaxJobs - 1)];
+		if (job.source == source && job.type == type) { return &job; }
+		if (!job.source)
+		{
+			job.type = type;
+			job.source = source;
+			job.historySize = 0;
+			job.lastPeriod = m_period;
+			return &job;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void AudioEngineProfiler::writeTraceEvent(
+	const QString& name, const char* category, int thread, std::int64_t start, std::int64_t end)
+{
+	if (!m_outputFile.isOpen()) { return; }
+
+	// substitute all at once, names might contain placeholders themselves
+	const auto event = QString{R"(%1{"name":"%2","cat":"%3","ph":"X","pid":0,"tid":%4,"ts":%5,"dur":%6})"}.arg(
+		m_firstTraceEvent ? QString{} : QString{",\n"},
+		escapeJson(name),
+		QString{category},
+		QString::number(thread),
+		QString::number(start / 1000.0, 'f', 3),
+		QString::number((end - start) / 1000.0, 'f', 3));
+	m_outputFile.write(event.toUtf8());
+	m_firstTraceEvent = false;
 }
 
 } // namespace lmms
@@ -36,67 +36,112 @@
 namespace lmms
 {
 
-AudioEngineWorkerThread::JobQueue AudioEngineWorkerThread::globalJobQueue;
+std::vector<ThreadableJob*> AudioEngineWorkerThread::jobGraph;
+std::atomic_size_t AudioEngineWorkerThread::jobsLeft = 0;
 QWaitCondition * AudioEngineWorkerThread::queueReadyWaitCond = nullptr;
 QList<AudioEngineWorkerThread *> AudioEngineWorkerThread::workerThreads;
 
-// implementation of internal JobQueue
-void AudioEngineWorkerThread::JobQueue::reset( OperationMode _opMode )
+// implementation of the job graph
+void AudioEngineWorkerThread::addJob( ThreadableJob * _job )
 {
-	m_writeIndex = 0;
-	m_itemsDone = 0;
-	m_opMode = _opMode;
+	// jobs already in the graph are still queued from this period
+	if( _job->requiresProcessing() && _job->state() != ThreadableJob::ProcessingState::Queued )
+	{
+		// update job state
+		_job->queue();
+		_job->m_dependents.clear();
+		// the extra dependency is released in startAndWaitForJobs(), so no
+		// job can become ready while the graph is still being seeded
+		_job->m_pendingDependencies.store(1, std::memory_order_relaxed);
+		jobGraph.push_back( _job );
+	}
 }
 
 
 
 
-void AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job )
+void AudioEngineWorkerThread::addDependency( ThreadableJob * job, ThreadableJob * dependency )
 {
-	if( _job->requiresProcessing() )
+	if( job->state() == ThreadableJob::ProcessingState::Queued &&
+		dependency->state() == ThreadableJob::ProcessingState::Queued )
 	{
-		// update job state
-		_job->queue();
-		// actually queue the job via atomic operations
-		auto index = m_writeIndex++;
-		if (index < JOB_QUEUE_SIZE) {
-			m_items[index] = _job;
-		} else {
-			qWarning() << "Job queue is full!";
-			++m_itemsDone;
+		dependency->m_dependents.push_back( job );
+		job->m_pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+
+
+void AudioEngineWorkerThread::runJob( ThreadableJob * job )
+{
+	// the job might already have been processed by someone else (e.g. an
+	// InstrumentPlayHandle processing its notes), in which case this is a no-op
+	job->process();
+
+	for( ThreadableJob * dependent : job->m_dependents )
+	{
+		if( dependent->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1 )
+		{
+			queueJob( dependent );
 		}
 	}
+
+	// must be last so nobody considers the graph done while we're still
+	// handing out our dependents
+	jobsLeft.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+
+
+
+void AudioEngineWorkerThread::queueJob( ThreadableJob * job )
+{
+	auto& queue = job->waitsExternally() ? m_waitingJobs : m_jobs;
+	if( !queue.push( job ) )
+	{
+		// queue is full, so just do it right now
+		runJob( job );
+	}
 }
 
 
 
-void AudioEngineWorkerThread::JobQueue::run()
+
+bool AudioEngineWorkerThread::stealJob( ThreadableJob * & job, Queue AudioEngineWorkerThread::* queue )
 {
-	bool processedJob = true;
-	while (processedJob && m_itemsDone < m_writeIndex)
+	// start with our neighbour so not all workers hammer the same queue
+	const int count = workerThreads.size();
+	for( int i = 1; i < count; ++i )
 	{
-		processedJob = false;
-		for (auto i = std::size_t{0}; i < m_writeIndex && i < JOB_QUEUE_SIZE; ++i)
+		if( (workerThreads.at((m_index + i) % count)->*queue).steal( job ) )
 		{
-			ThreadableJob * job = m_items[i].exchange(nullptr);
-			if( job )
-			{
-				job->process();
-				processedJob = true;
-				++m_itemsDone;
-			}
+			return true;
 		}
-		// always exit loop if we're not in dynamic mode
-		processedJob = processedJob && ( m_opMode == OperationMode::Dynamic );
 	}
+	return false;
 }
 
 
 
 
-void AudioEngineWorkerThread::JobQueue::wait()
+void AudioEngineWorkerThread::processJobs()
 {
-	while (m_itemsDone < m_writeIndex) { busyWaitHint(); }
+	while( jobsLeft.load(std::memory_order_acquire) > 0 )
+	{
+		ThreadableJob * job = nullptr;
+		// jobs waiting for the outside are picked up last, so whatever they
+		// wait for runs alongside everything else that's ready
+		if( m_jobs.pop( job ) || stealJob( job, &AudioEngineWorkerThread::m_jobs ) ||
+			m_waitingJobs.pop( job ) || stealJob( job, &AudioEngineWorkerThread::m_waitingJobs ) )
+		{
+			runJob( job );
+		}
+		else
+		{
+			busyWaitHint();
+		}
+	}
 }
 
 
@@ -107,20 +152,22 @@ void AudioEngineWorkerThread::JobQueue::wait()
 
 AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine ) :
 	QThread( audioEngine ),
+	m_jobs( JOB_QUEUE_SIZE ),
+	m_waitingJobs( JOB_QUEUE_SIZE ),
+	m_index( workerThreads.size() ),
 	m_quit( false )
 {
 	// initialize global static data
 	if( queueReadyWaitCond == nullptr )
 	{
 		queueReadyWaitCond = new QWaitCondition;
+		jobGraph.reserve( JOB_QUEUE_SIZE );
 	}
 
 	// keep track of all instantiated worker threads - this is used for
 	// processing the last worker thread "inline", see comments in
 	// AudioEngineWorkerThread::startAndWaitForJobs() for details
 	workerThreads << this;
-
-	resetJobQueue();
 }
 
 
@@ -137,7 +184,6 @@ AudioEngineWorkerThread::~AudioEngineWorkerThread()
 void AudioEngineWorkerThread::quit()
 {
 	m_quit = true;
-	resetJobQueue();
 }
 
 
@@ -145,12 +191,28 @@ void AudioEngineWorkerThread::quit()
 
 void AudioEngineWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global AudioEngine thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
-	globalJobQueue.run();
-	globalJobQueue.wait();
+	AudioEngineWorkerThread * inlineWorker = workerThreads.last();
+
+	jobsLeft.store(jobGraph.size(), std::memory_order_release);
+
+	// release the extra dependency of every job, which queues all jobs
+	// that don't depend on others
+	for( ThreadableJob * job : jobGraph )
+	{
+		if( job->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1 )
+		{
+			inlineWorker->queueJob( job );
+		}
+	}
+
+	queueReadyWaitCond->wakeAll();
+
+	inlineWorker->processJobs();
+
+	jobGraph.clear();
 }
 
 
@@ -165,7 +227,7 @@ void AudioEngineWorkerThread::run()
 	{
 		m.lock();
 		queueReadyWaitCond->wait( &m );
-		globalJobQueue.run();
+		processJobs();
 		m.unlock();
 	}
 }
@@ -24,6 +24,8 @@
 
 #include "AutomatableModel.h"
 
+#include <algorithm>
+
 #include <QRegularExpression>
 
 #include "lmms_math.h"
@@ -539,9 +541,17 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 
 ValueBuffer * AutomatableModel::valueBuffer()
 {
-	QMutexLocker m( &m_valueBufferMutex );
 	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	if (m_lastUpdatedPeriod.load(std::memory_order_acquire) == s_periodCounter)
+	{
+		return m_hasSampleExactData
+			? &m_valueBuffer
+			: nullptr;
+	}
+
+	QMutexLocker m( &m_valueBufferMutex );
+	// another thread may have calculated it while we were waiting
+	if (m_lastUpdatedPeriod.load(std::memory_order_relaxed) == s_periodCounter)
 	{
 		return m_hasSampleExactData
 			? &m_valueBuffer
@@ -581,8 +591,8 @@ ValueBuffer * AutomatableModel::valueBuffer()
 					"lacks implementation for a scale type");
 				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
 			m_hasSampleExactData = true;
+			m_lastUpdatedPeriod.store(s_periodCounter, std::memory_order_release);
 			return &m_valueBuffer;
 		}
 	}
@@ -602,8 +612,8 @@ ValueBuffer * AutomatableModel::valueBuffer()
 					{
 						nvalues[i] = fittedValue(values[i]);
 					}
-					m_lastUpdatedPeriod = s_periodCounter;
 					m_hasSampleExactData = true;
+					m_lastUpdatedPeriod.store(s_periodCounter, std::memory_order_release);
 					return &m_valueBuffer;
 				}
 		}
@@ -618,19 +628,72 @@ ValueBuffer * AutomatableModel::valueBuffer()
 	{
 		m_valueBuffer.interpolate(m_oldValue, val);
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
 		m_hasSampleExactData = true;
+		m_lastUpdatedPeriod.store(s_periodCounter, std::memory_order_release);
 		return &m_valueBuffer;
 	}
 
 	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
 	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
 	m_hasSampleExactData = false;
+	m_lastUpdatedPeriod.store(s_periodCounter, std::memory_order_release);
 	return nullptr;
 }
 
 
+
+
+void AutomatableModel::setAutomatedValues(const float* values, f_cnt_t offset, f_cnt_t frames)
+{
+	if (m_hasStrictStepSize || frames == 0) { return; }
+
+	auto model = this;
+	do
+	{
+		QMutexLocker m(&model->m_valueBufferMutex);
+
+		float* buffer = model->m_valueBuffer.values();
+		const auto end = std::min<f_cnt_t>(offset + frames, model->m_valueBuffer.length());
+		if (offset >= end)
+		{
+			model = model->m_nextLink;
+			continue;
+		}
+
+		if (model->m_lastUpdatedPeriod.load(std::memory_order_relaxed) != s_periodCounter
+			|| !model->m_hasSampleExactData)
+		{
+			std::fill(buffer, buffer + offset, model->m_oldValue);
+		}
+
+		const float min = model->minValue<float>();
+		const float max = model->maxValue<float>();
+		if (model->m_scaleType == ScaleType::Linear)
+		{
+			for (auto frame = offset; frame < end; ++frame)
+			{
+				buffer[frame] = std::clamp(values[frame - offset], min, max);
+			}
+		}
+		else
+		{
+			for (auto frame = offset; frame < end; ++frame)
+			{
+				buffer[frame] = std::clamp(model->scaledValue(values[frame - offset]), min, max);
+			}
+		}
+
+		// valueBuffer() interpolates from here once the automation ends
+		model->m_oldValue = buffer[end - 1];
+		model->m_hasSampleExactData = true;
+		model->m_lastUpdatedPeriod.store(s_periodCounter, std::memory_order_release);
+
+		model = model->m_nextLink;
+	}
+	while (model != this);
+}
+
+
 void AutomatableModel::unlinkControllerConnection()
 {
 	if( m_controllerConnection )
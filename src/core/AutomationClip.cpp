@@ -26,8 +26,12 @@
 
 #include "AutomationClip.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "AutomationNode.h"
 #include "AutomationClipView.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "KeyboardShortcuts.h"
 #include "LocaleHelper.h"
@@ -56,6 +60,7 @@ AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	m_lastRecordedValue( 0 )
 {
 	changeLength( TimePos( 1, 0 ) );
+	connect(this, &AutomationClip::dataChanged, this, &AutomationClip::updateTimeline);
 }
 
 
@@ -83,6 +88,7 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 		// Sets the node's clip to this one
 		m_timeMap[POS(it)].setClip(this);
 	}
+	connect(this, &AutomationClip::dataChanged, this, &AutomationClip::updateTimeline);
 }
 
 bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
@@ -102,6 +108,7 @@ bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 	}
 
 	m_objects.push_back(_obj);
+	AutomationTimeline::invalidate();
 
 	connect( _obj, SIGNAL(destroyed(lmms::jo_id_t)),
 			this, SLOT(objectDestroyed(lmms::jo_id_t)),
@@ -115,6 +122,33 @@ bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 
 
 
+void AutomationClip::removeObject(AutomatableModel* obj)
+{
+	QMutexLocker m(&m_clipMutex);
+
+	const auto it = std::find(m_objects.begin(), m_objects.end(), obj);
+	if (it == m_objects.end()) { return; }
+
+	m_objects.erase(it);
+	AutomationTimeline::invalidate();
+
+	emit dataChanged();
+}
+
+
+
+
+void AutomationClip::clearObjects()
+{
+	QMutexLocker m(&m_clipMutex);
+
+	m_objects.clear();
+	AutomationTimeline::invalidate();
+}
+
+
+
+
 void AutomationClip::setProgressionType(
 					ProgressionType _new_progression_type )
 {
@@ -642,6 +676,91 @@ float AutomationClip::valueAt( timeMap::const_iterator v, int offset ) const
 
 
 
+void AutomationClip::renderValues(float time, float step, float* values, std::size_t count) const
+{
+	QMutexLocker m(&m_clipMutex);
+
+	if (m_timeMap.isEmpty())
+	{
+		std::fill_n(values, count, 0.f);
+		return;
+	}
+
+	// number of values before the given time, but at least one more than rendered so far
+	const auto valuesBefore = [&](std::size_t rendered, float end) {
+		const auto before = static_cast<std::size_t>(std::max(std::ceil((end - time) / step), 0.f));
+		return std::clamp(before, rendered + 1, count);
+	};
+
+	auto i = std::size_t{0};
+	while (i < count)
+	{
+		const float t = time + i * step;
+		const auto nv = m_timeMap.upperBound(static_cast<int>(std::floor(t)));
+
+		if (nv == m_timeMap.begin())
+		{
+			// before the first node
+			const auto end = valuesBefore(i, POS(nv));
+			std::fill(values + i, values + end, 0.f);
+			i = end;
+			continue;
+		}
+
+		const auto v = std::prev(nv);
+		if (t == POS(v))
+		{
+			// When the time is exactly the node's time, we want the inValue
+			values[i++] = INVAL(v);
+			continue;
+		}
+
+		if (nv == m_timeMap.end())
+		{
+			// When the time is after the last node, we want the outValue of it
+			std::fill(values + i, values + count, OUTVAL(v));
+			return;
+		}
+
+		// the loops below are kept simple enough for the compiler to vectorize them
+		const auto end = valuesBefore(i, POS(nv));
+		const float offset = time - POS(v);
+		const float outValue = OUTVAL(v);
+		if (m_progressionType == ProgressionType::Discrete)
+		{
+			std::fill(values + i, values + end, outValue);
+		}
+		else if (m_progressionType == ProgressionType::Linear)
+		{
+			const float slope = (INVAL(nv) - outValue) / (POS(nv) - POS(v));
+			for (auto j = i; j < end; ++j)
+			{
+				values[j] = outValue + (offset + j * step) * slope;
+			}
+		}
+		else /* ProgressionType::CubicHermite, see valueAt() */
+		{
+			const auto numValues = static_cast<float>(POS(nv) - POS(v));
+			const float m1 = OUTTAN(v) * numValues * m_tension;
+			const float m2 = INTAN(nv) * numValues * m_tension;
+			const float inValue = INVAL(nv);
+			for (auto j = i; j < end; ++j)
+			{
+				const float t1 = (offset + j * step) / numValues;
+				const float t2 = t1 * t1, t3 = t2 * t1;
+				values[j] = (2 * t3 - 3 * t2 + 1) * outValue
+					+ (t3 - 2 * t2 + t1) * m1
+					+ (-2 * t3 + 3 * t2) * inValue
+					+ (t3 - t2) * m2;
+			}
+		}
+		i = end;
+	}
+}
+
+
+
+
 float *AutomationClip::valuesAfter( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_clipMutex);
@@ -1104,6 +1223,7 @@ void AutomationClip::objectDestroyed( jo_id_t _id )
 		{
 			//Assign to objIt so that this loop work even break; is removed.
 			objIt = m_objects.erase( objIt );
+			AutomationTimeline::invalidate();
 			break;
 		}
 	}
@@ -1127,6 +1247,7 @@ void AutomationClip::cleanObjects()
 		else
 		{
 			it = m_objects.erase( it );
+			AutomationTimeline::invalidate();
 		}
 	}
 }
@@ -1134,6 +1255,21 @@ void AutomationClip::cleanObjects()
 
 
 
+void AutomationClip::updateTimeline()
+{
+	// the timeline reads the nodes while playing, besides the models, which invalidate it whenever they change,
+	// it only needs to know whether there are any nodes at all, so recording doesn't have it compiled again on
+	// each tick
+	if (hasAutomation() != m_timelineHasAutomation)
+	{
+		m_timelineHasAutomation = hasAutomation();
+		AutomationTimeline::invalidate();
+	}
+}
+
+
+
+
 void AutomationClip::generateTangents()
 {
 	generateTangents(m_timeMap.begin(), m_timeMap.size());
@@ -0,0 +1,404 @@
+/*
+ * AutomationTimeline.cpp - automation of a track container, compiled for playback
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AutomationTimeline.h"
+
+#include <algorithm>
+
+#include "AudioEngine.h"
+#include "AutomationClip.h"
+#include "Engine.h"
+#include "PatternClip.h"
+#include "PatternStore.h"
+#include "PatternTrack.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+std::atomic<unsigned> AutomationTimeline::s_revision = 1;
+std::atomic<bool> AutomationTimeline::s_updateQueued = false;
+
+
+AutomationTimeline::AutomationTimeline() :
+	m_renderBuffer(Engine::audioEngine()->framesPerPeriod())
+{
+}
+
+
+
+
+void AutomationTimeline::invalidate()
+{
+	s_revision.fetch_add(1, std::memory_order_release);
+
+	// edits usually come in bunches, compile once after all of them
+	Song* song = Engine::getSong();
+	if (!song || s_updateQueued.exchange(true, std::memory_order_relaxed)) { return; }
+	QMetaObject::invokeMethod(song, [song] {
+		s_updateQueued.store(false, std::memory_order_relaxed);
+		song->updateAutomationTimeline();
+	}, Qt::QueuedConnection);
+}
+
+
+
+
+void AutomationTimeline::update(const TrackContainer* container, int clipNum, Track* globalAutomationTrack)
+{
+	const auto revision = s_revision.load(std::memory_order_acquire);
+	if (revision == m_compiledRevision && container == m_compiledContainer && clipNum == m_compiledClipNum) { return; }
+	m_compiledRevision = revision;
+	m_compiledContainer = container;
+	m_compiledClipNum = clipNum;
+
+	auto program = std::make_unique<Program>(Program{.container = container, .clipNum = clipNum, .revision = revision});
+	if (globalAutomationTrack) { addTrack(*program, globalAutomationTrack, clipNum); }
+	for (Track* track : container->tracks())
+	{
+		addTrack(*program, track, clipNum);
+	}
+
+	for (auto& target : program->targets)
+	{
+		// segments were added in the order they override each other, so
+		// of several segments starting at the same time the last one wins
+		auto& segments = target.segments;
+		std::stable_sort(segments.begin(), segments.end(),
+			[](const Segment& a, const Segment& b) { return a.start < b.start; });
+		const auto last = std::unique(segments.rbegin(), segments.rend(),
+			[](const Segment& a, const Segment& b) { return a.start == b.start; });
+		segments.erase(segments.begin(), last.base());
+	}
+
+	// swap it in on the audio thread, but delete the previous one here again
+	auto previous = std::make_shared<std::unique_ptr<Program>>();
+	Engine::audioEngine()->commitChange(
+		[this, program = program.release(), previous] { *previous = adopt(std::unique_ptr<Program>{program}); },
+		[previous] { previous->reset(); });
+}
+
+
+
+
+void AutomationTimeline::process(const TrackContainer* container, TimePos time, int clipNum)
+{
+	// after an edit, hold the values until the new program arrives, the current one may refer to deleted clips
+	const Program* program = m_program.get();
+	m_processed = program && program->container == container && program->clipNum == clipNum
+		&& program->revision == s_revision.load(std::memory_order_acquire);
+	if (!m_processed) { return; }
+
+	auto& targets = m_program->targets;
+
+	// Process recording
+	for (AutomationClip* clip : m_program->recordableClips)
+	{
+		TimePos relTime = time - clip->startPosition();
+		if (clip->isRecording() && relTime >= 0 && relTime < clip->length())
+		{
+			const AutomatableModel* recordedModel = clip->firstObject();
+			// The automation system really needs to be reworked.
+			// For whatever reason, the values in an automation clip are stored in un-un-scaled format, so if you
+			// are automating a log knob, when you draw an curve, the values being stored are not the actual values the
+			// knob will take, but instead the unscaled version of the unscaled numbers. The tooltip shows the number you expect, but if you double-click,
+			// you can see that the true values are stored by their inverse scaled value....which is wrong, since they weren't scaled in the first place...?
+			// Anyhow, in the meantime before we redo the automation system, when recording automations, we have to get the inverseScaledValue
+			// and store that so that when playing it back, it scales the value correctly.
+			clip->recordValue(relTime, recordedModel->inverseScaledValue(recordedModel->value<float>()));
+
+			const auto& targetIndex = m_program->targetIndex;
+			if (const auto index = targetIndex.constFind(recordedModel); index != targetIndex.constEnd())
+			{
+				targets[*index].recording = true;
+			}
+		}
+	}
+
+	if (clipNum >= 0)
+	{
+		// patterns are played one after another on the pattern tracks, see PatternStore::automatedValuesAt
+		const auto length = TimePos{Engine::patternStore()->lengthOfPattern(clipNum) * TimePos::ticksPerBar()};
+		time = std::min(time, length) + TimePos::ticksPerBar() * clipNum;
+	}
+
+	for (auto& target : targets)
+	{
+		AutomatableModel* model = target.model;
+		if (!model) { continue; }
+
+		const auto segment = findSegment(target, time);
+		if (segment == NoSegment)
+		{
+			target.recording = false;
+			target.rendered = false;
+			// moves the control of the model back to any connected controller again
+			if (target.active) { model->setUseControllerValue(true); }
+			target.active = false;
+			continue;
+		}
+		target.active = true;
+
+		const auto isRecording = target.recording;
+		target.recording = false;
+		target.rendered = !isRecording;
+		model->setUseControllerValue(isRecording);
+
+		if (!isRecording)
+		{
+			const auto& current = target.segments[segment];
+			target.clipTime = clipTime(current, time, target.held);
+			target.value = current.clip->valueAt(target.clipTime);
+			/* TODO
+			 * Remove scaleValue() from here when automation editor's
+			 * Y axis can be set to logarithmic, and automation clips store
+			 * the actual values, and not the invertedScaledValue.
+			 */
+			model->setValue(model->scaledValue(target.value), true);
+		}
+	}
+}
+
+
+
+
+void AutomationTimeline::render(float tickOffset, float ticksPerFrame, f_cnt_t offset, f_cnt_t frames)
+{
+	if (!m_processed) { return; }
+
+	// the value buffers are a period long as well, so there's nothing to render beyond it
+	frames = std::min<f_cnt_t>(frames, m_renderBuffer.size());
+	float* values = m_renderBuffer.data();
+
+	for (auto& target : m_program->targets)
+	{
+		AutomatableModel* model = target.model;
+		if (!model || !target.active || !target.rendered) { continue; }
+
+		if (target.held)
+		{
+			std::fill_n(values, frames, target.value);
+		}
+		else
+		{
+			const auto& segment = target.segments[target.cursor];
+			segment.clip->renderValues(target.clipTime.getTicks() + tickOffset, ticksPerFrame, values, frames);
+		}
+		model->setAutomatedValues(values, offset, frames);
+	}
+}
+
+
+
+
+void AutomationTimeline::release()
+{
+	if (!m_program) { return; }
+
+	for (auto& target : m_program->targets)
+	{
+		if (target.active && target.model) { target.model->setUseControllerValue(true); }
+		target.active = false;
+	}
+}
+
+
+
+
+void AutomationTimeline::clear()
+{
+	m_program.reset();
+	m_processed = false;
+	m_compiledContainer = nullptr;
+	m_compiledRevision = 0;
+}
+
+
+
+
+auto AutomationTimeline::adopt(std::unique_ptr<Program> program) -> std::unique_ptr<Program>
+{
+	// models which stay automated keep their state, all others go back to their controllers
+	if (m_program)
+	{
+		const auto& targetIndex = program->targetIndex;
+		for (const auto& target : m_program->targets)
+		{
+			if (!target.active || !target.model) { continue; }
+
+			if (const auto index = targetIndex.constFind(target.model.data()); index != targetIndex.constEnd())
+			{
+				program->targets[*index].active = true;
+			}
+			else
+			{
+				target.model->setUseControllerValue(true);
+			}
+		}
+	}
+
+	m_processed = false;
+	m_program.swap(program);
+	return program;
+}
+
+
+
+
+void AutomationTimeline::addTrack(Program& program, Track* track, int clipNum)
+{
+	if (track->type() == Track::Type::Automation)
+	{
+		for (Clip* clip : track->getClips())
+		{
+			if (auto automationClip = dynamic_cast<AutomationClip*>(clip))
+			{
+				program.recordableClips.push_back(automationClip);
+			}
+		}
+	}
+
+	if (track->isMuted()) { return; }
+
+	switch (track->type())
+	{
+	case Track::Type::Automation:
+	case Track::Type::HiddenAutomation:
+	case Track::Type::Pattern:
+		break;
+	default:
+		return;
+	}
+
+	auto clips = Track::clipVector{};
+	if (clipNum < 0)
+	{
+		clips = track->getClips();
+		std::stable_sort(clips.begin(), clips.end(), Clip::comparePosition);
+	}
+	else
+	{
+		Q_ASSERT(track->numOfClips() > clipNum);
+		clips.push_back(track->getClip(clipNum));
+	}
+
+	for (Clip* clip : clips)
+	{
+		if (clip->isMuted()) { continue; }
+
+		if (auto automationClip = dynamic_cast<AutomationClip*>(clip))
+		{
+			addClip(program, automationClip, clip->startPosition(), nullptr, 0);
+		}
+		else if (auto patternClip = dynamic_cast<PatternClip*>(clip))
+		{
+			const auto patternIndex = static_cast<PatternTrack*>(track)->patternIndex();
+			for (Track* patternStoreTrack : Engine::patternStore()->tracks())
+			{
+				if (patternStoreTrack->isMuted() || patternStoreTrack->numOfClips() <= patternIndex) { continue; }
+
+				auto innerClip = dynamic_cast<AutomationClip*>(patternStoreTrack->getClip(patternIndex));
+				if (innerClip && !innerClip->isMuted())
+				{
+					addClip(program, innerClip, clip->startPosition(), patternClip, patternIndex);
+				}
+			}
+		}
+	}
+}
+
+
+
+
+void AutomationTimeline::addClip(Program& program, AutomationClip* clip, tick_t start, const PatternClip* pattern,
+	int patternIndex)
+{
+	if (!clip->hasAutomation()) { return; }
+
+	for (const auto& model : clip->objects())
+	{
+		if (!model) { continue; }
+
+		auto index = program.targetIndex.find(model);
+		if (index == program.targetIndex.end())
+		{
+			index = program.targetIndex.insert(model, program.targets.size());
+			program.targets.push_back(Target{.model = model});
+		}
+		program.targets[*index].segments.push_back({start, clip, pattern, patternIndex});
+	}
+}
+
+
+
+
+std::size_t AutomationTimeline::findSegment(Target& target, tick_t time)
+{
+	const auto& segments = target.segments;
+	auto& cursor = target.cursor;
+
+	if (cursor < segments.size() && segments[cursor].start <= time)
+	{
+		// playing on, usually still in the same segment or in the next one
+		if (cursor + 1 == segments.size() || segments[cursor + 1].start > time) { return cursor; }
+		if (cursor + 2 == segments.size() || segments[cursor + 2].start > time) { return ++cursor; }
+	}
+
+	const auto it = std::upper_bound(segments.begin(), segments.end(), time,
+		[](tick_t t, const Segment& segment) { return t < segment.start; });
+	if (it == segments.begin()) { return NoSegment; }
+
+	cursor = static_cast<std::size_t>(it - segments.begin()) - 1;
+	return cursor;
+}
+
+
+
+
+TimePos AutomationTimeline::clipTime(const Segment& segment, TimePos time, bool& held)
+{
+	held = false;
+	if (segment.pattern)
+	{
+		// see TrackContainer::automatedValuesFromTracks and PatternStore::automatedValuesAt
+		const auto patternLength = Engine::patternStore()->lengthOfPattern(segment.patternIndex) * TimePos::ticksPerBar();
+		TimePos patTime = time - segment.pattern->startPosition();
+		if (patTime >= segment.pattern->length())
+		{
+			patTime = segment.pattern->length();
+			held = true;
+		}
+		patTime = patTime % patternLength;
+		time = patTime + TimePos::ticksPerBar() * segment.patternIndex;
+	}
+
+	const AutomationClip* clip = segment.clip;
+	TimePos relTime = time - clip->startPosition() - clip->startTimeOffset();
+	if (!clip->isInPattern() && relTime >= clip->length() - clip->startTimeOffset())
+	{
+		relTime = clip->length() - clip->startTimeOffset();
+		held = true;
+	}
+	return relTime;
+}
+
+} // namespace lmms
@@ -26,30 +26,231 @@
 
 #include "BufferManager.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <semaphore>
+#include <thread>
+
+#include <QtGlobal>
+
+#include "Hardware.h"
+#include "LocklessFreeList.h"
 #include "SampleFrame.h"
 
 
 namespace lmms
 {
 
+namespace
+{
+
+constexpr auto BuffersPerChunk = std::size_t{256};
+constexpr auto MaxChunks = std::size_t{256};
+constexpr auto InitialChunks = std::size_t{2};
+//! The pool is grown once fewer buffers are free
+constexpr auto LowWaterMark = BuffersPerChunk / 4;
+constexpr auto LocalCacheSize = std::size_t{16};
+constexpr auto Alignment = std::align_val_t{hardware_destructive_interference_size};
+
+std::size_t s_bufferStride = 0; // distance between buffers in frames
+std::array<std::atomic<SampleFrame*>, MaxChunks> s_chunks{};
+std::atomic_size_t s_numChunks = 0;
+std::unique_ptr<LocklessFreeList> s_freeList;
+
+std::atomic_size_t s_inUse = 0;
+std::atomic_size_t s_highWaterMark = 0;
+std::atomic_size_t s_misses = 0;
+
+
+SampleFrame* allocateFrames(std::size_t frames)
+{
+	auto buffer = static_cast<SampleFrame*>(::operator new(frames * sizeof(SampleFrame), Alignment));
+	std::uninitialized_default_construct_n(buffer, frames);
+	return buffer;
+}
+
+
+SampleFrame* bufferAt(std::uint32_t index)
+{
+	return s_chunks[index / BuffersPerChunk].load(std::memory_order_acquire)
+		+ (index % BuffersPerChunk) * s_bufferStride;
+}
+
+
+//! Returns LocklessFreeList::Empty if @p buffer is not part of the pool
+std::uint32_t indexOf(const SampleFrame* buffer)
+{
+	const auto address = reinterpret_cast<std::uintptr_t>(buffer);
+	const auto chunkBytes = BuffersPerChunk * s_bufferStride * sizeof(SampleFrame);
+	const auto numChunks = s_numChunks.load(std::memory_order_acquire);
+	for (auto chunk = std::size_t{0}; chunk < numChunks; ++chunk)
+	{
+		const auto begin = reinterpret_cast<std::uintptr_t>(s_chunks[chunk].load(std::memory_order_relaxed));
+		if (address >= begin && address < begin + chunkBytes)
+		{
+			const auto buffer = (address - begin) / (s_bufferStride * sizeof(SampleFrame));
+			return static_cast<std::uint32_t>(chunk * BuffersPerChunk + buffer);
+		}
+	}
+	return LocklessFreeList::Empty;
+}
+
+
+bool addChunk()
+{
+	const auto chunk = s_numChunks.load(std::memory_order_relaxed);
+	if (chunk == MaxChunks) { return false; }
+
+	s_chunks[chunk].store(allocateFrames(BuffersPerChunk * s_bufferStride), std::memory_order_release);
+	s_numChunks.store(chunk + 1, std::memory_order_release);
+
+	const auto first = static_cast<std::uint32_t>(chunk * BuffersPerChunk);
+	const auto last = static_cast<std::uint32_t>(first + BuffersPerChunk - 1);
+	for (auto index = first; index < last; ++index)
+	{
+		s_freeList->link(index, index + 1);
+	}
+	s_freeList->pushChain(first, last, BuffersPerChunk);
+	return true;
+}
+
+
+//! Grows the pool in the background, so the audio threads never allocate
+class PoolGrower
+{
+public:
+	~PoolGrower()
+	{
+		if (m_thread.joinable())
+		{
+			m_quit = true;
+			m_request.release();
+			m_thread.join();
+		}
+	}
+
+	void start()
+	{
+		if (!m_thread.joinable()) { m_thread = std::thread{[this] { run(); }}; }
+	}
+
+	void request()
+	{
+		if (!m_requested.exchange(true, std::memory_order_relaxed)) { m_request.release(); }
+	}
+
+private:
+	void run()
+	{
+		while (true)
+		{
+			m_request.acquire();
+			if (m_quit) { break; }
+
+			while (s_freeList->size() < LowWaterMark && addChunk()) {}
+			m_requested.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	std::thread m_thread;
+	std::binary_semaphore m_request{0};
+	std::atomic_bool m_requested = false;
+	std::atomic_bool m_quit = false;
+};
+
+// defined after the pool data, so it stops before that is destroyed
+PoolGrower s_grower;
+
+
+//! A few buffers per thread, so most acquire/release pairs don't touch the shared free list
+thread_local LocalFreeListCache<LocalCacheSize> t_cache;
+
+} // namespace
+
+
 f_cnt_t BufferManager::s_framesPerPeriod;
 
 void BufferManager::init( f_cnt_t fpp )
 {
 	s_framesPerPeriod = fpp;
+
+	if (s_bufferStride != 0)
+	{
+		// the pool can't be resized, acquire() uses the heap if its buffers are too small
+		if (fpp > s_bufferStride)
+		{
+			qWarning("BufferManager: Period size grew to %d frames, pool can't be used", static_cast<int>(fpp));
+		}
+		return;
+	}
+
+	// let every buffer start on its own cache line
+	constexpr auto framesPerCacheLine = std::max<std::size_t>(1, hardware_destructive_interference_size / sizeof(SampleFrame));
+	s_bufferStride = (fpp + framesPerCacheLine - 1) / framesPerCacheLine * framesPerCacheLine;
+
+	s_freeList = std::make_unique<LocklessFreeList>(BuffersPerChunk * MaxChunks);
+	for (auto chunk = std::size_t{0}; chunk < InitialChunks; ++chunk)
+	{
+		addChunk();
+	}
+	s_grower.start();
 }
 
 
 SampleFrame* BufferManager::acquire()
 {
-	return new SampleFrame[s_framesPerPeriod];
+	auto index = LocklessFreeList::Empty;
+	if (s_framesPerPeriod <= s_bufferStride)
+	{
+		index = t_cache.pop(*s_freeList);
+		if (s_freeList->size() < LowWaterMark) { s_grower.request(); }
+	}
+
+	const auto inUse = s_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+	auto highWaterMark = s_highWaterMark.load(std::memory_order_relaxed);
+	while (inUse > highWaterMark
+		&& !s_highWaterMark.compare_exchange_weak(highWaterMark, inUse, std::memory_order_relaxed)) {}
+
+	if (index == LocklessFreeList::Empty)
+	{
+		// pool ran dry before the grower could catch up
+		s_misses.fetch_add(1, std::memory_order_relaxed);
+		return allocateFrames(s_framesPerPeriod);
+	}
+	return bufferAt(index);
 }
 
 
 
 void BufferManager::release( SampleFrame* buf )
 {
-	delete[] buf;
+	if (buf == nullptr) { return; }
+
+	s_inUse.fetch_sub(1, std::memory_order_relaxed);
+
+	const auto index = indexOf(buf);
+	if (index == LocklessFreeList::Empty)
+	{
+		::operator delete(buf, Alignment);
+		return;
+	}
+
+	t_cache.push(*s_freeList, index);
+}
+
+
+
+BufferManager::Statistics BufferManager::statistics()
+{
+	return {
+		s_numChunks.load(std::memory_order_relaxed) * BuffersPerChunk,
+		s_inUse.load(std::memory_order_relaxed),
+		s_highWaterMark.load(std::memory_order_relaxed),
+		s_misses.load(std::memory_order_relaxed)
+	};
 }
 
 } // namespace lmms
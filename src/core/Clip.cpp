@@ -28,6 +28,7 @@
 
 #include "AutomationEditor.h"
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "Engine.h"
 #include "GuiApplication.h"
 #include "Song.h"
@@ -56,6 +57,7 @@ Clip::Clip( Track * track ) :
 	{
 		getTrack()->addClip( this );
 	}
+	connect(&m_mutedModel, &BoolModel::dataChanged, [] { AutomationTimeline::invalidate(); });
 	setJournalling( false );
 	movePosition( 0 );
 	changeLength( 0 );
@@ -85,6 +87,7 @@ Clip::Clip(const Clip& other):
 	{
 		getTrack()->addClip(this);
 	}
+	connect(&m_mutedModel, &BoolModel::dataChanged, [] { AutomationTimeline::invalidate(); });
 }
 
 /*! \brief Destroy a Clip
@@ -120,6 +123,8 @@ void Clip::movePosition( const TimePos & pos )
 		Engine::audioEngine()->requestChangeInModel();
 		m_startPosition = newPos;
 		Engine::audioEngine()->doneChangeInModel();
+		if (m_track) { m_track->invalidateClipIndex(); }
+		AutomationTimeline::invalidate();
 		Engine::getSong()->updateLength();
 		emit positionChanged();
 	}
@@ -138,6 +143,7 @@ void Clip::movePosition( const TimePos & pos )
 void Clip::changeLength( const TimePos & length )
 {
 	m_length = length;
+	if (m_track) { m_track->invalidateClipIndex(); }
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
@@ -159,14 +159,18 @@ void Controller::triggerFrameCounter()
 	for (Controller * controller : s_controllers)
 	{
 		// This signal is for updating values for both stubborn knobs and for
-		// painting.  If we ever get all the widgets to use or at least check
-		// currentValue() then we can throttle the signal and only use it for
-		// GUI.
-		emit controller->valueChanged();
+		// painting. Models connected to the controller (and the effects and
+		// instruments reading their parameters in dataChanged() slots) must
+		// see every period on the audio thread, both live and when exporting.
+		// Repainting is throttled by the views. A controller nothing is
+		// connected to has no one to notify.
+		if (controller->connectionCount() > 0)
+		{
+			emit controller->valueChanged();
+		}
 	}
 
 	s_periods ++;
-	//emit s_signaler.triggerValueChanged();
 }
 
 
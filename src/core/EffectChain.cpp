@@ -27,10 +27,13 @@
 
 #include <QDomElement>
 #include <cassert>
+#include <utility>
 
 #include "AudioBuffer.h"
+#include "AudioEngine.h"
 #include "Effect.h"
 #include "DummyEffect.h"
+#include "Engine.h"
 #include "MixHelpers.h"
 
 namespace lmms
@@ -49,7 +52,14 @@ EffectChain::EffectChain( Model * _parent ) :
 
 EffectChain::~EffectChain()
 {
-	clear();
+	// pending changes refer to this chain
+	Engine::audioEngine()->flushChanges();
+
+	emit aboutToClear();
+	for (Effect* effect : m_effects)
+	{
+		delete effect;
+	}
 }
 
 
@@ -79,8 +89,6 @@ void EffectChain::loadSettings( const QDomElement & _this )
 {
 	clear();
 
-	// TODO This method should probably also lock the audio engine
-
 	m_enabledModel.loadSettings( _this, "enabled" );
 
 	const int plugin_cnt = _this.attribute( "numofeffects" ).toInt();
@@ -113,6 +121,7 @@ void EffectChain::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
 	}
+	publishEffects();
 
 	emit dataChanged();
 }
@@ -122,9 +131,8 @@ void EffectChain::loadSettings( const QDomElement & _this )
 
 void EffectChain::appendEffect( Effect * _effect )
 {
-	Engine::audioEngine()->requestChangeInModel();
 	m_effects.push_back(_effect);
-	Engine::audioEngine()->doneChangeInModel();
+	publishEffects();
 
 	m_enabledModel.setValue( true );
 
@@ -136,17 +144,13 @@ void EffectChain::appendEffect( Effect * _effect )
 
 void EffectChain::removeEffect( Effect * _effect )
 {
-	Engine::audioEngine()->requestChangeInModel();
-
 	auto found = std::find(m_effects.begin(), m_effects.end(), _effect);
 	if( found == m_effects.end() )
 	{
-		Engine::audioEngine()->doneChangeInModel();
 		return;
 	}
 	m_effects.erase( found );
-
-	Engine::audioEngine()->doneChangeInModel();
+	publishEffects();
 
 	if (m_effects.empty())
 	{
@@ -166,6 +170,7 @@ void EffectChain::moveDown( Effect * _effect )
 		auto it = std::find(m_effects.begin(), m_effects.end(), _effect);
 		assert(it != m_effects.end());
 		std::swap(*std::next(it), *it);
+		publishEffects();
 	}
 }
 
@@ -179,6 +184,7 @@ void EffectChain::moveUp( Effect * _effect )
 		auto it = std::find(m_effects.begin(), m_effects.end(), _effect);
 		assert(it != m_effects.end());
 		std::swap(*std::prev(it), *it);
+		publishEffects();
 	}
 }
 
@@ -194,9 +200,11 @@ bool EffectChain::processAudioBuffer(AudioBuffer& buffer)
 
 	buffer.sanitizeAll();
 
+	auto& profiler = Engine::audioEngine()->profiler();
 	bool moreEffects = false;
-	for (Effect* effect : m_effects)
+	for (Effect* effect : m_processedEffects)
 	{
+		const auto probe = AudioEngineProfiler::JobProbe{profiler, AudioEngineProfiler::JobType::Effect, effect};
 		moreEffects |= effect->processAudioBuffer(buffer);
 	}
 
@@ -206,23 +214,50 @@ bool EffectChain::processAudioBuffer(AudioBuffer& buffer)
 
 
 
+f_cnt_t EffectChain::latencyFrames() const
+{
+	if (!m_enabledModel.value()) { return 0; }
+
+	// sleeping effects still count, their latency comes back on wake-up
+	auto latency = f_cnt_t{0};
+	for (const Effect* effect : m_processedEffects)
+	{
+		if (effect->isEnabled() && effect->isOkay() && !effect->dontRun())
+		{
+			latency += effect->latencyFrames();
+		}
+	}
+	return latency;
+}
+
+
+
+
 void EffectChain::clear()
 {
 	emit aboutToClear();
 
-	Engine::audioEngine()->requestChangeInModel();
-
-	while (m_effects.size())
+	const auto effects = std::exchange(m_effects, {});
+	publishEffects();
+	for (Effect* effect : effects)
 	{
-		auto e = m_effects[m_effects.size() - 1];
-		m_effects.pop_back();
-		delete e;
+		// deleted once the audio thread stopped processing it
+		Engine::audioEngine()->retire(effect);
 	}
 
-	Engine::audioEngine()->doneChangeInModel();
-
 	m_enabledModel.setValue( false );
 }
 
 
+
+
+void EffectChain::publishEffects()
+{
+	// the old list is freed along with the change, on the main thread
+	Engine::audioEngine()->commitChange([this, effects = m_effects]() mutable {
+		m_processedEffects.swap(effects);
+	});
+}
+
+
 } // namespace lmms
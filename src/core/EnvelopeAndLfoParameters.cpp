@@ -24,6 +24,9 @@
 
 #include "EnvelopeAndLfoParameters.h"
 
+#include <algorithm>
+#include <array>
+
 #include <QDomElement>
 #include <QFileInfo>
 
@@ -247,9 +250,30 @@ inline sample_t EnvelopeAndLfoParameters::lfoShapeSample( f_cnt_t _frame_offset
 void EnvelopeAndLfoParameters::updateLfoShapeData()
 {
 	const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
-	for( f_cnt_t offset = 0; offset < frames; ++offset )
+	const auto shape = static_cast<LfoShape>(m_lfoWaveModel.value());
+	if (shape == LfoShape::UserDefinedWave || shape == LfoShape::RandomWave)
+	{
+		for( f_cnt_t offset = 0; offset < frames; ++offset )
+		{
+			m_lfoShapeData[offset] = lfoShapeSample( offset );
+		}
+		m_bad_lfoShapeData = false;
+		return;
+	}
+
+	auto waveShape = Oscillator::WaveShape::Sine;
+	switch (shape)
+	{
+		case LfoShape::TriangleWave: waveShape = Oscillator::WaveShape::Triangle; break;
+		case LfoShape::SquareWave: waveShape = Oscillator::WaveShape::Square; break;
+		case LfoShape::SawWave: waveShape = Oscillator::WaveShape::Saw; break;
+		default: break;
+	}
+	const float increment = 1.0f / m_lfoOscillationFrames;
+	Oscillator::fillLfo(waveShape, m_lfoShapeData, (m_lfoFrame % m_lfoOscillationFrames) * increment, increment, frames);
+	for (f_cnt_t offset = 0; offset < frames; ++offset)
 	{
-		m_lfoShapeData[offset] = lfoShapeSample( offset );
+		m_lfoShapeData[offset] *= m_lfoAmount;
 	}
 	m_bad_lfoShapeData = false;
 }
@@ -300,35 +324,50 @@ void EnvelopeAndLfoParameters::fillLevel( float * _buf, f_cnt_t _frame,
 
 	fillLfoLevel( _buf, _frame, _frames );
 
-	for( f_cnt_t offset = 0; offset < _frames; ++offset, ++_buf, ++_frame )
+	// The envelope is made of up to four stretches: predelay/attack/hold/decay
+	// from its table, sustain, release from its table and silence. Each of
+	// them is filled by a plain loop, which the compiler can vectorize.
+	auto env = std::array<float, DEFAULT_BUFFER_SIZE>{};
+	for (f_cnt_t done = 0; done < _frames; done += env.size())
 	{
-		float env_level;
-		if( _frame < _release_begin )
+		const auto frames = std::min<f_cnt_t>(_frames - done, env.size());
+		const f_cnt_t begin = _frame + done;
+		const f_cnt_t end = begin + frames;
+
+		f_cnt_t frame = begin;
+		const auto fillUntil = [&](f_cnt_t until, auto level)
 		{
-			if( _frame < m_pahdFrames )
+			until = std::clamp(until, frame, end);
+			for (; frame < until; ++frame)
 			{
-				env_level = m_pahdEnv[_frame];
+				env[frame - begin] = level(frame);
 			}
-			else
+		};
+
+		const float releaseLevel = _release_begin < m_pahdFrames ? m_pahdEnv[_release_begin] : m_sustainLevel;
+		const auto sustainEnd = _release_begin;
+		fillUntil(std::min(m_pahdFrames, sustainEnd), [this](f_cnt_t f) { return m_pahdEnv[f]; });
+		fillUntil(sustainEnd, [this](f_cnt_t) { return m_sustainLevel; });
+		fillUntil(_release_begin + m_rFrames,
+			[this, _release_begin, releaseLevel](f_cnt_t f) { return m_rEnv[f - _release_begin] * releaseLevel; });
+		fillUntil(end, [](f_cnt_t) { return 0.0f; });
+
+		// at this point, _buf holds the LFO level
+		float* buf = _buf + done;
+		if (m_controlEnvAmountModel.value())
+		{
+			for (f_cnt_t offset = 0; offset < frames; ++offset)
 			{
-				env_level = m_sustainLevel;
+				buf[offset] = env[offset] * (0.5f + buf[offset]);
 			}
 		}
-		else if( ( _frame - _release_begin ) < m_rFrames )
-		{
-			env_level = m_rEnv[_frame - _release_begin] *
-				( ( _release_begin < m_pahdFrames ) ?
-				m_pahdEnv[_release_begin] : m_sustainLevel );
-		}
 		else
 		{
-			env_level = 0.0f;
+			for (f_cnt_t offset = 0; offset < frames; ++offset)
+			{
+				buf[offset] = env[offset] + buf[offset];
+			}
 		}
-
-		// at this point, *_buf is LFO level
-		*_buf = m_controlEnvAmountModel.value() ?
-			env_level * ( 0.5f + *_buf ) :
-			env_level + *_buf;
 	}
 }
 
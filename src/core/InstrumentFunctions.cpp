@@ -276,6 +276,17 @@ void InstrumentFunctionNoteStacking::processNote( NotePlayHandle * _n )
 
 
 
+int InstrumentFunctionNoteStacking::notesPerNote() const
+{
+	if (!m_chordsEnabledModel.value()) { return 1; }
+
+	const auto& chord = ChordTable::getInstance().chords()[m_chordsModel.value()];
+	return 1 + chord.size() * static_cast<int>(std::ceil(m_chordRangeModel.value()));
+}
+
+
+
+
 void InstrumentFunctionNoteStacking::saveSettings( QDomDocument & _doc, QDomElement & _this )
 {
 	m_chordsEnabledModel.saveSettings( _doc, _this, "chord-enabled" );
@@ -35,17 +35,30 @@ namespace lmms
 
 InstrumentPlayHandle::InstrumentPlayHandle(Instrument * instrument, InstrumentTrack* instrumentTrack) :
 	PlayHandle(Type::InstrumentPlayHandle),
-	m_instrument(instrument)
+	m_instrument(instrument),
+	m_finishJob(this)
 {
 	setAudioBusHandle(instrumentTrack->audioBusHandle());
 }
 
 void InstrumentPlayHandle::play(SampleFrame* working_buffer)
 {
-	InstrumentTrack * instrumentTrack = m_instrument->instrumentTrack();
+	processNotes();
 
+	if (m_playsAsynchronously)
+	{
+		m_instrument->startPlay();
+		// the audio engine collects the output later on if it queued finishJob()
+		if (m_finishJob.state() == ThreadableJob::ProcessingState::Queued) { return; }
+	}
+
+	finishPlay(working_buffer);
+}
+
+void InstrumentPlayHandle::processNotes()
+{
 	// ensure that all our nph's have been processed first
-	auto nphv = NotePlayHandle::nphsOfInstrumentTrack(instrumentTrack, true);
+	auto nphv = NotePlayHandle::nphsOfInstrumentTrack(m_instrument->instrumentTrack(), true);
 
 	bool nphsLeft;
 	do
@@ -61,12 +74,29 @@ void InstrumentPlayHandle::play(SampleFrame* working_buffer)
 		}
 	}
 	while (nphsLeft);
+}
 
+void InstrumentPlayHandle::finishPlay(SampleFrame* working_buffer)
+{
 	m_instrument->play(working_buffer);
 
 	// Process the audio buffer that the instrument has just worked on...
 	const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
-	instrumentTrack->processAudioBuffer(working_buffer, frames, nullptr);
+	m_instrument->instrumentTrack()->processAudioBuffer(working_buffer, frames, nullptr);
+}
+
+bool InstrumentPlayHandle::startPeriod()
+{
+	m_playsAsynchronously = m_instrument->playsAsynchronously();
+	return m_playsAsynchronously;
+}
+
+void InstrumentPlayHandle::FinishJob::doProcessing()
+{
+	const auto probe = AudioEngineProfiler::JobProbe{Engine::audioEngine()->profiler(),
+		AudioEngineProfiler::JobType::InstrumentOutput, m_handle->audioBusHandle()};
+
+	m_handle->finishPlay(m_handle->buffer());
 }
 
 bool InstrumentPlayHandle::isFromTrack(const Track* track) const
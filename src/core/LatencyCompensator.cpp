@@ -0,0 +1,74 @@
+/*
+ * LatencyCompensator.cpp - delays a signal to line it up with slower signal paths
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LatencyCompensator.h"
+
+#include <algorithm>
+
+namespace lmms
+{
+
+LatencyCompensator::LatencyCompensator()
+{
+	m_buffer.reserve(MaxDelay);
+}
+
+
+
+
+void LatencyCompensator::setDelay(f_cnt_t frames)
+{
+	frames = std::min(frames, MaxDelay);
+	if (frames == m_delay) { return; }
+
+	m_delay = frames;
+	m_position = 0;
+	m_signalFrames = 0;
+	// assign() keeps the capacity reserved in the constructor
+	m_buffer.assign(m_delay, SampleFrame{});
+}
+
+
+
+
+void LatencyCompensator::process(const SampleFrame* in, SampleFrame* out, f_cnt_t frames)
+{
+	if (m_delay == 0)
+	{
+		if (!in) { std::fill_n(out, frames, SampleFrame{}); }
+		else if (in != out) { std::copy_n(in, frames, out); }
+		return;
+	}
+
+	for (f_cnt_t f = 0; f < frames; ++f)
+	{
+		const auto input = in ? in[f] : SampleFrame{};
+		out[f] = m_buffer[m_position];
+		m_buffer[m_position] = input;
+		if (++m_position == m_delay) { m_position = 0; }
+	}
+
+	// the last input frame comes out after m_delay more frames
+	m_signalFrames = in ? m_delay : m_signalFrames - std::min(m_signalFrames, frames);
+}
+
+} // namespace lmms
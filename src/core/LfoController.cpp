@@ -89,7 +89,6 @@ void LfoController::updateValueBuffer()
 {
 	m_phaseOffset = m_phaseModel.value() / 360.0;
 	float phase = m_currentPhase + m_phaseOffset;
-	float phasePrev = 0.0f;
 
 	// roll phase up until we're in sync with period counter
 	m_bufferLastUpdated++;
@@ -100,47 +99,59 @@ void LfoController::updateValueBuffer()
 		m_bufferLastUpdated += diff;
 	}
 
-	float amount = m_amountModel.value();
-	ValueBuffer *amountBuffer = m_amountModel.valueBuffer();
-	int amountInc = amountBuffer ? 1 : 0;
-	float *amountPtr = amountBuffer ? &(amountBuffer->values()[ 0 ] ) : &amount;
+	const float amount = m_amountModel.value();
+	const ValueBuffer* amountBuffer = m_amountModel.valueBuffer();
+	const float base = m_baseModel.value();
+	const float increment = 1.0f / m_duration;
+	const auto frames = static_cast<f_cnt_t>(m_valueBuffer.length());
+	float* values = m_valueBuffer.values();
 	Oscillator::WaveShape waveshape = static_cast<Oscillator::WaveShape>(m_waveModel.value());
 
-	for( float& f : m_valueBuffer )
+	switch (waveshape)
 	{
-		float currentSample = 0;
-		switch (waveshape)
-		{
-		case Oscillator::WaveShape::WhiteNoise:
+	case Oscillator::WaveShape::WhiteNoise:
+	{
+		float phasePrev = 0.0f;
+		for (f_cnt_t frame = 0; frame < frames; ++frame)
 		{
-			if (absFraction(phase) < absFraction(phasePrev))
+			const float currentPhase = phase + frame * increment;
+			if (absFraction(currentPhase) < absFraction(phasePrev))
 			{
 				// Resample when phase period has completed
-				m_heldSample = m_sampleFunction(phase);
+				m_heldSample = m_sampleFunction(currentPhase);
 			}
-			currentSample = m_heldSample;
-			break;
+			values[frame] = m_heldSample;
+			phasePrev = currentPhase;
 		}
-		case Oscillator::WaveShape::UserDefined:
+		break;
+	}
+	case Oscillator::WaveShape::UserDefined:
+		for (f_cnt_t frame = 0; frame < frames; ++frame)
 		{
-			currentSample = Oscillator::userWaveSample(m_userDefSampleBuffer.get(), phase);
-			break;
+			values[frame] = Oscillator::userWaveSample(m_userDefSampleBuffer.get(), phase + frame * increment);
 		}
-		default:
+		break;
+	default:
+		Oscillator::fillLfo(waveshape, values, phase, increment, frames);
+	}
+
+	// kept free of branches, so the compiler can vectorize it
+	if (amountBuffer)
+	{
+		const float* amounts = amountBuffer->values();
+		for (f_cnt_t frame = 0; frame < frames; ++frame)
 		{
-			if (m_sampleFunction != nullptr)
-			{
-				currentSample = m_sampleFunction(phase);
-			}
+			values[frame] = std::clamp(base + amounts[frame] * values[frame] / 2.0f, 0.0f, 1.0f);
 		}
 	}
-
-		f = std::clamp(m_baseModel.value() + (*amountPtr * currentSample / 2.0f), 0.0f, 1.0f);
-
-		phasePrev = phase;
-		phase += 1.0 / m_duration;
-		amountPtr += amountInc;
+	else
+	{
+		for (f_cnt_t frame = 0; frame < frames; ++frame)
+		{
+			values[frame] = std::clamp(base + amount * values[frame] / 2.0f, 0.0f, 1.0f);
+		}
 	}
+	phase += frames * increment;
 
 	m_currentPhase = absFraction(phase - m_phaseOffset);
 	m_bufferLastUpdated = s_periods;
@@ -31,6 +31,10 @@
 #include <algorithm>
 #include <cmath>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "ValueBuffer.h"
 #include "SampleFrame.h"
 
@@ -347,5 +351,42 @@ void multiplyAndAddMultipliedJoined( SampleFrame* dst,
 	run<>( dst, srcLeft, srcRight, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
+
+
+
+void convertToS16(int_sample_t* dst, const sample_t* src, const float* dither, std::size_t samples)
+{
+	constexpr auto scale = 32767.0f;
+	constexpr auto lower = -32768.0f;
+	constexpr auto upper = 32767.0f;
+
+	auto i = std::size_t{0};
+#ifdef __SSE2__
+	const auto scaleV = _mm_set1_ps(scale);
+	const auto lowerV = _mm_set1_ps(lower);
+	const auto upperV = _mm_set1_ps(upper);
+	for (; i + 8 <= samples; i += 8)
+	{
+		auto a = _mm_mul_ps(_mm_loadu_ps(src + i), scaleV);
+		auto b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scaleV);
+		if (dither)
+		{
+			a = _mm_add_ps(a, _mm_loadu_ps(dither + i));
+			b = _mm_add_ps(b, _mm_loadu_ps(dither + i + 4));
+		}
+		// clip before converting, out of range values would turn into INT_MIN
+		a = _mm_max_ps(_mm_min_ps(a, upperV), lowerV);
+		b = _mm_max_ps(_mm_min_ps(b, upperV), lowerV);
+		const auto packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+#endif
+	for (; i < samples; ++i)
+	{
+		const auto value = src[i] * scale + (dither ? dither[i] : 0.0f);
+		dst[i] = static_cast<int_sample_t>(std::lrint(std::max(lower, std::min(upper, value))));
+	}
+}
+
 } // namespace lmms::MixHelpers
 
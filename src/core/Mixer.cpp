@@ -24,6 +24,10 @@
 
 #include <QDomElement>
 
+#include <algorithm>
+#include <span>
+
+#include "AudioBusHandle.h"
 #include "AudioEngine.h"
 #include "AudioEngineWorkerThread.h"
 #include "Mixer.h"
@@ -43,7 +47,8 @@ MixerRoute::MixerRoute( MixerChannel * from, MixerChannel * to, float amount ) :
 	m_from( from ),
 	m_to( to ),
 	m_amount(amount, 0, 1, 0.001f, nullptr,
-			tr("Amount to send from channel %1 to channel %2").arg(m_from->index()).arg(m_to->index()))
+			tr("Amount to send from channel %1 to channel %2").arg(m_from->index()).arg(m_to->index())),
+	m_delayedBuffer(Engine::audioEngine()->framesPerPeriod())
 {
 	//qDebug( "created: %d to %d", m_from->m_channelIndex, m_to->m_channelIndex );
 	// create send amount model
@@ -68,8 +73,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_volumeModel(1.f, 0.f, 2.f, 0.001f, _parent),
 	m_name(),
 	m_lock(),
-	m_queued( false ),
-	m_dependenciesMet(0),
+	m_muted( false ),
 	m_channelIndex(idx)
 {
 	m_buffer.allocateInterleavedBuffer();
@@ -83,27 +87,6 @@ MixerChannel::~MixerChannel()
 }
 
 
-inline void MixerChannel::processed()
-{
-	for( const MixerRoute * receiverRoute : m_sends )
-	{
-		if( receiverRoute->receiver()->m_muted == false )
-		{
-			receiverRoute->receiver()->incrementDeps();
-		}
-	}
-}
-
-void MixerChannel::incrementDeps()
-{
-	const auto i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
-	{
-		m_queued = true;
-		AudioEngineWorkerThread::addJob( this );
-	}
-}
-
 void MixerChannel::unmuteForSolo()
 {
 	m_muteModel.setValue(false);
@@ -161,6 +144,8 @@ void MixerChannel::unmuteReceiverForSolo()
 
 void MixerChannel::doProcessing()
 {
+	const auto probe = AudioEngineProfiler::JobProbe{Engine::audioEngine()->profiler(),
+		AudioEngineProfiler::JobType::MixerChannel, this};
 	const f_cnt_t fpp = Engine::audioEngine()->framesPerPeriod();
 
 	if( m_muted == false )
@@ -171,7 +156,9 @@ void MixerChannel::doProcessing()
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if (sender->m_buffer.hasAnySignal() || sender->m_stillRunning)
+			const bool senderHasSignal = sender->m_buffer.hasAnySignal() || sender->m_stillRunning;
+			LatencyCompensator& compensator = senderRoute->latencyCompensator();
+			if (senderHasSignal || compensator.hasSignal())
 			{
 				auto buffer = m_buffer.interleavedBuffer().asSampleFrames();
 
@@ -180,7 +167,14 @@ void MixerChannel::doProcessing()
 				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
 
 				// mix it's output with this one's output
-				auto ch_buf = sender->m_buffer.interleavedBuffer().asSampleFrames();
+				auto ch_buf = std::span<const SampleFrame>{sender->m_buffer.interleavedBuffer().asSampleFrames()};
+
+				// line it up with slower signals into this channel
+				if (compensator.delay() > 0)
+				{
+					compensator.process(senderHasSignal ? ch_buf.data() : nullptr, senderRoute->delayedBuffer(), fpp);
+					ch_buf = {senderRoute->delayedBuffer(), static_cast<std::size_t>(fpp)};
+				}
 
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
@@ -203,7 +197,16 @@ void MixerChannel::doProcessing()
 					MixHelpers::addSanitizedMultipliedByBuffer(buffer.data(), ch_buf.data(), v, sendBuf, fpp);
 				}
 				toPlanar(m_buffer.interleavedBuffer(), m_buffer.groupBuffers(0));
-				m_buffer.mixSilenceFlags(sender->m_buffer);
+				if (compensator.delay() > 0)
+				{
+					// the delayed signal may outlast the sender's
+					m_buffer.assumeNonSilent(0);
+					m_buffer.assumeNonSilent(1);
+				}
+				else
+				{
+					m_buffer.mixSilenceFlags(sender->m_buffer);
+				}
 			}
 		}
 
@@ -215,14 +218,31 @@ void MixerChannel::doProcessing()
 		const auto peakSamples = SampleFrame{m_buffer.absPeakValue(0), m_buffer.absPeakValue(1)};
 		m_peakLeft = std::max(m_peakLeft, peakSamples[0] * v);
 		m_peakRight = std::max(m_peakRight, peakSamples[1] * v);
+
+		if (m_tap)
+		{
+			const auto buffer = m_buffer.interleavedBuffer().asSampleFrames();
+			if (const ValueBuffer* volBuf = m_volumeModel.valueBuffer())
+			{
+				for (f_cnt_t f = 0; f < fpp; ++f)
+				{
+					m_tap[f] = buffer[f] * volBuf->values()[f];
+				}
+			}
+			else
+			{
+				for (f_cnt_t f = 0; f < fpp; ++f)
+				{
+					m_tap[f] = buffer[f] * v;
+				}
+			}
+		}
 	}
 	else
 	{
 		m_peakLeft = m_peakRight = 0.0f;
+		if (m_tap) { zeroSampleFrames(m_tap, fpp); }
 	}
-
-	// increment dependency counter of all receivers
-	processed();
 }
 
 
@@ -640,7 +660,9 @@ FloatModel * Mixer::channelSendModel( mix_ch_t fromChannel, mix_ch_t toChannel )
 void Mixer::mixToChannel(const AudioBuffer& buffer, mix_ch_t dest)
 {
 	const auto channel = m_mixerChannels[dest];
-	if (!channel->m_muteModel.value())
+	// use the per-period snapshot the job graph was built from, an unmuted
+	// channel has no dependency on this bus handle until the next period
+	if (!channel->m_muted)
 	{
 		channel->m_lock.lock();
 		MixHelpers::add(channel->m_buffer.groupBuffers(0), buffer.groupBuffers(0));
@@ -663,51 +685,91 @@ void Mixer::prepareMasterMix()
 
 
 
-void Mixer::masterMix( SampleFrame* _buf )
+void Mixer::compensateLatency(const std::vector<AudioBusHandle*>& busHandles)
 {
-	const int fpp = Engine::audioEngine()->framesPerPeriod();
-
-	// add the channels that have no dependencies (no incoming senders, ie.
-	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
-	// also instantly add all muted channels as they don't need to care
-	// about their senders, and can just increment the deps of their
-	// recipients right away.
-	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::OperationMode::Dynamic );
 	for( MixerChannel * ch : m_mixerChannels )
 	{
-		ch->m_muted = ch->m_muteModel.value();
-		if( ch->m_muted ) // instantly "process" muted channels
-		{
-			ch->processed();
-			ch->done();
-		}
-		else if( ch->m_receives.size() == 0 )
+		ch->m_inputLatency = 0;
+		ch->m_latency = ch->m_fxChain.latencyFrames();
+	}
+
+	const auto channelOf = [this](const AudioBusHandle* busHandle) -> MixerChannel*
+	{
+		const auto index = busHandle->nextMixerChannel();
+		return index >= 0 && index < numChannels() ? m_mixerChannels[index] : nullptr;
+	};
+
+	// find the slowest path into each channel, starting at the tracks...
+	for (const auto busHandle : busHandles)
+	{
+		if (const auto ch = channelOf(busHandle))
 		{
-			ch->m_queued = true;
-			AudioEngineWorkerThread::addJob( ch );
+			ch->m_inputLatency = std::max(ch->m_inputLatency, busHandle->latencyFrames());
 		}
 	}
-	while (m_mixerChannels[0]->state() != ThreadableJob::ProcessingState::Done)
+
+	// ...and following the sends. There are no loops, so every pass makes at
+	// least one more channel final.
+	for (auto pass = std::size_t{0}; pass < m_mixerChannels.size(); ++pass)
 	{
-		bool found = false;
-		for( MixerChannel * ch : m_mixerChannels )
+		bool changed = false;
+		for (const MixerRoute * route : m_mixerRoutes)
 		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
+			const auto latency = route->sender()->m_inputLatency + route->sender()->m_latency;
+			if (latency > route->receiver()->m_inputLatency)
 			{
-				found = true;
-				break;
+				route->receiver()->m_inputLatency = latency;
+				changed = true;
 			}
 		}
-		if( !found )
+		if (!changed) { break; }
+	}
+
+	// then hold back every faster path by the difference (latencies may
+	// change meanwhile, so don't rely on the difference being positive)
+	const auto difference = [](f_cnt_t slowest, f_cnt_t latency) { return slowest - std::min(slowest, latency); };
+	for (const auto busHandle : busHandles)
+	{
+		const auto ch = channelOf(busHandle);
+		busHandle->setLatencyCompensation(ch ? difference(ch->m_inputLatency, busHandle->latencyFrames()) : 0);
+	}
+	for (MixerRoute * route : m_mixerRoutes)
+	{
+		const auto latency = route->sender()->m_inputLatency + route->sender()->m_latency;
+		route->latencyCompensator().setDelay(difference(route->receiver()->m_inputLatency, latency));
+	}
+
+	m_latency = m_mixerChannels[0]->m_inputLatency + m_mixerChannels[0]->m_latency;
+}
+
+
+
+void Mixer::addJobs()
+{
+	// Muted channels don't care about their senders, so they can be
+	// "processed" right away. All other channels wait for the channels sending
+	// to them (and for the audio bus handles feeding them, see AudioEngine),
+	// which means the master channel is always processed last.
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		ch->m_muted = ch->m_muteModel.value();
+		AudioEngineWorkerThread::addJob( ch );
+	}
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		if( ch->m_muted ) { continue; }
+		for( const MixerRoute * senderRoute : ch->m_receives )
 		{
-			break;
+			AudioEngineWorkerThread::addDependency( ch, senderRoute->sender() );
 		}
-		AudioEngineWorkerThread::startAndWaitForJobs();
 	}
+}
+
+
+
+void Mixer::masterMix( SampleFrame* _buf )
+{
+	const int fpp = Engine::audioEngine()->framesPerPeriod();
 
 	auto buffer = m_mixerChannels[0]->m_buffer.interleavedBuffer().asSampleFrames();
 
@@ -734,8 +796,6 @@ void Mixer::masterMix( SampleFrame* _buf )
 	{
 		m_mixerChannels[i]->m_buffer.silenceAllChannels();
 		m_mixerChannels[i]->reset();
-		m_mixerChannels[i]->m_queued = false;
-		m_mixerChannels[i]->m_dependenciesMet = 0;
 	}
 }
 
@@ -25,11 +25,17 @@
 
 #include "NotePlayHandle.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
 #include "AudioEngine.h"
 #include "DetuningHelper.h"
 #include "InstrumentSoundShaping.h"
 #include "InstrumentTrack.h"
 #include "Instrument.h"
+#include "LocklessFreeList.h"
 #include "Song.h"
 #include "lmms_math.h"
 
@@ -602,25 +608,53 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
 
+constexpr auto HandlesPerSlab = std::size_t{256};
+constexpr auto MaxSlabs = std::size_t{64};
+constexpr auto InitialHandles = 2 * HandlesPerSlab;
+constexpr auto LocalCacheSize = std::size_t{32};
 
-void NotePlayHandleManager::init()
+// handles are never moved, so slabs are only added while the pool is in use
+std::array<std::atomic<NotePlayHandle*>, MaxSlabs> s_slabs{};
+std::atomic_size_t s_numSlabs = 0;
+LocklessFreeList s_freeList{HandlesPerSlab * MaxSlabs};
+std::mutex s_reserveMutex;
+std::atomic_size_t s_misses = 0;
+
+thread_local LocalFreeListCache<LocalCacheSize> t_cache;
+
+
+NotePlayHandle* handleAt(std::uint32_t index)
 {
-	s_available = new NotePlayHandle*[INITIAL_NPH_CACHE];
+	return s_slabs[index / HandlesPerSlab].load(std::memory_order_acquire) + index % HandlesPerSlab;
+}
 
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * INITIAL_NPH_CACHE));
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+//! Returns LocklessFreeList::Empty if @p nph is not part of the pool
+std::uint32_t indexOf(const NotePlayHandle* nph)
+{
+	const auto numSlabs = s_numSlabs.load(std::memory_order_acquire);
+	for (auto slab = std::size_t{0}; slab < numSlabs; ++slab)
 	{
-		s_available[ i ] = n;
-		++n;
+		const auto begin = s_slabs[slab].load(std::memory_order_relaxed);
+		if (nph >= begin && nph < begin + HandlesPerSlab)
+		{
+			return static_cast<std::uint32_t>(slab * HandlesPerSlab + (nph - begin));
+		}
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
+	return LocklessFreeList::Empty;
+}
+
+} // namespace
+
+
+
+
+void NotePlayHandleManager::init()
+{
+	reserve(InitialHandles);
 }
 
 
@@ -632,12 +666,15 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	// TODO: use some lockless data structures
-	s_mutex.lockForWrite();
-	if (s_availableIndex < 0) { extend(NPH_CACHE_INCREMENT); }
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
+	const auto index = t_cache.pop(s_freeList);
+	if (index == LocklessFreeList::Empty)
+	{
+		// more notes than reserved for - better allocate than drop the note
+		s_misses.fetch_add(1, std::memory_order_relaxed);
+		return new NotePlayHandle(instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin);
+	}
 
+	auto nph = handleAt(index);
 	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 	return nph;
 }
@@ -645,32 +682,55 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
+	const auto index = indexOf(nph);
+	if (index == LocklessFreeList::Empty)
+	{
+		delete nph;
+		return;
+	}
+
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+	t_cache.push(s_freeList, index);
 }
 
 
-void NotePlayHandleManager::extend( int c )
+void NotePlayHandleManager::reserve( std::size_t count )
 {
-	s_size += c;
-	auto tmp = new NotePlayHandle*[s_size];
-	delete[] s_available;
-	s_available = tmp;
-
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * c));
+	const auto lock = std::lock_guard{s_reserveMutex};
 
-	for( int i=0; i < c; ++i )
+	auto numSlabs = s_numSlabs.load(std::memory_order_relaxed);
+	while (numSlabs * HandlesPerSlab < count && numSlabs < MaxSlabs)
 	{
-		s_available[++s_availableIndex] = n;
-		++n;
+		s_slabs[numSlabs].store(std::allocator<NotePlayHandle>{}.allocate(HandlesPerSlab), std::memory_order_release);
+		s_numSlabs.store(numSlabs + 1, std::memory_order_release);
+
+		const auto first = static_cast<std::uint32_t>(numSlabs * HandlesPerSlab);
+		const auto last = static_cast<std::uint32_t>(first + HandlesPerSlab - 1);
+		for (auto index = first; index < last; ++index)
+		{
+			s_freeList.link(index, index + 1);
+		}
+		s_freeList.pushChain(first, last, HandlesPerSlab);
+		++numSlabs;
 	}
 }
 
+
+std::size_t NotePlayHandleManager::misses()
+{
+	return s_misses.load(std::memory_order_relaxed);
+}
+
+
 void NotePlayHandleManager::free()
 {
-	delete[] s_available;
+	// only called on shutdown, when no handle is in use anymore
+	const auto lock = std::lock_guard{s_reserveMutex};
+	const auto numSlabs = s_numSlabs.exchange(0, std::memory_order_acq_rel);
+	for (auto slab = std::size_t{0}; slab < numSlabs; ++slab)
+	{
+		std::allocator<NotePlayHandle>{}.deallocate(s_slabs[slab].exchange(nullptr), HandlesPerSlab);
+	}
 }
 
 
@@ -803,6 +803,117 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Exponential>(
 
 
 
+void Oscillator::fillLfo(WaveShape shape, float* buffer, float phase, float increment, f_cnt_t frames)
+{
+	switch (shape)
+	{
+	case WaveShape::Sine:
+	default:
+		fillLfo<WaveShape::Sine>(buffer, phase, increment, frames);
+		break;
+	case WaveShape::Triangle:
+		fillLfo<WaveShape::Triangle>(buffer, phase, increment, frames);
+		break;
+	case WaveShape::Saw:
+		fillLfo<WaveShape::Saw>(buffer, phase, increment, frames);
+		break;
+	case WaveShape::Square:
+		fillLfo<WaveShape::Square>(buffer, phase, increment, frames);
+		break;
+	case WaveShape::MoogSaw:
+		fillLfo<WaveShape::MoogSaw>(buffer, phase, increment, frames);
+		break;
+	case WaveShape::Exponential:
+		fillLfo<WaveShape::Exponential>(buffer, phase, increment, frames);
+		break;
+	}
+}
+
+
+
+
+template<Oscillator::WaveShape W>
+void Oscillator::fillLfo(float* buffer, float phase, float increment, f_cnt_t frames)
+{
+	f_cnt_t frame = 0;
+
+#ifdef __SSE2__
+	const auto select = [](__m128 mask, __m128 a, __m128 b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	};
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 four = _mm_set1_ps(4.0f);
+
+	// phases are calculated from the frame number, so rounding errors don't add up
+	__m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	for (; frame + 4 <= frames; frame += 4)
+	{
+		const __m128 x = _mm_add_ps(_mm_set1_ps(phase), _mm_mul_ps(index, _mm_set1_ps(increment)));
+		const __m128 ph = _mm_sub_ps(x, sse2Floor(x));
+		__m128 out;
+
+		if constexpr (W == WaveShape::Sine)
+		{
+			// fold into [-0.25, 0.25], where sin(2 pi t) is well approximated by its Taylor series
+			__m128 t = _mm_sub_ps(ph, _mm_and_ps(_mm_cmpgt_ps(ph, half), one));
+			const __m128 edge = _mm_or_ps(_mm_and_ps(t, _mm_castsi128_ps(_mm_set1_epi32(0x80000000))), half);
+			t = select(_mm_cmpgt_ps(sse2Abs(t), _mm_set1_ps(0.25f)), _mm_sub_ps(edge, t), t);
+
+			const __m128 y = _mm_mul_ps(t, _mm_set1_ps(2 * std::numbers::pi_v<float>));
+			const __m128 y2 = _mm_mul_ps(y, y);
+			__m128 p = _mm_set1_ps(1.0f / 362880.0f);
+			p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(-1.0f / 5040.0f));
+			p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(1.0f / 120.0f));
+			p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps(-1.0f / 6.0f));
+			p = _mm_add_ps(_mm_mul_ps(p, y2), one);
+			out = _mm_mul_ps(p, y);
+		}
+		else if constexpr (W == WaveShape::Triangle)
+		{
+			const __m128 t = _mm_mul_ps(ph, four);
+			out = select(_mm_cmple_ps(ph, _mm_set1_ps(0.25f)), t,
+				select(_mm_cmple_ps(ph, _mm_set1_ps(0.75f)), _mm_sub_ps(_mm_set1_ps(2.0f), t), _mm_sub_ps(t, four)));
+		}
+		else if constexpr (W == WaveShape::Saw)
+		{
+			out = _mm_sub_ps(_mm_add_ps(ph, ph), one);
+		}
+		else if constexpr (W == WaveShape::Square)
+		{
+			out = select(_mm_cmpgt_ps(ph, half), _mm_set1_ps(-1.0f), one);
+		}
+		else if constexpr (W == WaveShape::MoogSaw)
+		{
+			out = select(_mm_cmplt_ps(ph, half),
+				_mm_sub_ps(_mm_mul_ps(ph, four), one), _mm_sub_ps(one, _mm_add_ps(ph, ph)));
+		}
+		else if constexpr (W == WaveShape::Exponential)
+		{
+			const __m128 t = select(_mm_cmpgt_ps(ph, half), _mm_sub_ps(one, ph), ph);
+			out = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(8.0f), _mm_mul_ps(t, t)), one);
+		}
+
+		_mm_storeu_ps(buffer + frame, out);
+		index = _mm_add_ps(index, four);
+	}
+#endif
+
+	for (; frame < frames; ++frame)
+	{
+		const float x = phase + frame * increment;
+		if constexpr (W == WaveShape::Sine) { buffer[frame] = sinSample(x); }
+		else if constexpr (W == WaveShape::Triangle) { buffer[frame] = triangleSample(x); }
+		else if constexpr (W == WaveShape::Saw) { buffer[frame] = sawSample(x); }
+		else if constexpr (W == WaveShape::Square) { buffer[frame] = squareSample(x); }
+		else if constexpr (W == WaveShape::MoogSaw) { buffer[frame] = moogSawSample(x); }
+		else if constexpr (W == WaveShape::Exponential) { buffer[frame] = expSample(x); }
+	}
+}
+
+
+
+
 template<>
 inline sample_t Oscillator::getSample<Oscillator::WaveShape::WhiteNoise>(
 							const float _sample )
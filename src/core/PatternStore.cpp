@@ -25,6 +25,7 @@
 
 #include "PatternStore.h"
 
+#include "AutomationTimeline.h"
 #include "Clip.h"
 #include "Engine.h"
 #include "PatternTrack.h"
@@ -39,6 +40,8 @@ PatternStore::PatternStore() :
 	m_patternComboBoxModel(this)
 {
 	setType(Type::Pattern);
+	// another pattern is played from now on
+	connect(&m_patternComboBoxModel, &ComboBoxModel::dataChanged, [] { AutomationTimeline::invalidate(); });
 }
 
 
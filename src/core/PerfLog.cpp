@@ -116,6 +116,11 @@ void PerfLogTimer::begin()
 	begin_time = PerfTime::now();
 }
 
+void PerfLogTimer::setAudioDuration(double seconds)
+{
+	audio_duration = seconds;
+}
+
 void PerfLogTimer::end()
 {
 	if (! begin_time.valid()) {
@@ -125,11 +130,24 @@ void PerfLogTimer::end()
 	long clktck = PerfTime::ticksPerSecond();
 
 	PerfTime d = PerfTime::now() - begin_time;
-	qWarning("PERFLOG | %20s | %.2fuser, %.2fsystem %.2felapsed",
-			 qPrintable(name),
-			 d.user() / (double)clktck,
-			 d.system() / (double)clktck,
-			 d.real() / (double)clktck);
+	const double elapsed = d.real() / (double)clktck;
+	if (audio_duration > 0 && elapsed > 0)
+	{
+		qWarning("PERFLOG | %20s | %.2fuser, %.2fsystem %.2felapsed, %.2fx realtime",
+				 qPrintable(name),
+				 d.user() / (double)clktck,
+				 d.system() / (double)clktck,
+				 elapsed,
+				 audio_duration / elapsed);
+	}
+	else
+	{
+		qWarning("PERFLOG | %20s | %.2fuser, %.2fsystem %.2felapsed",
+				 qPrintable(name),
+				 d.user() / (double)clktck,
+				 d.system() / (double)clktck,
+				 elapsed);
+	}
 
 	// Invalidate so destructor won't call print another log entry
 	begin_time = PerfTime();
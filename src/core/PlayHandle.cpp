@@ -52,6 +52,9 @@ PlayHandle::~PlayHandle()
 
 void PlayHandle::doProcessing()
 {
+	const auto probe = AudioEngineProfiler::JobProbe{Engine::audioEngine()->profiler(),
+		AudioEngineProfiler::JobType::Instrument, m_audioBusHandle};
+
 	if( m_usesBuffer )
 	{
 		m_bufferReleased = false;
@@ -195,12 +195,30 @@ PresetPreviewPlayHandle::PresetPreviewPlayHandle( const QString & _preset_file,
 PresetPreviewPlayHandle::~PresetPreviewPlayHandle()
 {
 	Engine::audioEngine()->requestChangeInModel();
+	// not stopped in onRemoved() yet?
+	stopPreviewNote();
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+
+
+
+void PresetPreviewPlayHandle::onRemoved()
+{
+	// this runs at the start of a period on the audio thread, so the note is released right away
+	stopPreviewNote();
+}
+
+
+
+
+void PresetPreviewPlayHandle::stopPreviewNote()
+{
 	// not muted by other preset-preview-handle?
 	if (s_previewTC->testAndSetPreviewNote(m_previewNote, nullptr))
 	{
 		m_previewNote->noteOff();
 	}
-	Engine::audioEngine()->doneChangeInModel();
 }
 
 
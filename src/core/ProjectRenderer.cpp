@@ -25,9 +25,17 @@
 
 #include <QFile>
 
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <span>
+
 #include "ProjectRenderer.h"
+#include "AudioBusHandle.h"
+#include "Mixer.h"
 #include "Song.h"
 #include "PerfLog.h"
+#include "ThreadPool.h"
 
 #include "AudioFileWave.h"
 #include "AudioFileOgg.h"
@@ -38,6 +46,12 @@
 namespace lmms
 {
 
+//! Frames collected per stem before all stems are encoded at once
+static constexpr auto StemBlockFrames = std::size_t{16384};
+
+//! Frames the renderer may get ahead of the encoder of the full mix
+static constexpr auto EncoderQueueFrames = f_cnt_t{65536};
+
 
 const std::array<ProjectRenderer::FileEncodeDevice, 5> ProjectRenderer::fileEncodeDevices
 {
@@ -78,9 +92,19 @@ const std::array<ProjectRenderer::FileEncodeDevice, 5> ProjectRenderer::fileEnco
 ProjectRenderer::ProjectRenderer(
 	const OutputSettings& outputSettings, ExportFileFormat exportFileFormat, const QString& outputFilename)
 	: QThread(Engine::audioEngine())
-	, m_fileDev(nullptr)
+	, m_fileDev(createFileDevice(outputSettings, exportFileFormat, outputFilename))
+	, m_outputSettings(outputSettings)
+	, m_exportFileFormat(exportFileFormat)
 	, m_progress(0)
 	, m_abort(false)
+{
+}
+
+
+
+
+AudioFileDevice* ProjectRenderer::createFileDevice(
+	const OutputSettings& outputSettings, ExportFileFormat exportFileFormat, const QString& outputFilename)
 {
 	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(exportFileFormat)].m_getDevInst;
 
@@ -88,15 +112,40 @@ ProjectRenderer::ProjectRenderer(
 	{
 		bool successful = false;
 
-		m_fileDev = audioEncoderFactory(
+		AudioFileDevice* fileDev = audioEncoderFactory(
 					outputFilename, outputSettings, DEFAULT_CHANNELS,
 					Engine::audioEngine(), successful );
-		if( !successful )
+		if( successful )
 		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
+			return fileDev;
 		}
+		delete fileDev;
 	}
+	return nullptr;
+}
+
+
+
+
+bool ProjectRenderer::addStem(AudioBusHandle* busHandle, const QString& outputFilename)
+{
+	auto device = std::unique_ptr<AudioFileDevice>{createFileDevice(m_outputSettings, m_exportFileFormat, outputFilename)};
+	if (!device) { return false; }
+
+	m_stems.push_back(Stem{.device = std::move(device), .busHandle = busHandle});
+	return true;
+}
+
+
+
+
+bool ProjectRenderer::addStem(MixerChannel* channel, const QString& outputFilename)
+{
+	auto device = std::unique_ptr<AudioFileDevice>{createFileDevice(m_outputSettings, m_exportFileFormat, outputFilename)};
+	if (!device) { return false; }
+
+	m_stems.push_back(Stem{.device = std::move(device), .channel = channel});
+	return true;
 }
 
 
@@ -161,14 +210,37 @@ void ProjectRenderer::run()
 
 	m_progress = 0;
 
+	// The output lags behind the song by the latency of the effects on the
+	// way to the master channel - drop that much at the start, and render
+	// as much past the end, so the file lines up with the song. Ask only now
+	// that the effects ran once at the export sample rate, before that some
+	// of them still report the latency they had before or none at all.
+	const auto latency = static_cast<std::size_t>(Engine::audioEngine()->compensateLatency());
+	auto framesToSkip = latency;
+	auto framesWritten = std::size_t{0};
+
+	// stems lag behind by the latency up to their tap, see setStemTaps()
+	setStemTaps(true);
+
+	// encode the full mix while the next periods are rendered
+	m_fileDev->startEncoderThread(EncoderQueueFrames);
+
 	// Now start processing
 	Engine::audioEngine()->startProcessing();
 
 	// Continually track and emit progress percentage to listeners.
+	auto songFrames = std::size_t{0};
 	while (!Engine::getSong()->isExportDone() && !m_abort)
 	{
-		const auto buffer = Engine::audioEngine()->renderNextPeriod();
-		m_fileDev->writeBuffer(buffer.data(), buffer.size());
+		auto buffer = Engine::audioEngine()->renderNextPeriod();
+		songFrames += buffer.size();
+		collectStems(std::numeric_limits<std::size_t>::max());
+
+		const auto skipped = std::min(framesToSkip, buffer.size());
+		framesToSkip -= skipped;
+		buffer = buffer.subspan(skipped);
+		if (!buffer.empty()) { m_fileDev->queueBuffer(buffer.data(), buffer.size()); }
+		framesWritten += buffer.size();
 
 		const int nprog = Engine::getSong()->getExportProgress();
 		if (m_progress != nprog)
@@ -178,18 +250,131 @@ void ProjectRenderer::run()
 		}
 	}
 
+	// render as much as was skipped, the latency still holds it back
+	const auto stemsDone = [&] {
+		return std::all_of(m_stems.begin(), m_stems.end(),
+			[&](const Stem& stem) { return stem.framesWritten + stem.block.size() >= songFrames; });
+	};
+	for (auto tail = latency - framesToSkip; (tail > 0 || !stemsDone()) && !m_abort;)
+	{
+		const auto buffer = Engine::audioEngine()->renderNextPeriod();
+		collectStems(songFrames);
+
+		const auto frames = std::min(tail, buffer.size());
+		if (frames > 0) { m_fileDev->queueBuffer(buffer.data(), frames); }
+		framesWritten += frames;
+		tail -= frames;
+	}
+
+	writeStems();
+	setStemTaps(false);
+	m_fileDev->finishEncoderThread();
+
 	// Notify the audio engine of the end of processing.
 	Engine::audioEngine()->stopProcessing();
 
 	Engine::getSong()->stopExport();
 
+	perfLog.setAudioDuration(static_cast<double>(framesWritten) / m_fileDev->sampleRate());
 	perfLog.end();
 
+	// close the stem files
+	auto stemFiles = QStringList{};
+	for (const auto& stem : m_stems)
+	{
+		stemFiles << stem.device->outputFile();
+	}
+	m_stems.clear();
+
 	// If the user aborted export-process, the file has to be deleted.
 	const QString f = m_fileDev->outputFile();
 	if( m_abort )
 	{
 		QFile( f ).remove();
+		for (const auto& stemFile : stemFiles)
+		{
+			QFile(stemFile).remove();
+		}
+	}
+}
+
+
+
+
+void ProjectRenderer::setStemTaps(bool enabled)
+{
+	const auto guard = Engine::audioEngine()->requestChangesGuard();
+	const auto mixer = Engine::mixer();
+	const auto fpp = Engine::audioEngine()->framesPerPeriod();
+
+	for (auto& stem : m_stems)
+	{
+		stem.tap.assign(enabled ? fpp : 0, SampleFrame{});
+		const auto tap = enabled ? stem.tap.data() : nullptr;
+
+		if (stem.busHandle)
+		{
+			// everything feeding a mixer channel is delayed to its slowest input
+			const auto channel = stem.busHandle->nextMixerChannel();
+			stem.framesToSkip = channel >= 0 && channel < mixer->numChannels()
+				? mixer->mixerChannel(channel)->m_inputLatency
+				: stem.busHandle->latencyFrames();
+			stem.busHandle->setTap(tap);
+		}
+		else
+		{
+			stem.framesToSkip = stem.channel->m_inputLatency + stem.channel->m_latency;
+			stem.channel->m_tap = tap;
+		}
+	}
+}
+
+
+
+
+void ProjectRenderer::collectStems(std::size_t maxFrames)
+{
+	bool blockFull = false;
+	for (auto& stem : m_stems)
+	{
+		auto frames = std::span<const SampleFrame>{stem.tap};
+		const auto skipped = std::min(stem.framesToSkip, frames.size());
+		stem.framesToSkip -= skipped;
+		frames = frames.subspan(skipped);
+
+		const auto collected = stem.framesWritten + stem.block.size();
+		frames = frames.first(std::min(frames.size(), maxFrames - std::min(maxFrames, collected)));
+		stem.block.insert(stem.block.end(), frames.begin(), frames.end());
+
+		blockFull |= stem.block.size() >= StemBlockFrames;
+	}
+
+	if (blockFull) { writeStems(); }
+}
+
+
+
+
+void ProjectRenderer::writeStems()
+{
+	auto pending = std::vector<std::future<void>>{};
+	for (auto& stem : m_stems)
+	{
+		if (stem.block.empty()) { continue; }
+		pending.push_back(ThreadPool::instance().enqueue([&stem] {
+			stem.device->writeBuffer(stem.block.data(), stem.block.size());
+		}));
+	}
+
+	for (auto& result : pending)
+	{
+		result.wait();
+	}
+
+	for (auto& stem : m_stems)
+	{
+		stem.framesWritten += stem.block.size();
+		stem.block.clear();
 	}
 }
 
@@ -41,6 +41,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QUuid>
 
 #ifndef SYNC_WITH_SHM_FIFO
@@ -141,8 +142,12 @@ RemotePlugin::RemotePlugin() :
 	m_watcher( this ),
 	m_splitChannels( false ),
 	m_audioBufferSize( 0 ),
+	m_eventRingReady( false ),
 	m_inputCount( DEFAULT_CHANNELS ),
-	m_outputCount( DEFAULT_CHANNELS )
+	m_outputCount( DEFAULT_CHANNELS ),
+	m_processing( false ),
+	m_periodsStarted( 0 ),
+	m_periodsDone( 0 )
 {
 #ifndef SYNC_WITH_SHM_FIFO
 	struct sockaddr_un sa;
@@ -262,6 +267,12 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 		return failed();
 	}
 
+	if( objectName().isEmpty() )
+	{
+		// identifies the plugin e.g. in the profiler, subclasses may set a better name
+		setObjectName( QFileInfo( exec ).baseName() );
+	}
+
 	// ensure the watcher is ready in case we're running again
 	// (e.g. 32-bit VST plugins on Windows)
 	m_watcher.wait();
@@ -313,6 +324,7 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 #endif
 
 	sendMessage(message(IdSyncKey).addString(Engine::getSong()->syncKey()));
+	sendMessage(message(IdProtocolVersion).addInt(RemoteProtocolVersion));
 	resizeSharedProcessingMemory();
 
 	if( waitForInitDoneMsg )
@@ -328,15 +340,22 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 
 
 bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
+{
+	startProcess( _in_buf );
+	return finishProcess( _out_buf );
+}
+
+
+
+
+bool RemotePlugin::startProcess( const SampleFrame* _in_buf )
 {
 	const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
 
+	m_processing = false;
+
 	if( m_failed || !isRunning() )
 	{
-		if( _out_buf != nullptr )
-		{
-			zeroSampleFrames(_out_buf, frames);
-		}
 		return false;
 	}
 
@@ -352,10 +371,6 @@ bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 			fetchAndProcessAllMessages();
 			unlock();
 		}
-		if( _out_buf != nullptr )
-		{
-			zeroSampleFrames(_out_buf, frames);
-		}
 		return false;
 	}
 
@@ -395,16 +410,49 @@ bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 	}
 
 	lock();
+	++m_periodsStarted;
 	sendMessage( IdStartProcessing );
+	unlock();
+
+	m_processing = true;
+	return true;
+}
+
+
+
+
+bool RemotePlugin::finishProcess( SampleFrame* _out_buf )
+{
+	const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
+
+	if( !m_processing )
+	{
+		if( _out_buf != nullptr )
+		{
+			zeroSampleFrames(_out_buf, frames);
+		}
+		return false;
+	}
+	m_processing = false;
 
 	if( m_failed || _out_buf == nullptr || m_outputCount == 0 )
 	{
-		unlock();
 		return false;
 	}
 
-	waitForMessage( IdProcessingDone );
-	unlock();
+	{
+		const auto probe = AudioEngineProfiler::JobProbe{Engine::audioEngine()->profiler(),
+			AudioEngineProfiler::JobType::RemotePlugin, this};
+
+		// whoever receives IdProcessingDone counts it in processMessage(), so
+		// it doesn't matter which thread fetches the client's messages meanwhile
+		lock();
+		while( m_periodsDone.load(std::memory_order_acquire) < m_periodsStarted && !isInvalid() )
+		{
+			fetchAndProcessNextMessage();
+		}
+		unlock();
+	}
 
 	const ch_cnt_t outputs = std::min<ch_cnt_t>(m_outputCount,
 							DEFAULT_CHANNELS);
@@ -449,6 +497,14 @@ bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 void RemotePlugin::processMidiEvent( const MidiEvent & _e,
 							const f_cnt_t _offset )
 {
+	if (peerProtocolVersion() >= 1)
+	{
+		auto event = RemoteEvent{.type = RemoteEvent::Type::Midi, .offset = static_cast<std::int32_t>(_offset)};
+		event.midi = {_e.type(), _e.channel(), {_e.param(0), _e.param(1)}};
+		sendEvent(event);
+		return;
+	}
+
 	message m( IdMidiEvent );
 	m.addInt( _e.type() );
 	m.addInt( _e.channel() );
@@ -460,6 +516,41 @@ void RemotePlugin::processMidiEvent( const MidiEvent & _e,
 	unlock();
 }
 
+void RemotePlugin::sendEvent(const RemoteEvent& event)
+{
+	const auto guard = std::lock_guard{m_eventRingMutex};
+	if (!m_eventRingReady)
+	{
+		// the client did not set up the ring (yet), so the event goes
+		// along with the next message, usually IdStartProcessing
+		queueEvent(event);
+		return;
+	}
+
+	// once the client didn't keep up with the ring, the following events go along with the next
+	// message too until it's sent, or else they would overtake the ones which didn't fit
+	if (!hasQueuedEvents() && m_eventRing->push(event)) { return; }
+	queueEvent(event, m_eventRing->writePosition());
+}
+
+
+
+
+void RemotePlugin::drainEvents()
+{
+	{
+		const auto guard = std::lock_guard{m_eventRingMutex};
+		if (!m_eventRingReady || m_eventRing->empty()) { return; }
+	}
+
+	lock();
+	sendMessage(IdDrainEvents);
+	unlock();
+}
+
+
+
+
 void RemotePlugin::showUI()
 {
 	lock();
@@ -562,12 +653,39 @@ bool RemotePlugin::processMessage( const message & _m )
 			resizeSharedProcessingMemory();
 			break;
 
+		case IdProtocolVersion:
+			setPeerProtocolVersion(_m.getInt());
+			if (peerProtocolVersion() >= 2)
+			{
+				const auto guard = std::lock_guard{m_eventRingMutex};
+				try
+				{
+					m_eventRing.create();
+					sendMessage(message(IdEventRingKey).addString(m_eventRing.key()));
+				}
+				catch (const std::runtime_error& error)
+				{
+					qWarning() << "Failed to allocate shared event ring:" << error.what();
+				}
+			}
+			break;
+
+		case IdEventRingKey:
+		{
+			const auto guard = std::lock_guard{m_eventRingMutex};
+			m_eventRingReady = static_cast<bool>(m_eventRing);
+			break;
+		}
+
 		case IdDebugMessage:
 			fprintf( stderr, "RemotePlugin::DebugMessage: %s",
 						_m.getString( 0 ).c_str() );
 			break;
 
 		case IdProcessingDone:
+			m_periodsDone.fetch_add(1, std::memory_order_release);
+			break;
+
 		case IdQuit:
 		default:
 			break;
@@ -22,12 +22,17 @@
  *
  */
 
+#include <array>
+
 #include <QDir>
 #include <QRegularExpression>
 
 #include "RenderManager.h"
 
+#include "InstrumentTrack.h"
+#include "Mixer.h"
 #include "PatternStore.h"
+#include "SampleTrack.h"
 #include "Song.h"
 
 
@@ -88,36 +93,33 @@ void RenderManager::renderNextTrack()
 	}
 }
 
-// Render the song into individual tracks
-void RenderManager::renderTracks()
+// Find all tracks to render individually, i.e. unmuted instrument and sample tracks
+static std::vector<Track*> unmutedTracks()
 {
-	const TrackContainer::TrackList& tl = Engine::getSong()->tracks();
-
-	// find all currently unnmuted tracks -- we want to render these.
-	for (const auto& tk : tl)
+	auto tracks = std::vector<Track*>{};
+	const auto containers = std::array<const TrackContainer*, 2>{Engine::getSong(), Engine::patternStore()};
+	for (const TrackContainer* container : containers)
 	{
-		Track::Type type = tk->type();
-
-		// Don't render automation tracks
-		if ( tk->isMuted() == false &&
-				( type == Track::Type::Instrument || type == Track::Type::Sample ) )
+		for (const auto& tk : container->tracks())
 		{
-			m_unmuted.push_back(tk);
-		}
-	}
-
-	const TrackContainer::TrackList& t2 = Engine::patternStore()->tracks();
-	for (const auto& tk : t2)
-	{
-		Track::Type type = tk->type();
+			Track::Type type = tk->type();
 
-		// Don't render automation tracks
-		if ( tk->isMuted() == false &&
-				( type == Track::Type::Instrument || type == Track::Type::Sample ) )
-		{
-			m_unmuted.push_back(tk);
+			// Don't render automation tracks
+			if ( tk->isMuted() == false &&
+					( type == Track::Type::Instrument || type == Track::Type::Sample ) )
+			{
+				tracks.push_back(tk);
+			}
 		}
 	}
+	return tracks;
+}
+
+// Render the song into individual tracks
+void RenderManager::renderTracks()
+{
+	// find all currently unnmuted tracks -- we want to render these.
+	m_unmuted = unmutedTracks();
 
 	// copy the list of unmuted tracks into our rendering queue.
 	// we need to remember which tracks were unmuted to restore state at the end.
@@ -132,10 +134,64 @@ void RenderManager::renderProject()
 	render( m_outputPath );
 }
 
+// Render the song once, writing the full mix and every stem at the same time
+void RenderManager::renderStems(StemSource source)
+{
+	Mixer* mixer = Engine::mixer();
+	m_activeRenderer = std::make_unique<ProjectRenderer>(
+		m_outputSettings, m_format, pathForChannel(mixer->mixerChannel(0)));
+
+	if (m_activeRenderer->isReady())
+	{
+		switch (source)
+		{
+		case StemSource::Tracks:
+		{
+			const auto tracks = unmutedTracks();
+			for (auto i = std::size_t{0}; i < tracks.size(); ++i)
+			{
+				AudioBusHandle* busHandle = nullptr;
+				if (auto instrumentTrack = dynamic_cast<InstrumentTrack*>(tracks[i]))
+				{
+					busHandle = instrumentTrack->audioBusHandle();
+				}
+				else if (auto sampleTrack = dynamic_cast<SampleTrack*>(tracks[i]))
+				{
+					busHandle = sampleTrack->audioBusHandle();
+				}
+
+				const auto path = pathForTrack(tracks[i], static_cast<int>(i) + 1);
+				if (busHandle && !m_activeRenderer->addStem(busHandle, path))
+				{
+					qWarning("Could not open %s for writing", qPrintable(path));
+				}
+			}
+			break;
+		}
+		case StemSource::MixerChannels:
+			for (auto i = 1; i < mixer->numChannels(); ++i)
+			{
+				const auto path = pathForChannel(mixer->mixerChannel(i));
+				if (!m_activeRenderer->addStem(mixer->mixerChannel(i), path))
+				{
+					qWarning("Could not open %s for writing", qPrintable(path));
+				}
+			}
+			break;
+		}
+	}
+
+	startRenderer();
+}
+
 void RenderManager::render(QString outputPath)
 {
 	m_activeRenderer = std::make_unique<ProjectRenderer>(m_outputSettings, m_format, outputPath);
+	startRenderer();
+}
 
+void RenderManager::startRenderer()
+{
 	if( m_activeRenderer->isReady() )
 	{
 		// pass progress signals through
@@ -177,6 +233,16 @@ QString RenderManager::pathForTrack(const Track *track, int num)
 	return QDir(m_outputPath).filePath(name);
 }
 
+// Determine the output path for a mixer channel when rendering stems
+QString RenderManager::pathForChannel(const MixerChannel* channel)
+{
+	QString extension = ProjectRenderer::getFileExtensionFromFormat(m_format);
+	QString name = channel->m_name;
+	name = name.remove(QRegularExpression(FILENAME_FILTER));
+	name = QString("%1_%2%3").arg(channel->index()).arg(name).arg(extension);
+	return QDir(m_outputPath).filePath(name);
+}
+
 void RenderManager::updateConsoleProgress()
 {
 	if ( m_activeRenderer )
@@ -24,6 +24,9 @@
 
 #include "Sample.h"
 
+#include <algorithm>
+#include <optional>
+
 namespace lmms {
 
 Sample::Sample(const SampleFrame* data, size_t numFrames, int sampleRate)
@@ -99,6 +102,7 @@ auto Sample::operator=(Sample&& other) noexcept -> Sample&
 bool Sample::play(SampleFrame* dst, PlaybackState* state, size_t numFrames, Loop loop, double ratio) const
 {
 	state->m_frameIndex = std::max<int>(m_startFrame, state->m_frameIndex);
+	prefetch(state->m_frameIndex, state->m_backwards);
 
 	const auto sampleRateRatio = static_cast<double>(Engine::audioEngine()->outputSampleRate()) / m_buffer->sampleRate();
 	const auto freqRatio = frequency() / DefaultBaseFreq;
@@ -133,6 +137,10 @@ bool Sample::play(SampleFrame* dst, PlaybackState* state, size_t numFrames, Loop
 
 f_cnt_t Sample::render(SampleFrame* dst, f_cnt_t size, PlaybackState* state, Loop loop) const
 {
+	// streamed frames are only read from memory, so rendering never waits for the disk
+	const auto stream = m_buffer->stream();
+	const auto reader = stream ? std::optional<SampleStream::Reader>{std::in_place, *stream} : std::nullopt;
+
 	for (f_cnt_t frame = 0; frame < size; ++frame)
 	{
 		switch (loop)
@@ -163,9 +171,9 @@ f_cnt_t Sample::render(SampleFrame* dst, f_cnt_t size, PlaybackState* state, Loo
 			break;
 		}
 
-		const auto value
-			= m_buffer->data()[m_reversed ? m_buffer->size() - state->m_frameIndex - 1 : state->m_frameIndex]
-			* m_amplification;
+		// mono and multichannel buffers are mixed to stereo here
+		const auto index = m_reversed ? m_buffer->size() - state->m_frameIndex - 1 : state->m_frameIndex;
+		const auto value = (reader ? reader->frame(index) : m_buffer->frame(index)) * m_amplification;
 		dst[frame] = value;
 		state->m_backwards ? --state->m_frameIndex : ++state->m_frameIndex;
 	}
@@ -173,6 +181,25 @@ f_cnt_t Sample::render(SampleFrame* dst, f_cnt_t size, PlaybackState* state, Loo
 	return size;
 }
 
+void Sample::prefetch(int frameIndex, bool backwards) const
+{
+	if (!m_buffer->isStreamed()) { return; }
+	m_buffer->prefetch(bufferIndex(frameIndex), backwards != m_reversed);
+}
+
+void Sample::prefetchUpcoming(int frameIndex) const
+{
+	if (!m_buffer->isStreamed()) { return; }
+	m_buffer->prefetchUpcoming(bufferIndex(frameIndex), m_reversed);
+}
+
+auto Sample::bufferIndex(int frameIndex) const -> int
+{
+	// the buffer is read in the other direction when reversed
+	const auto size = static_cast<int>(m_buffer->size());
+	return std::clamp(m_reversed ? size - frameIndex - 1 : frameIndex, 0, std::max(size - 1, 0));
+}
+
 auto Sample::sampleDuration() const -> std::chrono::milliseconds
 {
 	const auto numFrames = endFrame() - startFrame();
@@ -24,16 +24,171 @@
 
 #include "SampleBuffer.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QFileInfo>
+#include <QHash>
 #include <QMessageBox>
+#include <atomic>
 #include <cstring>
+#include <limits>
+#include <mutex>
 
+#include "ConfigManager.h"
 #include "GuiApplication.h"
 #include "PathUtil.h"
+#include "SampleCache.h"
 #include "SampleDecoder.h"
+#include "SampleLoader.h"
 
 namespace lmms {
 
+namespace {
+
+//! The buffers in use by their content, so identical samples share one buffer
+class SharedBuffers
+{
+public:
+	auto find(const QString& key) -> std::shared_ptr<const SampleBuffer>
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		return handle(m_buffers.value(key).lock());
+	}
+
+	//! Returns a handle to @p buffer, or to the buffer another thread added for @p key in the meantime
+	auto insert(const QString& key, std::shared_ptr<const SampleBuffer> buffer) -> std::shared_ptr<const SampleBuffer>
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		if (auto existing = m_buffers.value(key).lock()) { return handle(std::move(existing)); }
+
+		// drops the buffers which aren't in use anymore, there are only a few per sample in use
+		for (auto it = m_buffers.begin(); it != m_buffers.end();)
+		{
+			it = it->expired() ? m_buffers.erase(it) : std::next(it);
+		}
+
+		const auto bytes = buffer->size() * buffer->channels() * sizeof(sample_t);
+		auto usage = std::make_shared<Usage>(std::move(buffer), bytes);
+		m_buffers.insert(key, usage);
+		return handle(std::move(usage));
+	}
+
+	static auto sharedBytes() -> std::size_t
+	{
+		return s_sharedBytes.load(std::memory_order_relaxed);
+	}
+
+private:
+	//! A buffer in use and the number of handles to it handed out by find() and insert()
+	struct Usage
+	{
+		Usage(std::shared_ptr<const SampleBuffer> buffer, std::size_t bytes) :
+			buffer(std::move(buffer)),
+			bytes(bytes)
+		{
+		}
+
+		std::shared_ptr<const SampleBuffer> buffer;
+		std::size_t bytes;
+		std::atomic<std::size_t> handles = 0;
+	};
+
+	//! Keeps its buffer in use. Copies of the shared_ptr returned for it don't count as reuse,
+	//! only another handle for the same buffer does.
+	struct Handle
+	{
+		Handle(std::shared_ptr<Usage> usage) :
+			usage(std::move(usage))
+		{
+			if (this->usage->handles.fetch_add(1, std::memory_order_relaxed) > 0)
+			{
+				s_sharedBytes.fetch_add(this->usage->bytes, std::memory_order_relaxed);
+			}
+		}
+
+		~Handle()
+		{
+			if (usage->handles.fetch_sub(1, std::memory_order_relaxed) > 1)
+			{
+				s_sharedBytes.fetch_sub(usage->bytes, std::memory_order_relaxed);
+			}
+		}
+
+		Handle(const Handle&) = delete;
+		Handle& operator=(const Handle&) = delete;
+
+		std::shared_ptr<Usage> usage;
+	};
+
+	static auto handle(std::shared_ptr<Usage> usage) -> std::shared_ptr<const SampleBuffer>
+	{
+		if (!usage) { return nullptr; }
+
+		const auto buffer = usage->buffer.get();
+		return std::shared_ptr<const SampleBuffer>{std::make_shared<Handle>(std::move(usage)), buffer};
+	}
+
+	std::mutex m_mutex;
+	QHash<QString, std::weak_ptr<Usage>> m_buffers;
+	//! The size of each buffer in use times its handles beyond the first one,
+	//! static as handles may outlive the registry at exit
+	static inline std::atomic<std::size_t> s_sharedBytes = 0;
+};
+
+auto sharedBuffers() -> SharedBuffers&
+{
+	static auto s_buffers = SharedBuffers{};
+	return s_buffers;
+}
+
+auto decode(const QString& absolutePath, const QString& storedPath) -> std::shared_ptr<const SampleBuffer>
+{
+	const auto threshold = ConfigManager::inst()->value(
+		"app", "samplestreamingthreshold", QString::number(SampleBuffer::DefaultStreamingThreshold)).toLongLong();
+	const auto streamedBytes = threshold > 0
+		? static_cast<std::size_t>(threshold) * 1024 * 1024
+		: std::numeric_limits<std::size_t>::max();
+
+	if (auto cached = SampleCache::find(absolutePath, streamedBytes))
+	{
+		if (cached->stream) { return std::make_shared<SampleBuffer>(std::move(cached->stream), storedPath); }
+		if (!cached->levels.empty())
+		{
+			return std::make_shared<SampleBuffer>(
+				std::move(cached->samples), std::move(cached->levels), cached->sampleRate, storedPath);
+		}
+		return std::make_shared<SampleBuffer>(std::move(cached->data), cached->sampleRate, storedPath);
+	}
+
+	if (threshold > 0)
+	{
+		const auto frames = SampleDecoder::frameCount(absolutePath);
+		if (frames && *frames * sizeof(SampleFrame) > streamedBytes)
+		{
+			// falls back to decoding into memory if e.g. the temporary file can't be written
+			auto stream = SampleCache::decode(absolutePath);
+			if (!stream) { stream = SampleStream::decode(absolutePath); }
+			if (stream)
+			{
+				return std::make_shared<SampleBuffer>(std::move(stream), storedPath);
+			}
+		}
+	}
+
+	auto result = SampleDecoder::decode(absolutePath);
+	if (!result) { return nullptr; }
+
+	// mono and multichannel files keep their channels
+	const auto buffer = result->levels.empty()
+		? std::make_shared<SampleBuffer>(std::move(result->data), result->sampleRate, storedPath)
+		: std::make_shared<SampleBuffer>(
+			std::move(result->samples), std::move(result->levels), result->sampleRate, storedPath);
+	SampleCache::store(absolutePath, *buffer);
+	return buffer;
+}
+
+} // namespace
+
 SampleBuffer::SampleBuffer(const SampleFrame* data, size_t numFrames, int sampleRate)
 	: m_data(data, data + numFrames)
 	, m_sampleRate(sampleRate)
@@ -47,10 +202,29 @@ SampleBuffer::SampleBuffer(std::vector<SampleFrame> data, int sampleRate, const
 {
 }
 
+SampleBuffer::SampleBuffer(std::shared_ptr<const SampleStream> stream, const QString& audioFile)
+	: m_stream(std::move(stream))
+	, m_audioFile(audioFile)
+	, m_sampleRate(m_stream->sampleRate())
+{
+}
+
+SampleBuffer::SampleBuffer(
+	std::vector<sample_t> samples, std::vector<SampleFrame> levels, int sampleRate, const QString& audioFile)
+	: m_samples(std::move(samples))
+	, m_levels(std::move(levels))
+	, m_audioFile(audioFile)
+	, m_sampleRate(sampleRate)
+{
+}
+
 void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 {
 	using std::swap;
 	swap(first.m_data, second.m_data);
+	swap(first.m_stream, second.m_stream);
+	swap(first.m_samples, second.m_samples);
+	swap(first.m_levels, second.m_levels);
 	swap(first.m_audioFile, second.m_audioFile);
 	swap(first.m_sampleRate, second.m_sampleRate);
 }
@@ -58,9 +232,16 @@ void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 QString SampleBuffer::toBase64() const
 {
 	// TODO: Replace with non-Qt equivalent
-	const auto data = reinterpret_cast<const char*>(m_data.data());
-	const auto size = static_cast<int>(m_data.size() * sizeof(SampleFrame));
-	const auto byteArray = QByteArray{data, size};
+	const auto size = static_cast<int>(this->size() * sizeof(SampleFrame));
+	if (m_levels.empty()) { return QByteArray{reinterpret_cast<const char*>(data()), size}.toBase64(); }
+
+	// embedded samples are always stored as stereo frames
+	auto byteArray = QByteArray(size, Qt::Uninitialized);
+	const auto frames = reinterpret_cast<SampleFrame*>(byteArray.data());
+	for (auto i = std::size_t{0}; i < this->size(); ++i)
+	{
+		frames[i] = frame(i);
+	}
 	return byteArray.toBase64();
 }
 
@@ -74,32 +255,40 @@ std::shared_ptr<const SampleBuffer> SampleBuffer::fromFile(const QString& filePa
 {
 	if (filePath.isEmpty()) { return SampleBuffer::emptyBuffer(); }
 
+	if (auto buffer = SampleLoader::find(filePath)) { return buffer; }
+	if (auto buffer = decodeFile(filePath)) { return buffer; }
+
+	// TODO: Improve error handling. We dont always want to show a message box on failure when there is a GUI (e.g.
+	// when loading the project), and this function also shouldn't be concerned with handling the error.
+	if (gui::getGUI())
+	{
+		QMessageBox::warning(nullptr, QObject::tr("Failed to load sample"),
+			QObject::tr("The sample may be corrupted or unsupported."));
+	}
+	else
+	{
+		qWarning() << QObject::tr(
+			"Failed to load sample at path %1, the file may not exist, be corrupted, or is unsupported.")
+						  .arg(PathUtil::toAbsolute(filePath));
+	}
+
+	return SampleBuffer::emptyBuffer();
+}
+
+std::shared_ptr<const SampleBuffer> SampleBuffer::decodeFile(const QString& filePath)
+{
 	const auto absolutePath = PathUtil::toAbsolute(filePath);
 	const auto storedPath = PathUtil::toShortestRelative(filePath);
 
-	auto result = SampleDecoder::decode(absolutePath);
+	const auto info = QFileInfo{absolutePath};
+	if (!info.exists()) { return decode(absolutePath, storedPath); }
 
-	if (!result)
-	{
-		// TODO: Improve error handling. We dont always want to show a message box on failure when there is a GUI (e.g.
-		// when loading the project), and this function also shouldn't be concerned with handling the error.
-		if (gui::getGUI())
-		{
-			QMessageBox::warning(nullptr, QObject::tr("Failed to load sample"),
-				QObject::tr("The sample may be corrupted or unsupported."));
-		}
-		else
-		{
-			qWarning() << QObject::tr(
-				"Failed to load sample at path %1, the file may not exist, be corrupted, or is unsupported.")
-							  .arg(absolutePath);
-		}
+	// a changed file doesn't match the buffers decoded from it before
+	const auto key = QString{"file:%1\n%2"}.arg(info.canonicalFilePath()).arg(info.lastModified().toMSecsSinceEpoch());
+	if (auto buffer = sharedBuffers().find(key)) { return buffer; }
 
-		return SampleBuffer::emptyBuffer();
-	}
-
-	auto& [data, sampleRate] = *result;
-	return std::make_shared<SampleBuffer>(std::move(data), sampleRate, storedPath);
+	auto buffer = decode(absolutePath, storedPath);
+	return buffer ? sharedBuffers().insert(key, std::move(buffer)) : nullptr;
 }
 
 std::shared_ptr<const SampleBuffer> SampleBuffer::fromBase64(const QString& str, int sampleRate)
@@ -125,9 +314,19 @@ std::shared_ptr<const SampleBuffer> SampleBuffer::fromBase64(const QString& str,
 		return SampleBuffer::emptyBuffer();
 	}
 
+	// embedded samples are copied along with the instruments using them
+	const auto key = QString{"data:%1\n%2"}
+		.arg(QString::fromLatin1(QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex())).arg(sampleRate);
+	if (auto buffer = sharedBuffers().find(key)) { return buffer; }
+
 	auto data = std::vector<SampleFrame>(bytes.size() / sizeof(SampleFrame));
 	std::memcpy(reinterpret_cast<char*>(data.data()), bytes, bytes.size());
-	return std::make_shared<SampleBuffer>(std::move(data), sampleRate);
+	return sharedBuffers().insert(key, std::make_shared<SampleBuffer>(std::move(data), sampleRate));
+}
+
+std::size_t SampleBuffer::sharedBytes()
+{
+	return sharedBuffers().sharedBytes();
 }
 
 } // namespace lmms
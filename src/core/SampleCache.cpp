@@ -0,0 +1,321 @@
+/*
+ * SampleCache.cpp - decoded samples kept on disk between sessions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleCache.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "ConfigManager.h"
+#include "SampleBuffer.h"
+#include "SampleDecoder.h"
+#include "SampleStream.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+/**
+	Precedes the frames in each file, 64 bytes so the frames are aligned like in memory. Stereo frames
+	follow right away, samples with other channels follow the level of each channel, see
+	SampleBuffer::channelLevels().
+*/
+struct Header
+{
+	std::array<char, 8> magic;
+	std::uint32_t version;
+	std::uint32_t sampleRate;
+	std::uint64_t frames;
+	std::uint32_t channels;
+	std::array<std::uint8_t, 36> reserved;
+};
+static_assert(sizeof(Header) == 64);
+
+constexpr auto Magic = std::array<char, 8>{'L', 'M', 'M', 'S', 'P', 'C', 'M', '\0'};
+//! To be increased whenever the layout of the files changes
+constexpr auto Version = std::uint32_t{2};
+
+//! Formats which take noticeably longer to decode than to read
+const auto CompressedSuffixes = QStringList{"flac", "mp3", "oga", "ogg", "opus"};
+
+auto makeHeader(std::size_t frames, int sampleRate, int channels = DEFAULT_CHANNELS) -> Header
+{
+	auto header = Header{};
+	header.magic = Magic;
+	header.version = Version;
+	header.sampleRate = static_cast<std::uint32_t>(sampleRate);
+	header.frames = frames;
+	header.channels = static_cast<std::uint32_t>(channels);
+	return header;
+}
+
+//! Bytes of the levels which precede the samples of an entry which isn't stereo
+auto levelBytes(const Header& header) -> qint64
+{
+	return header.channels == DEFAULT_CHANNELS ? 0 : static_cast<qint64>(header.channels * sizeof(SampleFrame));
+}
+
+auto sampleBytes(const Header& header) -> qint64
+{
+	return static_cast<qint64>(header.frames * header.channels * sizeof(sample_t));
+}
+
+auto writeHeader(QIODevice& file, const Header& header) -> bool
+{
+	return file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+}
+
+//! Open the entry at @p path and read its @p header, or return nullptr if there is no valid entry
+auto openEntry(const QString& path, Header& header) -> std::unique_ptr<QFile>
+{
+	auto file = std::make_unique<QFile>(path);
+	if (!file->open(QIODevice::ReadOnly)
+		|| file->read(reinterpret_cast<char*>(&header), sizeof(Header)) != sizeof(Header)
+		|| header.magic != Magic || header.version != Version || header.channels == 0
+		|| file->size() != static_cast<qint64>(sizeof(Header)) + levelBytes(header) + sampleBytes(header))
+	{
+		return nullptr;
+	}
+
+	// marks the entry as used lately, see SampleCache::trim(). Windows only sets the times of files opened for
+	// writing, so this takes a handle of its own rather than the read-only one which may get mapped
+	auto touch = QFile{path};
+	if (touch.open(QIODevice::ReadWrite))
+	{
+		touch.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+	}
+	return file;
+}
+
+//! Bytes in the cache directory, counted once and then kept up to date by SampleCache::trim()
+struct CacheSize
+{
+	std::mutex mutex;
+	std::optional<qint64> bytes;
+};
+
+auto cacheSize() -> CacheSize&
+{
+	static auto s_size = CacheSize{};
+	return s_size;
+}
+
+} // namespace
+
+
+
+
+SampleCache::SampleCacheEntry::SampleCacheEntry(const QString& audioFile)
+{
+	const auto info = QFileInfo{audioFile};
+	filePath = info.canonicalFilePath();
+	size = info.size();
+	lastModified = info.lastModified();
+}
+
+
+
+
+QString SampleCache::SampleCacheEntry::fileName() const
+{
+	const auto key = QString{"%1\n%2\n%3"}.arg(filePath).arg(size).arg(lastModified.toMSecsSinceEpoch());
+	return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".pcm";
+}
+
+
+
+
+qint64 SampleCache::sizeLimit()
+{
+	return ConfigManager::inst()->value("app", "samplecachesize", QString::number(DefaultSize)).toLongLong();
+}
+
+
+
+
+bool SampleCache::isCached(const QString& audioFile)
+{
+	return ConfigManager::inst()->value("app", "samplecache", "1").toInt() != 0
+		&& CompressedSuffixes.contains(QFileInfo{audioFile}.suffix().toLower());
+}
+
+
+
+
+auto SampleCache::find(const QString& audioFile, std::size_t mapThreshold) -> std::optional<Frames>
+{
+	if (!isCached(audioFile)) { return std::nullopt; }
+
+	const auto entry = SampleCacheEntry{audioFile};
+	if (entry.filePath.isEmpty()) { return std::nullopt; }
+
+	auto header = Header{};
+	auto file = openEntry(QDir{directory()}.filePath(entry.fileName()), header);
+	if (!file) { return std::nullopt; }
+
+	const auto sampleRate = static_cast<int>(header.sampleRate);
+	const auto bytes = sampleBytes(header);
+	const auto stereo = header.channels == DEFAULT_CHANNELS;
+	if (static_cast<std::size_t>(bytes) > mapThreshold)
+	{
+		// streams only play stereo frames, the sample is decoded and streamed again
+		if (!stereo) { return std::nullopt; }
+
+		auto stream = SampleStream::map(std::move(file), sizeof(Header), header.frames, sampleRate);
+		if (!stream) { return std::nullopt; }
+		return Frames{.stream = std::move(stream), .sampleRate = sampleRate};
+	}
+
+	// short samples are read right away, mapped ones could have the audio thread wait for the disk
+	if (stereo)
+	{
+		auto data = std::vector<SampleFrame>(header.frames);
+		if (file->read(reinterpret_cast<char*>(data.data()), bytes) != bytes) { return std::nullopt; }
+		return Frames{.data = std::move(data), .sampleRate = sampleRate};
+	}
+
+	auto levels = std::vector<SampleFrame>(header.channels);
+	auto samples = std::vector<sample_t>(header.frames * header.channels);
+	if (file->read(reinterpret_cast<char*>(levels.data()), levelBytes(header)) != levelBytes(header)
+		|| file->read(reinterpret_cast<char*>(samples.data()), bytes) != bytes)
+	{
+		return std::nullopt;
+	}
+	return Frames{.sampleRate = sampleRate, .samples = std::move(samples), .levels = std::move(levels)};
+}
+
+
+
+
+void SampleCache::store(const QString& audioFile, const SampleBuffer& buffer)
+{
+	if (!isCached(audioFile)) { return; }
+
+	const auto entry = SampleCacheEntry{audioFile};
+	if (entry.filePath.isEmpty() || !QDir{}.mkpath(directory())) { return; }
+
+	// only shows up under its name once it's complete, so other instances never map half a file
+	auto file = QSaveFile{QDir{directory()}.filePath(entry.fileName())};
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	const auto header = makeHeader(buffer.size(), static_cast<int>(buffer.sampleRate()), buffer.channels());
+	const auto& levels = buffer.channelLevels();
+	if (!writeHeader(file, header)
+		|| (!levels.empty()
+			&& file.write(reinterpret_cast<const char*>(levels.data()), levelBytes(header)) != levelBytes(header))
+		|| file.write(reinterpret_cast<const char*>(buffer.samples()), sampleBytes(header)) != sampleBytes(header))
+	{
+		file.cancelWriting();
+	}
+	if (file.commit()) { trim(static_cast<qint64>(sizeof(Header)) + levelBytes(header) + sampleBytes(header)); }
+}
+
+
+
+
+auto SampleCache::decode(const QString& audioFile) -> std::shared_ptr<const SampleStream>
+{
+	if (!isCached(audioFile)) { return nullptr; }
+
+	const auto entry = SampleCacheEntry{audioFile};
+	if (entry.filePath.isEmpty() || !QDir{}.mkpath(directory())) { return nullptr; }
+
+	auto file = QSaveFile{QDir{directory()}.filePath(entry.fileName())};
+	if (!file.open(QIODevice::WriteOnly) || !writeHeader(file, makeHeader(0, 0))) { return nullptr; }
+
+	const auto sampleRate = SampleDecoder::decode(audioFile, file);
+	if (!sampleRate)
+	{
+		file.cancelWriting();
+		return nullptr;
+	}
+
+	// a decoder which gave up may have left more behind than the one which succeeded
+	const auto end = file.pos();
+	const auto frames = static_cast<std::size_t>(end - sizeof(Header)) / sizeof(SampleFrame);
+	if (!file.resize(end) || !file.seek(0) || !writeHeader(file, makeHeader(frames, *sampleRate))
+		|| !file.commit())
+	{
+		return nullptr;
+	}
+
+	trim(end);
+
+	auto header = Header{};
+	auto mapped = openEntry(QDir{directory()}.filePath(entry.fileName()), header);
+	if (!mapped) { return nullptr; }
+	return SampleStream::map(std::move(mapped), sizeof(Header), header.frames, static_cast<int>(header.sampleRate));
+}
+
+
+
+
+QString SampleCache::directory()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/samples";
+}
+
+
+
+
+void SampleCache::trim(qint64 addedBytes)
+{
+	const auto limit = sizeLimit() * 1024 * 1024;
+	auto& size = cacheSize();
+	const auto lock = std::lock_guard{size.mutex};
+
+	if (size.bytes)
+	{
+		*size.bytes += addedBytes;
+		if (*size.bytes <= limit) { return; }
+	}
+
+	// counts the directory the first time and when over the limit, which also catches entries other instances
+	// added, most recently used first
+	const auto entries = QDir{directory()}.entryInfoList({"*.pcm"}, QDir::Files, QDir::Time);
+
+	// streams left behind by crashed instances, see SampleStream::decode()
+	const auto staleStreams = QDateTime::currentDateTime().addDays(-1);
+	for (const auto& info : QDir{directory()}.entryInfoList({"stream-*.tmp"}, QDir::Files))
+	{
+		if (info.lastModified() < staleStreams) { QFile::remove(info.filePath()); }
+	}
+	auto total = qint64{0};
+	for (const auto& info : entries)
+	{
+		// may fail for entries which are mapped right now on some systems, they go next time
+		if (total + info.size() > limit && QFile::remove(info.filePath())) { continue; }
+		total += info.size();
+	}
+	size.bytes = total;
+}
+
+} // namespace lmms
@@ -26,7 +26,10 @@
 
 #include <QFile>
 #include <QString>
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <mutex>
 #include <sndfile.h>
 
 #ifdef LMMS_HAVE_OGGVORBIS
@@ -43,6 +46,10 @@ namespace lmms {
 namespace {
 
 using Decoder = std::optional<SampleDecoder::Result> (*)(const QString&);
+using StreamDecoder = std::optional<int> (*)(const QString&, QIODevice&);
+
+//! Frames decoded at once by the stream decoders
+constexpr auto StreamBlockFrames = std::size_t{16384};
 
 auto decodeSampleSF(const QString& audioFile) -> std::optional<SampleDecoder::Result>;
 auto decodeSampleDS(const QString& audioFile) -> std::optional<SampleDecoder::Result>;
@@ -56,52 +63,231 @@ static constexpr std::array<Decoder, 3> decoders = {&decodeSampleSF,
 #endif
 	&decodeSampleDS};
 
+auto streamSampleSF(const QString& audioFile, QIODevice& output) -> std::optional<int>;
+auto streamSampleDS(const QString& audioFile, QIODevice& output) -> std::optional<int>;
+#ifdef LMMS_HAVE_OGGVORBIS
+auto streamSampleOggVorbis(const QString& audioFile, QIODevice& output) -> std::optional<int>;
+#endif
+
+static constexpr std::array<StreamDecoder, 3> streamDecoders = {&streamSampleSF,
+#ifdef LMMS_HAVE_OGGVORBIS
+	&streamSampleOggVorbis,
+#endif
+	&streamSampleDS};
+
+auto writeFrames(QIODevice& output, const SampleFrame* frames, std::size_t count) -> bool
+{
+	const auto bytes = static_cast<qint64>(count * sizeof(SampleFrame));
+	return output.write(reinterpret_cast<const char*>(frames), bytes) == bytes;
+}
+
+//! Where a channel of an audio file is heard, which decides how it's mixed into the stereo sample
+enum class ChannelPosition
+{
+	Mono,
+	Left,
+	Right,
+	Center,
+	SurroundLeft,
+	SurroundRight,
+	LowFrequency
+};
+
+//! Level of each channel of an audio file in the left and right channel of the decoded sample
+using ChannelLevels = std::vector<SampleFrame>;
+
+auto channelLevels(const std::vector<ChannelPosition>& positions) -> ChannelLevels
+{
+	// the usual downmix levels, e.g. ITU-R BS.775 without the bass channel
+	constexpr auto MixLevel = 0.7071f;
+
+	auto levels = ChannelLevels{};
+	for (const auto position : positions)
+	{
+		switch (position)
+		{
+			case ChannelPosition::Mono: levels.emplace_back(1.f, 1.f); break;
+			case ChannelPosition::Left: levels.emplace_back(1.f, 0.f); break;
+			case ChannelPosition::Right: levels.emplace_back(0.f, 1.f); break;
+			case ChannelPosition::Center: levels.emplace_back(MixLevel, MixLevel); break;
+			case ChannelPosition::SurroundLeft: levels.emplace_back(MixLevel, 0.f); break;
+			case ChannelPosition::SurroundRight: levels.emplace_back(0.f, MixLevel); break;
+			case ChannelPosition::LowFrequency: levels.emplace_back(0.f, 0.f); break;
+		}
+	}
+	return levels;
+}
+
+//! Positions of channels nothing is known about: the first ones at the front, the others around
+auto defaultChannelPosition(int channel) -> ChannelPosition
+{
+	if (channel < 2) { return channel == 0 ? ChannelPosition::Left : ChannelPosition::Right; }
+	return channel % 2 == 0 ? ChannelPosition::SurroundLeft : ChannelPosition::SurroundRight;
+}
+
+//! Mix @p count frames of interleaved @p samples down to stereo
+void mixDown(const float* samples, const ChannelLevels& levels, SampleFrame* frames, std::size_t count)
+{
+	const auto channels = levels.size();
+	for (auto i = std::size_t{0}; i < count; ++i)
+	{
+		auto frame = SampleFrame{};
+		for (auto channel = std::size_t{0}; channel < channels; ++channel)
+		{
+			frame += levels[channel] * samples[i * channels + channel];
+		}
+		frames[i] = frame;
+	}
+}
+
+auto channelLevelsSF(SNDFILE* sndFile, int channels) -> ChannelLevels
+{
+	auto map = std::vector<int>(channels);
+	const auto hasMap = sf_command(sndFile, SFC_GET_CHANNEL_MAP_INFO, map.data(),
+		static_cast<int>(map.size() * sizeof(int))) == SF_TRUE;
+
+	auto positions = std::vector<ChannelPosition>{};
+	for (auto channel = 0; channel < channels; ++channel)
+	{
+		switch (hasMap ? map[channel] : SF_CHANNEL_MAP_INVALID)
+		{
+			case SF_CHANNEL_MAP_MONO:
+				positions.push_back(ChannelPosition::Mono);
+				break;
+			case SF_CHANNEL_MAP_LEFT:
+			case SF_CHANNEL_MAP_FRONT_LEFT:
+				positions.push_back(ChannelPosition::Left);
+				break;
+			case SF_CHANNEL_MAP_RIGHT:
+			case SF_CHANNEL_MAP_FRONT_RIGHT:
+				positions.push_back(ChannelPosition::Right);
+				break;
+			case SF_CHANNEL_MAP_CENTER:
+			case SF_CHANNEL_MAP_FRONT_CENTER:
+			case SF_CHANNEL_MAP_REAR_CENTER:
+			case SF_CHANNEL_MAP_TOP_CENTER:
+			case SF_CHANNEL_MAP_TOP_FRONT_CENTER:
+			case SF_CHANNEL_MAP_TOP_REAR_CENTER:
+				positions.push_back(ChannelPosition::Center);
+				break;
+			case SF_CHANNEL_MAP_REAR_LEFT:
+			case SF_CHANNEL_MAP_SIDE_LEFT:
+			case SF_CHANNEL_MAP_FRONT_LEFT_OF_CENTER:
+			case SF_CHANNEL_MAP_TOP_FRONT_LEFT:
+			case SF_CHANNEL_MAP_TOP_REAR_LEFT:
+				positions.push_back(ChannelPosition::SurroundLeft);
+				break;
+			case SF_CHANNEL_MAP_REAR_RIGHT:
+			case SF_CHANNEL_MAP_SIDE_RIGHT:
+			case SF_CHANNEL_MAP_FRONT_RIGHT_OF_CENTER:
+			case SF_CHANNEL_MAP_TOP_FRONT_RIGHT:
+			case SF_CHANNEL_MAP_TOP_REAR_RIGHT:
+				positions.push_back(ChannelPosition::SurroundRight);
+				break;
+			case SF_CHANNEL_MAP_LFE:
+				positions.push_back(ChannelPosition::LowFrequency);
+				break;
+			default:
+				positions.push_back(defaultChannelPosition(channel));
+				break;
+		}
+	}
+	return channelLevels(positions);
+}
+
+/**
+ * Read up to @p count frames from @p sndFile straight into @p frames and return how many were read
+ *
+ * Mono and stereo files are read without any buffer in between, files with
+ * more channels are read and mixed down to stereo a block at a time.
+ */
+auto readFramesSF(SNDFILE* sndFile, int channels, SampleFrame* frames, std::size_t count) -> std::size_t
+{
+	const auto readFrames = [sndFile](float* samples, std::size_t length) {
+		return static_cast<std::size_t>(
+			std::max<sf_count_t>(sf_readf_float(sndFile, samples, static_cast<sf_count_t>(length)), 0));
+	};
+
+	// a SampleFrame has the layout of an interleaved stereo frame
+	if (channels == 2) { return readFrames(frames->data(), count); }
+
+	if (channels == 1)
+	{
+		// reads into the first half of the frames and spreads the samples out from the back, so every sample is
+		// moved before its place is overwritten
+		const auto samples = frames->data();
+		const auto read = readFrames(samples, count);
+		for (auto i = read; i-- > 0;)
+		{
+			frames[i] = SampleFrame{samples[i]};
+		}
+		return read;
+	}
+
+	const auto levels = channelLevelsSF(sndFile, channels);
+	auto block = std::vector<float>(StreamBlockFrames * channels);
+	auto total = std::size_t{0};
+	while (total < count)
+	{
+		const auto read = readFrames(block.data(), std::min(StreamBlockFrames, count - total));
+		if (read == 0) { break; }
+
+		mixDown(block.data(), levels, frames + total, read);
+		total += read;
+	}
+	return total;
+}
+
 auto decodeSampleSF(const QString& audioFile) -> std::optional<SampleDecoder::Result>
 {
-	SNDFILE* sndFile = nullptr;
 	auto sfInfo = SF_INFO{};
 
 	// TODO: Remove use of QFile
 	auto file = QFile{audioFile};
 	if (!file.open(QIODevice::ReadOnly)) { return std::nullopt; }
 
-	sndFile = sf_open_fd(file.handle(), SFM_READ, &sfInfo, false);
+	SNDFILE* sndFile = sf_open_fd(file.handle(), SFM_READ, &sfInfo, false);
 	if (sf_error(sndFile) != 0) { return std::nullopt; }
 
-	auto buf = std::vector<sample_t>(sfInfo.channels * sfInfo.frames);
-	sf_read_float(sndFile, buf.data(), buf.size());
-
-	sf_close(sndFile);
-	file.close();
+	const auto frames = static_cast<std::size_t>(std::max<sf_count_t>(sfInfo.frames, 0));
+	auto result = SampleDecoder::Result{.data = {}, .sampleRate = static_cast<int>(sfInfo.samplerate)};
+	if (sfInfo.channels == 2)
+	{
+		result.data.resize(frames);
+		const auto read = readFramesSF(sndFile, sfInfo.channels, result.data.data(), frames);
 
-	auto result = std::vector<SampleFrame>(sfInfo.frames);
-	for (int i = 0; i < static_cast<int>(result.size()); ++i)
+		// the length in the header of some formats is only an estimate
+		result.data.resize(read);
+	}
+	else
 	{
-		if (sfInfo.channels == 1)
-		{
-			// Upmix from mono to stereo
-			result[i] = {buf[i], buf[i]};
-		}
-		else if (sfInfo.channels > 1)
-		{
-			// TODO: Add support for higher number of channels (i.e., 5.1 channel systems)
-			// The current behavior assumes stereo in all cases excluding mono.
-			// This may not be the expected behavior, given some audio files with a higher number of channels.
-			result[i] = {buf[i * sfInfo.channels], buf[i * sfInfo.channels + 1]};
-		}
+		// other files are kept as they are and mixed to stereo while playing
+		const auto channels = static_cast<std::size_t>(sfInfo.channels);
+		result.samples.resize(frames * channels);
+		result.levels = channels == 1 ? ChannelLevels{SampleFrame{1.f}} : channelLevelsSF(sndFile, sfInfo.channels);
+		const auto read = sf_readf_float(sndFile, result.samples.data(), static_cast<sf_count_t>(frames));
+		result.samples.resize(static_cast<std::size_t>(std::max<sf_count_t>(read, 0)) * channels);
 	}
 
-	return SampleDecoder::Result{std::move(result), static_cast<int>(sfInfo.samplerate)};
+	sf_close(sndFile);
+	file.close();
+
+	return result;
 }
 
 auto decodeSampleDS(const QString& audioFile) -> std::optional<SampleDecoder::Result>
 {
+	// DrumSynth keeps its state in globals, so only one sound can be generated at a time
+	static auto s_mutex = std::mutex{};
+
 	// Populated by DrumSynth::GetDSFileSamples
 	int_sample_t* dataPtr = nullptr;
 
 	auto ds = DrumSynth{};
 	const auto engineRate = Engine::audioEngine()->outputSampleRate();
+	auto lock = std::unique_lock{s_mutex};
 	const auto frames = ds.GetDSFileSamples(audioFile, dataPtr, DEFAULT_CHANNELS, engineRate);
+	lock.unlock();
 	const auto data = std::unique_ptr<int_sample_t[]>{dataPtr}; // NOLINT, we have to use a C-style array here
 
 	if (frames <= 0 || !data) { return std::nullopt; }
@@ -113,7 +299,8 @@ auto decodeSampleDS(const QString& audioFile) -> std::optional<SampleDecoder::Re
 }
 
 #ifdef LMMS_HAVE_OGGVORBIS
-auto decodeSampleOggVorbis(const QString& audioFile) -> std::optional<SampleDecoder::Result>
+//! Open @p file with libvorbisfile, which closes it again in ov_clear()
+auto openOggVorbis(QFile& file, OggVorbis_File& vorbisFile) -> bool
 {
 	static auto s_read = [](void* buffer, size_t size, size_t count, void* stream) -> size_t {
 		auto file = static_cast<QFile*>(stream);
@@ -142,45 +329,201 @@ auto decodeSampleOggVorbis(const QString& audioFile) -> std::optional<SampleDeco
 
 	static ov_callbacks s_callbacks = {s_read, s_seek, s_close, s_tell};
 
+	return ov_open_callbacks(&file, &vorbisFile, nullptr, 0, s_callbacks) == 0;
+}
+
+//! Mix @p count frames of one array per channel down to stereo
+void mixDown(const float* const* samples, const ChannelLevels& levels, SampleFrame* frames, std::size_t count)
+{
+	for (auto i = std::size_t{0}; i < count; ++i)
+	{
+		auto frame = SampleFrame{};
+		for (auto channel = std::size_t{0}; channel < levels.size(); ++channel)
+		{
+			frame += levels[channel] * samples[channel][i];
+		}
+		frames[i] = frame;
+	}
+}
+
+//! Interleave @p count frames of one array per channel into @p samples
+void interleave(const float* const* pcm, std::size_t channels, float* samples, std::size_t count)
+{
+	for (auto i = std::size_t{0}; i < count; ++i)
+	{
+		for (auto channel = std::size_t{0}; channel < channels; ++channel)
+		{
+			samples[i * channels + channel] = pcm[channel][i];
+		}
+	}
+}
+
+auto channelLevelsOggVorbis(int channels) -> ChannelLevels
+{
+	using Position = ChannelPosition;
+
+	// the channel orders of the Vorbis I specification, section 4.3.9
+	static const auto s_orders = std::array<std::vector<Position>, 9>{{
+		{},
+		{Position::Mono},
+		{Position::Left, Position::Right},
+		{Position::Left, Position::Center, Position::Right},
+		{Position::Left, Position::Right, Position::SurroundLeft, Position::SurroundRight},
+		{Position::Left, Position::Center, Position::Right, Position::SurroundLeft, Position::SurroundRight},
+		{Position::Left, Position::Center, Position::Right, Position::SurroundLeft, Position::SurroundRight,
+			Position::LowFrequency},
+		{Position::Left, Position::Center, Position::Right, Position::SurroundLeft, Position::SurroundRight,
+			Position::Center, Position::LowFrequency},
+		{Position::Left, Position::Center, Position::Right, Position::SurroundLeft, Position::SurroundRight,
+			Position::SurroundLeft, Position::SurroundRight, Position::LowFrequency},
+	}};
+	if (channels < static_cast<int>(s_orders.size())) { return channelLevels(s_orders[channels]); }
+
+	// the order of more channels is up to the application which wrote the file
+	auto positions = std::vector<Position>{};
+	for (auto channel = 0; channel < channels; ++channel)
+	{
+		positions.push_back(defaultChannelPosition(channel));
+	}
+	return channelLevels(positions);
+}
+
+auto decodeSampleOggVorbis(const QString& audioFile) -> std::optional<SampleDecoder::Result>
+{
 	// TODO: Remove use of QFile
 	auto file = QFile{audioFile};
 	if (!file.open(QIODevice::ReadOnly)) { return std::nullopt; }
 
 	auto vorbisFile = OggVorbis_File{};
-	if (ov_open_callbacks(&file, &vorbisFile, nullptr, 0, s_callbacks) < 0) { return std::nullopt; }
+	if (!openOggVorbis(file, vorbisFile)) { return std::nullopt; }
 
 	const auto vorbisInfo = ov_info(&vorbisFile, -1);
-	if (vorbisInfo == nullptr) { return std::nullopt; }
+	const auto numFrames = ov_pcm_total(&vorbisFile, -1);
+	if (vorbisInfo == nullptr || numFrames < 0)
+	{
+		ov_clear(&vorbisFile);
+		return std::nullopt;
+	}
 
-	const auto numChannels = vorbisInfo->channels;
-	const auto sampleRate = vorbisInfo->rate;
-	const auto numSamples = ov_pcm_total(&vorbisFile, -1);
-	if (numSamples < 0) { return std::nullopt; }
+	const auto channels = static_cast<std::size_t>(vorbisInfo->channels);
+	const auto frames = static_cast<std::size_t>(numFrames);
+	const auto levels = channelLevelsOggVorbis(vorbisInfo->channels);
 
-	auto buffer = std::vector<float>(numSamples);
-	auto output = static_cast<float**>(nullptr);
+	// stereo files are decoded into frames, other files are kept as they are and mixed to stereo while playing
+	auto result = SampleDecoder::Result{.data = {}, .sampleRate = static_cast<int>(vorbisInfo->rate)};
+	if (channels == 2) { result.data.resize(frames); }
+	else
+	{
+		result.samples.resize(frames * channels);
+		result.levels = levels;
+	}
 
-	auto totalSamplesRead = 0;
-	while (true)
+	auto pcm = static_cast<float**>(nullptr);
+	auto section = 0;
+	auto total = std::size_t{0};
+	while (total < frames)
+	{
+		// ov_read_float() returns one array per channel, which are interleaved straight into the result
+		const auto framesRead = ov_read_float(&vorbisFile, &pcm,
+			static_cast<int>(std::min(StreamBlockFrames, frames - total)), &section);
+		if (framesRead < 0)
+		{
+			ov_clear(&vorbisFile);
+			return std::nullopt;
+		}
+		if (framesRead == 0) { break; }
+
+		const auto read = static_cast<std::size_t>(framesRead);
+		if (channels == 2) { mixDown(pcm, levels, result.data.data() + total, read); }
+		else { interleave(pcm, channels, result.samples.data() + total * channels, read); }
+		total += read;
+	}
+
+	ov_clear(&vorbisFile);
+	if (channels == 2) { result.data.resize(total); }
+	else { result.samples.resize(total * channels); }
+	return result;
+}
+#endif // LMMS_HAVE_OGGVORBIS
+
+auto streamSampleSF(const QString& audioFile, QIODevice& output) -> std::optional<int>
+{
+	auto sfInfo = SF_INFO{};
+
+	// TODO: Remove use of QFile
+	auto file = QFile{audioFile};
+	if (!file.open(QIODevice::ReadOnly)) { return std::nullopt; }
+
+	SNDFILE* sndFile = sf_open_fd(file.handle(), SFM_READ, &sfInfo, false);
+	if (sf_error(sndFile) != 0) { return std::nullopt; }
+
+	auto frames = std::vector<SampleFrame>(StreamBlockFrames);
+	auto written = true;
+	while (written)
 	{
-		auto samplesRead = ov_read_float(&vorbisFile, &output, numSamples, 0);
+		const auto read = readFramesSF(sndFile, sfInfo.channels, frames.data(), frames.size());
+		if (read == 0) { break; }
+
+		written = writeFrames(output, frames.data(), read);
+	}
+
+	sf_close(sndFile);
+	if (!written) { return std::nullopt; }
+	return static_cast<int>(sfInfo.samplerate);
+}
+
+auto streamSampleDS(const QString& audioFile, QIODevice& output) -> std::optional<int>
+{
+	// DrumSynth sounds are short and generated in one go anyway
+	const auto result = decodeSampleDS(audioFile);
+	if (!result || !writeFrames(output, result->data.data(), result->data.size())) { return std::nullopt; }
+	return result->sampleRate;
+}
+
+#ifdef LMMS_HAVE_OGGVORBIS
+auto streamSampleOggVorbis(const QString& audioFile, QIODevice& output) -> std::optional<int>
+{
+	// TODO: Remove use of QFile
+	auto file = QFile{audioFile};
+	if (!file.open(QIODevice::ReadOnly)) { return std::nullopt; }
 
-		if (samplesRead < 0) { return std::nullopt; }
-		else if (samplesRead == 0) { break; }
+	auto vorbisFile = OggVorbis_File{};
+	if (!openOggVorbis(file, vorbisFile)) { return std::nullopt; }
 
-		std::copy_n(*output, samplesRead, buffer.begin() + totalSamplesRead);
-		totalSamplesRead += samplesRead;
+	const auto vorbisInfo = ov_info(&vorbisFile, -1);
+	if (vorbisInfo == nullptr)
+	{
+		ov_clear(&vorbisFile);
+		return std::nullopt;
 	}
 
-	auto result = std::vector<SampleFrame>(totalSamplesRead / numChannels);
-	for (auto i = std::size_t{0}; i < result.size(); ++i)
+	const auto sampleRate = static_cast<int>(vorbisInfo->rate);
+	const auto levels = channelLevelsOggVorbis(vorbisInfo->channels);
+
+	auto frames = std::vector<SampleFrame>(StreamBlockFrames);
+	auto pcm = static_cast<float**>(nullptr);
+	auto section = 0;
+	while (true)
 	{
-		if (numChannels == 1) { result[i] = {buffer[i], buffer[i]}; }
-		else if (numChannels > 1) { result[i] = {buffer[i * numChannels], buffer[i * numChannels + 1]}; }
+		// ov_read_float() returns one array per channel
+		const auto framesRead = ov_read_float(&vorbisFile, &pcm, static_cast<int>(StreamBlockFrames), &section);
+		if (framesRead < 0)
+		{
+			ov_clear(&vorbisFile);
+			return std::nullopt;
+		}
+		if (framesRead == 0) { break; }
+
+		mixDown(pcm, levels, frames.data(), static_cast<std::size_t>(framesRead));
+		if (!writeFrames(output, frames.data(), static_cast<std::size_t>(framesRead)))
+		{
+			ov_clear(&vorbisFile);
+			return std::nullopt;
+		}
 	}
 
 	ov_clear(&vorbisFile);
-	return SampleDecoder::Result{std::move(result), static_cast<int>(sampleRate)};
+	return sampleRate;
 }
 #endif // LMMS_HAVE_OGGVORBIS
 } // namespace
@@ -232,4 +575,57 @@ auto SampleDecoder::decode(const QString& audioFile) -> std::optional<Result>
 	return result;
 }
 
+auto SampleDecoder::decode(const QString& audioFile, Library library) -> std::optional<Result>
+{
+	switch (library)
+	{
+		case Library::SndFile: return decodeSampleSF(audioFile);
+#ifdef LMMS_HAVE_OGGVORBIS
+		case Library::OggVorbis: return decodeSampleOggVorbis(audioFile);
+#else
+		case Library::OggVorbis: return std::nullopt;
+#endif
+		case Library::DrumSynth: return decodeSampleDS(audioFile);
+	}
+	return std::nullopt;
+}
+
+auto SampleDecoder::decode(const QString& audioFile, QIODevice& output) -> std::optional<int>
+{
+	const auto start = output.pos();
+	for (const auto& decoder : streamDecoders)
+	{
+		// start over if a decoder gave up halfway through the file
+		if (!output.seek(start)) { return std::nullopt; }
+		if (const auto sampleRate = decoder(audioFile, output)) { return sampleRate; }
+	}
+
+	return std::nullopt;
+}
+
+auto SampleDecoder::frameCount(const QString& audioFile) -> std::optional<f_cnt_t>
+{
+	auto file = QFile{audioFile};
+	if (!file.open(QIODevice::ReadOnly)) { return std::nullopt; }
+
+	auto sfInfo = SF_INFO{};
+	if (SNDFILE* sndFile = sf_open_fd(file.handle(), SFM_READ, &sfInfo, false))
+	{
+		sf_close(sndFile);
+		return static_cast<f_cnt_t>(sfInfo.frames);
+	}
+
+#ifdef LMMS_HAVE_OGGVORBIS
+	auto vorbisFile = OggVorbis_File{};
+	if (file.seek(0) && openOggVorbis(file, vorbisFile))
+	{
+		const auto frames = ov_pcm_total(&vorbisFile, -1);
+		ov_clear(&vorbisFile);
+		if (frames >= 0) { return static_cast<f_cnt_t>(frames); }
+	}
+#endif
+
+	return std::nullopt;
+}
+
 } // namespace lmms
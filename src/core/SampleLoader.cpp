@@ -0,0 +1,115 @@
+/*
+ * SampleLoader.cpp - decodes the samples of a project while it is loaded
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleLoader.h"
+
+#include <QDomElement>
+
+#include "PathUtil.h"
+#include "SampleBuffer.h"
+#include "ThreadPool.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+//! Elements whose "src" attribute is loaded with SampleBuffer::fromFile()
+const auto SampleElements = QStringList{"sampleclip", "audiofileprocessor", "slicert"};
+
+} // namespace
+
+thread_local SampleLoader* SampleLoader::s_current = nullptr;
+
+
+
+
+SampleLoader::SampleLoader(const QDomElement& content) :
+	m_previous(s_current)
+{
+	for (const auto& tagName : SampleElements)
+	{
+		const auto elements = content.elementsByTagName(tagName);
+		for (int i = 0; i < elements.count(); ++i)
+		{
+			const auto audioFile = elements.item(i).toElement().attribute("src");
+			if (audioFile.isEmpty()) { continue; }
+
+			const auto absolutePath = PathUtil::toAbsolute(audioFile);
+			if (m_buffers.contains(absolutePath)) { continue; }
+
+			auto buffer = ThreadPool::instance().enqueue([this, audioFile]() -> std::shared_ptr<const SampleBuffer> {
+				if (m_done) { return nullptr; }
+				auto buffer = SampleBuffer::decodeFile(audioFile);
+				++m_decoded;
+				return buffer;
+			});
+			m_buffers.insert(absolutePath, buffer.share());
+		}
+	}
+
+	s_current = this;
+}
+
+
+
+
+SampleLoader::~SampleLoader()
+{
+	s_current = m_previous;
+
+	m_done = true;
+	for (const auto& buffer : m_buffers)
+	{
+		buffer.wait();
+	}
+}
+
+
+
+
+auto SampleLoader::find(const QString& audioFile) -> std::shared_ptr<const SampleBuffer>
+{
+	if (!s_current) { return nullptr; }
+
+	const auto buffer = s_current->m_buffers.constFind(PathUtil::toAbsolute(audioFile));
+	return buffer != s_current->m_buffers.constEnd() ? buffer->get() : nullptr;
+}
+
+
+
+
+int SampleLoader::decodedCount()
+{
+	return s_current ? s_current->m_decoded.load() : 0;
+}
+
+
+
+
+int SampleLoader::fileCount()
+{
+	return s_current ? s_current->m_buffers.size() : 0;
+}
+
+} // namespace lmms
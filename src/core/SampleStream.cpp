@@ -0,0 +1,296 @@
+/*
+ * SampleStream.cpp - decoded sample kept on disk instead of in memory
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include "SampleCache.h"
+#include "SampleDecoder.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+//! How often the prefetcher looks for new positions to read ahead of, which is as long as
+//! the audio thread may play silence after jumping to a position not read ahead of yet
+constexpr auto PrefetchInterval = std::chrono::milliseconds{20};
+
+} // namespace
+
+
+//! Reads ahead in all streams which are alive, on a thread of its own
+class SampleStream::Prefetcher
+{
+public:
+	static Prefetcher& instance()
+	{
+		static Prefetcher s_prefetcher;
+		return s_prefetcher;
+	}
+
+	void add(std::weak_ptr<const SampleStream> stream)
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		std::erase_if(m_streams, [](const auto& s) { return s.expired(); });
+		m_streams.push_back(std::move(stream));
+	}
+
+private:
+	Prefetcher() :
+		m_thread([this](std::stop_token token) { run(token); })
+	{
+	}
+
+	void run(std::stop_token token)
+	{
+		auto streams = std::vector<std::shared_ptr<const SampleStream>>{};
+		while (!token.stop_requested())
+		{
+			{
+				auto lock = std::unique_lock{m_mutex};
+				m_stopped.wait_for(lock, token, PrefetchInterval, [] { return false; });
+				for (const auto& stream : m_streams)
+				{
+					if (auto s = stream.lock()) { streams.push_back(std::move(s)); }
+				}
+			}
+
+			// reading from disk happens without the lock, so adding streams never waits for it
+			for (const auto& stream : streams)
+			{
+				stream->readAhead();
+			}
+			streams.clear();
+		}
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable_any m_stopped;
+	std::vector<std::weak_ptr<const SampleStream>> m_streams;
+	std::jthread m_thread; // last, so it's stopped before the other members are destroyed
+};
+
+
+
+
+auto SampleStream::decode(const QString& audioFile) -> std::shared_ptr<const SampleStream>
+{
+	// next to the sample cache, the system's temporary directory is often kept in RAM
+	const auto directory = SampleCache::directory();
+	if (!QDir{}.mkpath(directory)) { return nullptr; }
+
+	auto file = std::make_unique<QTemporaryFile>(QDir{directory}.filePath("stream-XXXXXX.tmp"));
+	if (!file->open()) { return nullptr; }
+
+	const auto sampleRate = SampleDecoder::decode(audioFile, *file);
+	if (!sampleRate) { return nullptr; }
+
+	// a decoder which gave up may have left more behind than the one which succeeded
+	const auto bytes = file->pos();
+	if (!file->flush() || !file->resize(bytes)) { return nullptr; }
+
+	return map(std::move(file), 0, static_cast<std::size_t>(bytes) / sizeof(SampleFrame), *sampleRate);
+}
+
+
+
+
+auto SampleStream::map(std::unique_ptr<QFile> file, qint64 offset, std::size_t size, int sampleRate)
+	-> std::shared_ptr<const SampleStream>
+{
+	auto stream = std::shared_ptr<SampleStream>{new SampleStream{}};
+	if (size > 0)
+	{
+		const auto data = file->map(offset, static_cast<qint64>(size * sizeof(SampleFrame)));
+		if (!data) { return nullptr; }
+		stream->m_data = reinterpret_cast<const SampleFrame*>(data);
+	}
+	stream->m_file = std::move(file);
+	stream->m_size = size;
+	stream->m_sampleRate = sampleRate;
+
+	const auto blocks = (size + BlockFrames - 1) / BlockFrames;
+	stream->m_blockSlots = std::make_unique<std::atomic<std::uint32_t>[]>(blocks);
+	std::for_each_n(stream->m_blockSlots.get(), blocks, [](auto& slot) { slot.store(NoSlot, std::memory_order_relaxed); });
+	stream->m_slots.resize(std::min(blocks, MaxLoadedBlocks));
+	stream->m_loaded.resize(stream->m_slots.size() * BlockFrames);
+
+	Prefetcher::instance().add(stream);
+	return stream;
+}
+
+
+
+
+SampleStream::~SampleStream() = default;
+
+
+
+
+SampleStream::Reader::Reader(const SampleStream& stream) :
+	m_stream(stream),
+	m_epoch(stream.m_readEpoch.load(std::memory_order_relaxed) % 2)
+{
+	m_stream.m_readers[m_epoch].fetch_add(1, std::memory_order_relaxed);
+	// pairs with the fence in load(), so either it waits for this reader or this reader sees the block gone
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+
+
+
+SampleStream::Reader::~Reader()
+{
+	m_stream.m_readers[m_epoch].fetch_sub(1, std::memory_order_release);
+}
+
+
+
+
+void SampleStream::prefetch(f_cnt_t frame, bool backwards) const
+{
+	const auto position = static_cast<std::int64_t>(frame) + 1;
+	const auto slot = m_nextRequest.fetch_add(1, std::memory_order_relaxed) % MaxRequests;
+	m_requests[slot].store(backwards ? -position : position, std::memory_order_relaxed);
+}
+
+
+
+
+void SampleStream::prefetchUpcoming(f_cnt_t frame, bool backwards) const
+{
+	const auto position = static_cast<std::int64_t>(frame) + 1;
+	const auto request = backwards ? -position : position;
+
+	// take a free slot unless the position is waiting already, and drop it if there is none
+	for (auto& slot : m_upcomingRequests)
+	{
+		auto expected = std::int64_t{0};
+		if (slot.compare_exchange_strong(expected, request, std::memory_order_relaxed) || expected == request)
+		{
+			return;
+		}
+	}
+}
+
+
+
+
+void SampleStream::readAhead() const
+{
+	++m_readAheads;
+
+	//! Blocks to be loaded for a position, starting with the one it's in
+	struct Window
+	{
+		std::size_t first;
+		std::size_t count;
+		bool backwards;
+	};
+	auto windows = std::array<Window, MaxRequests + MaxUpcomingRequests>{};
+	auto windowCount = std::size_t{0};
+
+	const auto window = static_cast<std::size_t>(PrefetchSeconds) * static_cast<std::size_t>(m_sampleRate);
+	const auto addWindow = [&](std::atomic<std::int64_t>& request)
+	{
+		const auto position = request.exchange(0, std::memory_order_relaxed);
+		if (position == 0 || m_size == 0) { return; }
+
+		const auto frame = std::min(static_cast<std::size_t>(std::abs(position) - 1), m_size - 1);
+		const auto last = position > 0 ? std::min(frame + window, m_size - 1) : frame - std::min(frame, window);
+		const auto first = frame / BlockFrames;
+		const auto count = (position > 0 ? last / BlockFrames - first : first - last / BlockFrames) + 1;
+		windows[windowCount++] = {first, count, position < 0};
+	};
+	std::for_each(m_requests.begin(), m_requests.end(), addWindow);
+	std::for_each(m_upcomingRequests.begin(), m_upcomingRequests.end(), addWindow);
+
+	// every position gets its next block before any gets the ones after, in case the slots run out
+	for (auto step = std::size_t{0};; ++step)
+	{
+		auto done = true;
+		for (const auto& w : std::span{windows.data(), windowCount})
+		{
+			if (step >= w.count) { continue; }
+			if (!load(w.backwards ? w.first - step : w.first + step)) { return; }
+			done = false;
+		}
+		if (done) { return; }
+	}
+}
+
+
+
+
+bool SampleStream::load(std::size_t block) const
+{
+	if (const auto slot = m_blockSlots[block].load(std::memory_order_relaxed); slot != NoSlot)
+	{
+		m_slots[slot].wanted = m_readAheads;
+		return true;
+	}
+
+	// reuse the slot which wasn't wanted for the longest time, but none wanted by this read-ahead
+	auto slot = NoSlot;
+	for (auto i = std::uint32_t{0}; i < m_slots.size(); ++i)
+	{
+		if (m_slots[i].wanted < m_readAheads && (slot == NoSlot || m_slots[i].wanted < m_slots[slot].wanted))
+		{
+			slot = i;
+		}
+	}
+	if (slot == NoSlot) { return false; }
+
+	if (m_slots[slot].wanted > 0)
+	{
+		// readers which may still see the old block are done with it before it's overwritten
+		m_blockSlots[m_slots[slot].block].store(NoSlot, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto epoch = m_readEpoch.fetch_add(1, std::memory_order_relaxed) % 2;
+		while (m_readers[epoch].load(std::memory_order_acquire) > 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// reading the mapping may wait for the disk, which is fine on this thread
+	const auto begin = block * BlockFrames;
+	std::copy_n(m_data + begin, std::min(BlockFrames, m_size - begin), m_loaded.begin() + slot * BlockFrames);
+	m_slots[slot] = {block, m_readAheads};
+	m_blockSlots[block].store(slot, std::memory_order_release);
+	return true;
+}
+
+} // namespace lmms
@@ -52,6 +52,7 @@
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "ProjectNotes.h"
+#include "SampleLoader.h"
 #include "Scale.h"
 #include "SongEditor.h"
 #include "PeakController.h"
@@ -94,7 +95,7 @@ Song::Song() :
 	m_loopMidiClip( false ),
 	m_loopRenderCount(1),
 	m_loopRenderRemaining(1),
-	m_oldAutomatedValues()
+	m_automationTimeline()
 {
 	connect( &m_tempoModel, SIGNAL(dataChanged()),
 			this, SLOT(setTempo()), Qt::DirectConnection );
@@ -341,6 +342,13 @@ void Song::processNextBuffer()
 			}
 		}
 
+		if (m_playMode == PlayMode::Song || m_playMode == PlayMode::Pattern)
+		{
+			// let the automated models follow the curves between ticks, too
+			m_automationTimeline.render(frameOffsetInTick / framesPerTick, 1.f / framesPerTick,
+				frameOffsetInPeriod, framesToPlay);
+		}
+
 		// Update frame counters
 		frameOffsetInPeriod += framesToPlay;
 		frameOffsetInTick += framesToPlay;
@@ -354,90 +362,40 @@ void Song::processNextBuffer()
 
 void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, f_cnt_t)
 {
-	AutomatedValueMap values;
-
-	QSet<const AutomatableModel*> recordedModels;
-
-	TrackContainer* container = this;
-	int clipNum = -1;
-
 	switch (m_playMode)
 	{
 	case PlayMode::Song:
+		m_automationTimeline.process(this, timeStart, -1);
 		break;
 	case PlayMode::Pattern:
 	{
 		if (tracklist.empty()) { return; }
 		Q_ASSERT(tracklist.at(0)->type() == Track::Type::Pattern);
 		auto patternTrack = dynamic_cast<PatternTrack*>(tracklist.at(0));
-		container = Engine::patternStore();
-		clipNum = patternTrack->patternIndex();
+		m_automationTimeline.process(Engine::patternStore(), timeStart, patternTrack->patternIndex());
 	}
 		break;
 	default:
 		return;
 	}
+}
 
-	values = container->automatedValuesAt(timeStart, clipNum);
-	const TrackList& tracks = container->tracks();
-
-	Track::clipVector clips;
-	for (Track* track : tracks)
-	{
-		if (track->type() == Track::Type::Automation) {
-			track->getClipsInRange(clips, 0, timeStart);
-		}
-	}
-
-	// Process recording
-	for (Clip* clip : clips)
-	{
-		auto p = dynamic_cast<AutomationClip *>(clip);
-		TimePos relTime = timeStart - p->startPosition();
-		if (p->isRecording() && relTime >= 0 && relTime < p->length())
-		{
-			const AutomatableModel* recordedModel = p->firstObject();
-			// The automation system really needs to be reworked.
-			// For whatever reason, the values in an automation clip are stored in un-un-scaled format, so if you
-			// are automating a log knob, when you draw an curve, the values being stored are not the actual values the
-			// knob will take, but instead the unscaled version of the unscaled numbers. The tooltip shows the number you expect, but if you double-click,
-			// you can see that the true values are stored by their inverse scaled value....which is wrong, since they weren't scaled in the first place...?
-			// Anyhow, in the meantime before we redo the automation system, when recording automations, we have to get the inverseScaledValue
-			// and store that so that when playing it back, it scales the value correctly.
-			p->recordValue(relTime, recordedModel->inverseScaledValue(recordedModel->value<float>()));
-
-			recordedModels << recordedModel;
-		}
-	}
-
-	// Checks if an automated model stopped being automated by automation clip
-	// so we can move the control back to any connected controller again
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		if (!values.contains(am))
-		{
-			am->setUseControllerValue(true);
-		}
-	}
-	m_oldAutomatedValues = values;
-
-	// Apply values
-	for (auto it = values.begin(); it != values.end(); it++)
+void Song::updateAutomationTimeline()
+{
+	switch (m_playMode)
 	{
-		AutomatableModel* model = it.key();
-		bool isRecording = recordedModels.contains(model);
-		model->setUseControllerValue(isRecording);
-
-		if (!isRecording)
+	case PlayMode::Song:
+		m_automationTimeline.update(this, -1, m_globalAutomationTrack);
+		break;
+	case PlayMode::Pattern:
+		// the pattern processNextBuffer() plays
+		if (Engine::patternStore()->numOfPatterns() > 0)
 		{
-			/* TODO
-			 * Remove scaleValue() from here when automation editor's
-			 * Y axis can be set to logarithmic, and automation clips store
-			 * the actual values, and not the invertedScaledValue.
-			 */
-			model->setValue(model->scaledValue(it.value()), true);
+			m_automationTimeline.update(Engine::patternStore(), Engine::patternStore()->currentPattern());
 		}
+		break;
+	default:
+		break;
 	}
 }
 
@@ -508,6 +466,7 @@ void Song::playSong()
 	m_playMode = PlayMode::Song;
 	m_playing = true;
 	m_paused = false;
+	updateAutomationTimeline();
 
 	m_vstSyncController.setPlaybackState( true );
 
@@ -547,6 +506,7 @@ void Song::playPattern()
 	m_playMode = PlayMode::Pattern;
 	m_playing = true;
 	m_paused = false;
+	updateAutomationTimeline();
 
 	m_vstSyncController.setPlaybackState( true );
 
@@ -695,12 +655,7 @@ void Song::stop()
 
 	// Moves the control of the models that were processed on the last frame
 	// back to their controllers.
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		am->setUseControllerValue(true);
-	}
-	m_oldAutomatedValues.clear();
+	m_automationTimeline.release();
 
 	m_playMode = PlayMode::None;
 
@@ -758,6 +713,8 @@ void Song::startExport()
 	m_loopRenderRemaining = m_loopRenderCount;
 
 	playSong();
+	// the first period is rendered with the automation already
+	Engine::audioEngine()->flushChanges();
 
 	m_vstSyncController.setPlaybackState( true );
 }
@@ -899,8 +856,8 @@ void Song::clearProject()
 	m_masterPitchModel.reset();
 	m_timeSigModel.reset();
 
-	// Clear the m_oldAutomatedValues AutomatedValueMap
-	m_oldAutomatedValues.clear();
+	// Forget the automated models, they are about to be deleted
+	m_automationTimeline.clear();
 
 	AutomationClip::globalAutomationClip( &m_tempoModel )->clear();
 	AutomationClip::globalAutomationClip( &m_masterVolumeModel )->
@@ -1066,6 +1023,9 @@ void Song::loadProject( const QString & fileName )
 
 	clearErrors();
 
+	// decodes the samples of the project while the tracks are created, see SampleBuffer::fromFile
+	const SampleLoader sampleLoader{dataFile.content()};
+
 	Engine::audioEngine()->requestChangeInModel();
 
 	// get the header information from the DOM
@@ -1175,6 +1135,20 @@ void Song::loadProject( const QString & fileName )
 	// resolve all IDs so that autoModels are automated
 	AutomationClip::resolveAllIDs();
 
+	// get enough note play handles ready, so playback doesn't need to allocate any
+	auto polyphony = std::size_t{0};
+	for (const auto container : {static_cast<TrackContainer*>(this), static_cast<TrackContainer*>(Engine::patternStore())})
+	{
+		for (const auto track : container->tracks())
+		{
+			if (const auto instrumentTrack = dynamic_cast<InstrumentTrack*>(track))
+			{
+				polyphony += instrumentTrack->maxPolyphony();
+			}
+		}
+	}
+	// released notes keep their handles while fading out
+	NotePlayHandleManager::reserve(2 * polyphony);
 
 	Engine::audioEngine()->doneChangeInModel();
 
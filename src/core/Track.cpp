@@ -29,10 +29,13 @@
 
 #include "Track.h"
 
+#include <algorithm>
+
 #include <QDomElement>
 #include <QVariant>
 
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "ConfigManager.h"
 #include "Engine.h"
@@ -67,6 +70,7 @@ Track::Track( Type type, TrackContainer * tc ) :
 {	
 	m_trackContainer->addTrack( this );
 	m_height = -1;
+	connect(&m_mutedModel, &BoolModel::dataChanged, [] { AutomationTimeline::invalidate(); });
 }
 
 
@@ -341,6 +345,8 @@ void Track::loadSettings(const QDomElement& element)
 Clip * Track::addClip( Clip * clip )
 {
 	m_clips.push_back( clip );
+	invalidateClipIndex();
+	AutomationTimeline::invalidate();
 
 	emit clipAdded( clip );
 
@@ -360,6 +366,8 @@ void Track::removeClip( Clip * clip )
 	if( it != m_clips.end() )
 	{
 		m_clips.erase( it );
+		invalidateClipIndex();
+		AutomationTimeline::invalidate();
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -473,6 +481,51 @@ void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 
 
 
+auto Track::clipsAt(const TimePos& time, const TimePos& length) -> const clipVector&
+{
+	if (m_clipIndexOutdated.exchange(false, std::memory_order_acquire))
+	{
+		m_clipIndex = m_clips;
+		std::stable_sort(m_clipIndex.begin(), m_clipIndex.end(), Clip::comparePosition);
+		m_maxClipLength = 0;
+		for (const Clip* clip : m_clipIndex)
+		{
+			m_maxClipLength = std::max(m_maxClipLength, clip->length().getTicks());
+		}
+		m_clipCursor = 0;
+	}
+
+	const auto startOf = [this](std::size_t index) { return m_clipIndex[index]->startPosition().getTicks(); };
+	const auto byStart = [](const Clip* clip, tick_t start) { return clip->startPosition().getTicks() < start; };
+
+	const tick_t start = time.getTicks();
+	const tick_t end = start + length.getTicks();
+	// clips starting before this end before time
+	const tick_t first = start - m_maxClipLength;
+
+	if (m_clipCursor > 0 && startOf(m_clipCursor - 1) >= first)
+	{
+		// jumped back
+		m_clipCursor = std::lower_bound(m_clipIndex.begin(), m_clipIndex.begin() + m_clipCursor, first, byStart)
+			- m_clipIndex.begin();
+	}
+	else if (m_clipCursor < m_clipIndex.size() && startOf(m_clipCursor) < first)
+	{
+		m_clipCursor = std::lower_bound(m_clipIndex.begin() + m_clipCursor, m_clipIndex.end(), first, byStart)
+			- m_clipIndex.begin();
+	}
+
+	m_clipsAt.clear();
+	for (auto index = m_clipCursor; index < m_clipIndex.size() && startOf(index) <= end; ++index)
+	{
+		if (m_clipIndex[index]->endPosition() >= start) { m_clipsAt.push_back(m_clipIndex[index]); }
+	}
+	return m_clipsAt;
+}
+
+
+
+
 /*! \brief Swap the position of two clips.
  *
  *  First, we arrange to swap the positions of the two Clips in the
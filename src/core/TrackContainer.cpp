@@ -30,11 +30,13 @@
 #include <QWriteLocker>
 
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "embed.h"
 #include "TrackContainer.h"
 #include "PatternClip.h"
 #include "PatternStore.h"
 #include "PatternTrack.h"
+#include "SampleLoader.h"
 #include "Song.h"
 
 #include "GuiApplication.h"
@@ -135,8 +137,14 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 						node.firstChild().toElement().attribute( "name" );
 			if( pd != nullptr )
 			{
-				pd->setLabelText( tr("Loading Track %1 (%2/Total %3)").arg( trackName ).
-						  arg( pd->value() + 1 ).arg( Engine::getSong()->getLoadingTrackCount() ) );
+				auto label = tr("Loading Track %1 (%2/Total %3)").arg( trackName ).
+						  arg( pd->value() + 1 ).arg( Engine::getSong()->getLoadingTrackCount() );
+				// the samples are decoded in the background, see Song::loadProject
+				if (const auto samples = SampleLoader::fileCount(); samples > 0)
+				{
+					label += "\n" + tr("Decoded samples: %1/%2").arg(SampleLoader::decodedCount()).arg(samples);
+				}
+				pd->setLabelText(label);
 			}
 			Track::create( node.toElement(), this );
 		}
@@ -183,6 +191,7 @@ void TrackContainer::addTrack( Track * _track )
 		m_tracks.push_back( _track );
 		m_tracksMutex.unlock();
 		_track->unlock();
+		AutomationTimeline::invalidate();
 		emit trackAdded( _track );
 	}
 }
@@ -205,6 +214,7 @@ void TrackContainer::removeTrack( Track * _track )
 		}
 		m_tracks.erase(it);
 		lockTracksAccess.unlock();
+		AutomationTimeline::invalidate();
 
 		if( Engine::getSong() )
 		{
@@ -218,6 +228,7 @@ void TrackContainer::moveTrack(Track* track, int indexTo)
 {
 	m_tracks.erase(std::find(m_tracks.begin(), m_tracks.end(), track));
 	m_tracks.insert(m_tracks.begin() + indexTo, track);
+	AutomationTimeline::invalidate();
 
 	emit trackMoved();
 }
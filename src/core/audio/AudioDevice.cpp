@@ -26,12 +26,15 @@
 
 #include "AudioDevice.h"
 #include "AudioEngine.h"
+#include "MixHelpers.h"
+#include "SampleFrame.h"
 
 namespace lmms
 {
 
 AudioDevice::AudioDevice(const ch_cnt_t _channels, AudioEngine* _audioEngine)
 	: m_supportsCapture(false)
+	, m_readsRenderedBuffers(true)
 	, m_sampleRate(_audioEngine->outputSampleRate())
 	, m_channels(_channels)
 	, m_audioEngine(_audioEngine)
@@ -109,6 +112,11 @@ int AudioDevice::convertToS16(const SampleFrame* _ab,
 			}
 		}
 	}
+	else if (channels() == DEFAULT_CHANNELS)
+	{
+		// frames are laid out just like the interleaved output
+		MixHelpers::convertToS16(_output_buffer, _ab->data(), nullptr, _frames * DEFAULT_CHANNELS);
+	}
 	else
 	{
 		for( f_cnt_t frame = 0; frame < _frames; ++frame )
@@ -25,9 +25,15 @@
 
 #include <QMessageBox>
 
+#include <algorithm>
+#include <cassert>
+
 #include "AudioFileDevice.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
+#include "LocklessRingBuffer.h"
+#include "MixHelpers.h"
+#include "SampleFrame.h"
 
 namespace lmms
 {
@@ -44,6 +50,9 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 	setSampleRate( outputSettings.getSampleRate() );
 
+	// ProjectRenderer renders the periods and writes them
+	m_readsRenderedBuffers = false;
+
 	if( m_outputFile.open( QFile::WriteOnly | QFile::Truncate ) == false )
 	{
 		QString title, message;
@@ -75,12 +84,106 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 AudioFileDevice::~AudioFileDevice()
 {
+	assert(!m_encoderThread.joinable() && "finishEncoderThread() must be called before destruction");
 	m_outputFile.close();
 }
 
 
 
 
+void AudioFileDevice::startEncoderThread(f_cnt_t queueFrames)
+{
+	if (m_encoderThread.joinable()) { return; }
+
+	m_queue = std::make_unique<LocklessRingBuffer<SampleFrame>>(queueFrames);
+	m_queueReader = std::make_unique<LocklessRingBufferReader<SampleFrame>>(*m_queue);
+	m_encoderQuit = false;
+	m_encoderThread = std::thread{[this] { encode(); }};
+}
+
+
+
+
+void AudioFileDevice::queueBuffer(const SampleFrame* buf, f_cnt_t frames)
+{
+	if (!m_encoderThread.joinable())
+	{
+		writeBuffer(buf, frames);
+		return;
+	}
+
+	while (frames > 0)
+	{
+		const auto reads = m_queueReads.load(std::memory_order_acquire);
+		const auto written = m_queue->write(buf, frames);
+		if (written == 0)
+		{
+			// the encoder fell behind, wait until it made some room
+			m_queueReads.wait(reads, std::memory_order_acquire);
+			continue;
+		}
+
+		buf += written;
+		frames -= written;
+		m_queueWrites.fetch_add(1, std::memory_order_release);
+		m_queueWrites.notify_one();
+	}
+}
+
+
+
+
+void AudioFileDevice::finishEncoderThread()
+{
+	if (!m_encoderThread.joinable()) { return; }
+
+	m_encoderQuit.store(true, std::memory_order_release);
+	m_queueWrites.fetch_add(1, std::memory_order_release);
+	m_queueWrites.notify_one();
+	m_encoderThread.join();
+
+	m_queueReader.reset();
+	m_queue.reset();
+}
+
+
+
+
+void AudioFileDevice::encode()
+{
+	// encode in chunks as large as the queue, the encoders handle them better than single periods
+	auto block = std::vector<SampleFrame>(m_queue->capacity());
+
+	const auto drain = [&] {
+		while (const auto frames = std::min(m_queueReader->read_space(), block.size()))
+		{
+			m_queueReader->read(frames).copy(block.data(), frames);
+			m_queueReads.fetch_add(1, std::memory_order_release);
+			m_queueReads.notify_one();
+
+			writeBuffer(block.data(), frames);
+		}
+	};
+
+	while (true)
+	{
+		// load before draining, so writes made meanwhile wake the wait below
+		const auto writes = m_queueWrites.load(std::memory_order_acquire);
+		drain();
+
+		if (m_encoderQuit.load(std::memory_order_acquire))
+		{
+			drain();
+			break;
+		}
+
+		m_queueWrites.wait(writes, std::memory_order_acquire);
+	}
+}
+
+
+
+
 int AudioFileDevice::writeData( const void* data, int len )
 {
 	if( m_outputFile.isOpen() )
@@ -91,4 +194,35 @@ int AudioFileDevice::writeData( const void* data, int len )
 	return -1;
 }
 
+
+
+
+std::span<const int_sample_t> AudioFileDevice::toS16(const SampleFrame* buf, f_cnt_t frames)
+{
+	const auto samples = static_cast<std::size_t>(frames) * DEFAULT_CHANNELS;
+	if (m_s16Buffer.size() < samples) { m_s16Buffer.resize(samples); }
+
+	const float* dither = nullptr;
+	if (m_outputSettings.getDither() == OutputSettings::Dither::Triangular)
+	{
+		if (m_ditherBuffer.size() < samples) { m_ditherBuffer.resize(samples); }
+
+		// sum of two uniform random values in [0, 1) minus 1 gives triangular noise in (-1, 1)
+		const auto random = [this] {
+			m_ditherState ^= m_ditherState << 13;
+			m_ditherState ^= m_ditherState >> 17;
+			m_ditherState ^= m_ditherState << 5;
+			return static_cast<float>(m_ditherState >> 8) * (1.0f / (1 << 24));
+		};
+		for (auto i = std::size_t{0}; i < samples; ++i)
+		{
+			m_ditherBuffer[i] = random() + random() - 1.0f;
+		}
+		dither = m_ditherBuffer.data();
+	}
+
+	MixHelpers::convertToS16(m_s16Buffer.data(), buf->data(), dither, samples);
+	return {m_s16Buffer.data(), samples};
+}
+
 } // namespace lmms
@@ -23,10 +23,11 @@
  */
 
 
+#include <algorithm>
 #include <cmath>
 
 #include "AudioFileFlac.h"
-#include "endian_handling.h"
+#include "SampleFrame.h"
 #include "AudioEngine.h"
 
 namespace lmms
@@ -94,24 +95,22 @@ void AudioFileFlac::writeBuffer(const SampleFrame* _ab, f_cnt_t const frames)
 
 	if (depth == OutputSettings::BitDepth::Depth24Bit || depth == OutputSettings::BitDepth::Depth32Bit) // Float encoding
 	{
-		auto buf = std::vector<sample_t>(frames * channels());
-		for(f_cnt_t frame = 0; frame < frames; ++frame)
+		const auto samples = static_cast<std::size_t>(frames) * DEFAULT_CHANNELS;
+		if (m_floatBuffer.size() < samples) { m_floatBuffer.resize(samples); }
+
+		const sample_t* src = _ab->data();
+		for (auto i = std::size_t{0}; i < samples; ++i)
 		{
-			for(ch_cnt_t channel=0; channel<channels(); ++channel)
-			{
-				// Clip the negative side to just above -1.0 in order to prevent it from changing sign
-				// Upstream issue: https://github.com/erikd/libsndfile/issues/309
-				// When this commit is reverted libsndfile-1.0.29 must be made a requirement for FLAC
-				buf[frame*channels() + channel] = std::max(clipvalue, _ab[frame][channel]);
-			}
+			// Clip the negative side to just above -1.0 in order to prevent it from changing sign
+			// Upstream issue: https://github.com/erikd/libsndfile/issues/309
+			// When this commit is reverted libsndfile-1.0.29 must be made a requirement for FLAC
+			m_floatBuffer[i] = std::max(clipvalue, src[i]);
 		}
-		sf_writef_float(m_sf, static_cast<float*>(buf.data()), frames);
+		sf_writef_float(m_sf, m_floatBuffer.data(), frames);
 	}
 	else // integer PCM encoding
 	{
-		auto buf = std::vector<int_sample_t>(frames * channels());
-		convertToS16(_ab, frames, buf.data(), !isLittleEndian());
-		sf_writef_short(m_sf, static_cast<short*>(buf.data()), frames);
+		sf_writef_short(m_sf, toS16(_ab, frames).data(), frames);
 	}
 
 }
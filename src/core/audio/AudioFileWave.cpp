@@ -24,7 +24,7 @@
  */
 
 #include "AudioFileWave.h"
-#include "endian_handling.h"
+#include "SampleFrame.h"
 #include "AudioEngine.h"
 
 
@@ -99,24 +99,12 @@ void AudioFileWave::writeBuffer(const SampleFrame* _ab, const f_cnt_t _frames)
 
 	if( bitDepth == OutputSettings::BitDepth::Depth32Bit || bitDepth == OutputSettings::BitDepth::Depth24Bit )
 	{
-		auto buf = new float[_frames * channels()];
-		for( f_cnt_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				buf[frame * channels() + chnl] = _ab[frame][chnl];
-			}
-		}
-		sf_writef_float( m_sf, buf, _frames );
-		delete[] buf;
+		// sample frames are interleaved already
+		sf_writef_float(m_sf, _ab->data(), _frames);
 	}
 	else
 	{
-		auto buf = new int_sample_t[_frames * channels()];
-		convertToS16(_ab, _frames, buf, !isLittleEndian());
-
-		sf_writef_short( m_sf, buf, _frames );
-		delete[] buf;
+		sf_writef_short(m_sf, toS16(_ab, _frames).data(), _frames);
 	}
 }
 
@@ -24,6 +24,7 @@
 
 #include <QFormLayout>
 #include <QLineEdit>
+#include <vector>
 
 #include "AudioPulseAudio.h"
 
@@ -33,6 +34,7 @@
 #include "LcdSpinBox.h"
 #include "AudioEngine.h"
 #include "Engine.h"
+#include "MicroTimer.h"
 
 namespace lmms
 {
@@ -202,9 +204,21 @@ void AudioPulseAudio::run()
 	}
 	else
 	{
+		// keep taking buffers in time like a real device would, the render-ahead
+		// thread may already be rendering them
+		const auto framesPerAudioBuffer = audioEngine()->framesPerAudioBuffer();
+		auto buf = std::vector<float>(framesPerAudioBuffer * channels());
+		MicroTimer timer;
 		while (AudioDevice::isRunning())
 		{
-			audioEngine()->renderNextPeriod();
+			timer.reset();
+			audioEngine()->renderNextBuffer({buf.data(), channels(), framesPerAudioBuffer});
+
+			const int microseconds = static_cast<int>(framesPerAudioBuffer * 1000000.0f / sampleRate() - timer.elapsed());
+			if (microseconds > 0)
+			{
+				usleep(microseconds);
+			}
 		}
 	}
 
@@ -214,6 +214,16 @@ bool Lv2ControlBase::hasNoteInput() const
 
 
 
+f_cnt_t Lv2ControlBase::latencyFrames() const
+{
+	auto latency = f_cnt_t{0};
+	for (const auto& c : m_procs) { latency = std::max(latency, c->latencyFrames()); }
+	return latency;
+}
+
+
+
+
 void Lv2ControlBase::handleMidiInputEvent(const MidiEvent &event,
 	const TimePos &time, f_cnt_t offset)
 {
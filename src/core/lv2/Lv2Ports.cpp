@@ -114,6 +114,7 @@ std::vector<PluginIssue> Meta::get(const LilvPlugin *plugin,
 	const std::string portName = stdStringFromPortName(plugin, lilvPort);
 
 	m_optional = hasProperty(LV2_CORE__connectionOptional);
+	m_reportsLatency = hasProperty(LV2_CORE__reportsLatency);
 
 	m_vis = hasProperty(LV2_CORE__toggled)
 		? Vis::Toggled
@@ -26,6 +26,7 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <algorithm>
 #include <cmath>
 #include <lv2/midi/midi.h>
 #include <lv2/atom/atom.h>
@@ -496,6 +497,14 @@ bool Lv2Proc::hasNoteInput() const
 
 
 
+f_cnt_t Lv2Proc::latencyFrames() const
+{
+	return m_latencyPort ? static_cast<f_cnt_t>(std::max(m_latencyPort->m_val, 0.f)) : 0;
+}
+
+
+
+
 void Lv2Proc::initMOptions()
 {
 	/*
@@ -650,6 +659,11 @@ void Lv2Proc::createPort(std::size_t portNum)
 				}
 
 			} // if m_flow == Input
+			else if (meta.m_reportsLatency)
+			{
+				ctrl->m_val = 0.f; // until the plugin runs
+				m_latencyPort = ctrl;
+			}
 			port = ctrl;
 			break;
 		}
@@ -54,6 +54,7 @@
 #endif
 
 #include <csignal>  // To register the signal handler
+#include <optional>
 
 #include "MainApplication.h"
 #include "ConfigManager.h"
@@ -187,6 +188,10 @@ void printHelp()
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
+		"      --blocksize <frames>       Number of frames rendered at once\n"
+		"          Range: 32 to 4096, default: 256.\n"
+		"          Larger blocks render faster, but make automation coarser.\n"
+		"      --dither                   Dither when rendering 16 bit output\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
 		"  -l, --loop                     Render as a loop\n"
@@ -202,10 +207,17 @@ void printHelp()
 		"          If not specified, render will overwrite the input file\n"
 		"          For \"rendertracks\", this might be required\n"
 		"  -p, --profile <out>            Dump profiling information to file <out>\n"
+		"          If <out> ends in .json, every job is timed and written\n"
+		"          as a Chrome trace (chrome://tracing or ui.perfetto.dev)\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
-		"          Possible values: 1, 2, 4, 8\n"
-		"          Default: 2\n\n",
+		"      --stems <source>           For \"rendertracks\", render all tracks in a single pass\n"
+		"          Possible values: tracks, mixer\n"
+		"            tracks: One file per track, without mixer effects\n"
+		"            mixer: One file per mixer channel\n"
+		"          The full mix is written as well.\n"
+		"  -t, --threads <threads>        Number of threads used for rendering\n"
+		"          Default: number of CPU cores\n\n",
 		LMMS_VERSION, LMMS_PROJECT_COPYRIGHT );
 }
 
@@ -371,6 +383,7 @@ int main( int argc, char * * argv )
 
 	OutputSettings os(44100, 160, OutputSettings::BitDepth::Depth16Bit, OutputSettings::StereoMode::JointStereo);
 	ProjectRenderer::ExportFileFormat eff = ProjectRenderer::ExportFileFormat::Wave;
+	std::optional<RenderManager::StemSource> stemSource;
 
 	// second of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -535,6 +548,29 @@ int main( int argc, char * * argv )
 				return usageError( QString( "Invalid output format %1" ).arg( argv[i] ) );
 			}
 		}
+		else if (arg == "--stems")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No stem source specified");
+			}
+
+			const auto source = QString(argv[i]);
+			if (source == "tracks")
+			{
+				stemSource = RenderManager::StemSource::Tracks;
+			}
+			else if (source == "mixer")
+			{
+				stemSource = RenderManager::StemSource::MixerChannels;
+			}
+			else
+			{
+				return usageError(QString("Invalid stem source %1").arg(argv[i]));
+			}
+		}
 		else if( arg == "--samplerate" || arg == "-s" )
 		{
 			++i;
@@ -555,6 +591,49 @@ int main( int argc, char * * argv )
 				return usageError( QString( "Invalid samplerate %1" ).arg( argv[i] ) );
 			}
 		}
+		else if( arg == "--threads" || arg == "-t" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No number of threads specified" );
+			}
+
+
+			int threads = QString( argv[i] ).toInt();
+			if( threads > 0 )
+			{
+				AudioEngine::setThreadCount( threads );
+			}
+			else
+			{
+				return usageError( QString( "Invalid number of threads %1" ).arg( argv[i] ) );
+			}
+		}
+		else if (arg == "--blocksize")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No block size specified");
+			}
+
+			const auto frames = QString(argv[i]).toInt();
+			if (frames >= static_cast<int>(MINIMUM_BUFFER_SIZE) && frames <= static_cast<int>(MAXIMUM_BUFFER_SIZE))
+			{
+				AudioEngine::setOfflinePeriodSize(frames);
+			}
+			else
+			{
+				return usageError(QString("Invalid block size %1").arg(argv[i]));
+			}
+		}
+		else if (arg == "--dither")
+		{
+			os.setDither(OutputSettings::Dither::Triangular);
+		}
 		else if( arg == "--bitrate" || arg == "-b" )
 		{
 			++i;
@@ -752,7 +831,11 @@ int main( int argc, char * * argv )
 		}
 
 		// start now!
-		if ( renderTracks )
+		if (renderTracks && stemSource)
+		{
+			r->renderStems(*stemSource);
+		}
+		else if ( renderTracks )
 		{
 			r->renderTracks();
 		}
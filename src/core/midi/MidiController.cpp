@@ -46,6 +46,15 @@ MidiController::MidiController( Model * _parent ) :
 
 
 
+MidiController::~MidiController()
+{
+	// queued events must not reach processInEvent() of a half destroyed controller
+	m_midiPort.unregister();
+}
+
+
+
+
 void MidiController::updateValueBuffer()
 {
 	if( m_previousValue != m_lastValue )
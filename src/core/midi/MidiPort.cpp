@@ -26,6 +26,8 @@
 #include <QDomElement>
 
 #include "MidiPort.h"
+#include "AudioEngine.h"
+#include "Engine.h"
 #include "MidiClient.h"
 #include "MidiDummy.h"
 #include "MidiEventProcessor.h"
@@ -97,6 +99,14 @@ MidiPort::MidiPort( const QString& name,
 
 
 MidiPort::~MidiPort()
+{
+	unregister();
+}
+
+
+
+
+void MidiPort::unregister()
 {
 	// unsubscribe ports
 	m_readableModel.setValue( false );
@@ -104,6 +114,8 @@ MidiPort::~MidiPort()
 
 	// and finally unregister ourself
 	m_midiClient->removePort( this );
+
+	if (auto audioEngine = Engine::audioEngine()) { audioEngine->dropMidiInput(this); }
 }
 
 
@@ -149,13 +161,21 @@ void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
 			}
 		}
 
-		m_midiEventProcessor->processInEvent( inEvent, time );
+		Engine::audioEngine()->queueMidiInput(this, inEvent, time);
 	}
 }
 
 
 
 
+void MidiPort::processQueuedInEvent(const MidiEvent& event, const TimePos& time, f_cnt_t offset)
+{
+	m_midiEventProcessor->processInEvent(event, time, offset);
+}
+
+
+
+
 void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time )
 {
 	// When output is enabled, route midi events if the selected channel matches
@@ -31,9 +31,11 @@
 #include <QScrollArea>
 #include <QVBoxLayout>
 
+#include "AudioEngine.h"
 #include "DeprecationHelper.h"
 #include "EffectSelectDialog.h"
 #include "EffectView.h"
+#include "Engine.h"
 #include "GroupBox.h"
 
 
@@ -146,7 +148,7 @@ void EffectRackView::deletePlugin( EffectView* view )
 	m_effectViews.erase( std::find( m_effectViews.begin(), m_effectViews.end(), view ) );
 	delete view;
 	fxChain()->removeEffect( e );
-	e->deleteLater();
+	Engine::audioEngine()->retire(e);
 	update();
 }
 
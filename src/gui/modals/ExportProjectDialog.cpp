@@ -65,8 +65,12 @@ ExportProjectDialog::ExportProjectDialog(const QString& path, Mode mode, QWidget
 	, m_stereoModeComboBox(new QComboBox())
 	, m_compressionLevelLabel(new QLabel(tr("Compression level:")))
 	, m_compressionLevelComboBox(new QComboBox())
+	, m_ditherLabel(new QLabel(tr("Dither:")))
+	, m_ditherComboBox(new QComboBox())
 	, m_fileFormatSettingsGroupBox(new QGroupBox(tr("File format settings")))
 	, m_fileFormatSettingsLayout(new QFormLayout(m_fileFormatSettingsGroupBox))
+	, m_stemModeLabel(new QLabel(tr("Render tracks:")))
+	, m_stemModeComboBox(new QComboBox())
 	, m_exportAsLoopBox(new QCheckBox(tr("Export as loop (remove extra bar)")))
 	, m_exportBetweenLoopMarkersBox(new QCheckBox(tr("Export between loop markers")))
 	, m_loopRepeatLabel(new QLabel(tr("Render looped section:")))
@@ -135,6 +139,22 @@ ExportProjectDialog::ExportProjectDialog(const QString& path, Mode mode, QWidget
 		}
 	}
 
+	for (auto i = 0; i < static_cast<int>(OutputSettings::Dither::Count); ++i)
+	{
+		switch (static_cast<OutputSettings::Dither>(i))
+		{
+		case OutputSettings::Dither::None:
+			m_ditherComboBox->addItem(tr("None"), i);
+			break;
+		case OutputSettings::Dither::Triangular:
+			m_ditherComboBox->addItem(tr("Triangular (16 bit only)"), i);
+			break;
+		default:
+			assert(false && "invalid or unsupported dither");
+			break;
+		}
+	}
+
 	for (auto i = 0; i <= maxCompressionLevel; ++i)
 	{
 		const auto compressionValue = static_cast<float>(i) / maxCompressionLevel;
@@ -152,6 +172,12 @@ ExportProjectDialog::ExportProjectDialog(const QString& path, Mode mode, QWidget
 		}
 	}
 
+	// Value is -1 for one render per track, otherwise the RenderManager::StemSource
+	m_stemModeComboBox->addItem(tr("One pass per track"), -1);
+	m_stemModeComboBox->addItem(
+		tr("Tracks in a single pass"), static_cast<int>(RenderManager::StemSource::Tracks));
+	m_stemModeComboBox->addItem(
+		tr("Mixer channels in a single pass"), static_cast<int>(RenderManager::StemSource::MixerChannels));
 
 	auto loopRepeatLayout = new QHBoxLayout{};
 	loopRepeatLayout->addWidget(m_loopRepeatLabel);
@@ -162,6 +188,13 @@ ExportProjectDialog::ExportProjectDialog(const QString& path, Mode mode, QWidget
 	exportSettingsLayout->addWidget(m_exportAsLoopBox);
 	exportSettingsLayout->addWidget(m_exportBetweenLoopMarkersBox);
 	exportSettingsLayout->addLayout(loopRepeatLayout);
+	if (m_mode == Mode::ExportTracks)
+	{
+		auto stemModeLayout = new QHBoxLayout{};
+		stemModeLayout->addWidget(m_stemModeLabel);
+		stemModeLayout->addWidget(m_stemModeComboBox);
+		exportSettingsLayout->addLayout(stemModeLayout);
+	}
 
 	m_fileFormatSettingsLayout->addRow(m_fileFormatLabel, m_fileFormatComboBox);
 
@@ -223,10 +256,12 @@ void ExportProjectDialog::onFileFormatChanged(int index)
 	case ProjectRenderer::ExportFileFormat::Wave:
 		m_fileFormatSettingsLayout->addRow(m_sampleRateLabel, m_sampleRateComboBox);
 		m_fileFormatSettingsLayout->addRow(m_bitDepthLabel, m_bitDepthComboBox);
+		m_fileFormatSettingsLayout->addRow(m_ditherLabel, m_ditherComboBox);
 		break;
 	case ProjectRenderer::ExportFileFormat::Flac:
 		m_fileFormatSettingsLayout->addRow(m_sampleRateLabel, m_sampleRateComboBox);
 		m_fileFormatSettingsLayout->addRow(m_bitDepthLabel, m_bitDepthComboBox);
+		m_fileFormatSettingsLayout->addRow(m_ditherLabel, m_ditherComboBox);
 		m_fileFormatSettingsLayout->addRow(m_compressionLevelLabel, m_compressionLevelComboBox);
 		break;
 	case ProjectRenderer::ExportFileFormat::Ogg:
@@ -251,6 +286,7 @@ void ExportProjectDialog::onStartButtonClicked()
 
 	const auto compressionLevel = m_compressionLevelComboBox->currentData().toDouble();
 	outputSettings.setCompressionLevel(compressionLevel);
+	outputSettings.setDither(static_cast<OutputSettings::Dither>(m_ditherComboBox->currentData().toInt()));
 
 	const auto format = static_cast<ProjectRenderer::ExportFileFormat>(m_fileFormatComboBox->currentData().toInt());
 	m_renderManager = std::make_unique<RenderManager>(outputSettings, format, m_path);
@@ -270,7 +306,14 @@ void ExportProjectDialog::onStartButtonClicked()
 		m_renderManager->renderProject();
 		break;
 	case Mode::ExportTracks:
-		m_renderManager->renderTracks();
+		if (const auto stemMode = m_stemModeComboBox->currentData().toInt(); stemMode >= 0)
+		{
+			m_renderManager->renderStems(static_cast<RenderManager::StemSource>(stemMode));
+		}
+		else
+		{
+			m_renderManager->renderTracks();
+		}
 		break;
 	}
 }
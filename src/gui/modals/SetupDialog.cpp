@@ -31,6 +31,7 @@
 #include <QLayout>
 #include <QLineEdit>
 #include <QScrollArea>
+#include <QSpinBox>
 
 #include "AudioEngine.h"
 #include "embed.h"
@@ -39,6 +40,8 @@
 #include "MainWindow.h"
 #include "MidiSetupWidget.h"
 #include "ProjectJournal.h"
+#include "SampleBuffer.h"
+#include "SampleCache.h"
 #include "SetupDialog.h"
 #include "TabBar.h"
 #include "TabButton.h"
@@ -142,14 +145,25 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 			"ui", "vstalwaysontop").toInt()),
 	m_disableAutoQuit(ConfigManager::inst()->value(
 			"ui", "disableautoquit", "1").toInt()),
+	m_sampleStreamingThreshold(ConfigManager::inst()->value(
+			"app", "samplestreamingthreshold",
+			QString::number(SampleBuffer::DefaultStreamingThreshold)).toInt()),
+	m_sampleCache(ConfigManager::inst()->value(
+			"app", "samplecache", "1").toInt()),
 	m_NaNHandler(ConfigManager::inst()->value(
 			"app", "nanhandler", "1").toInt()),
 	m_bufferSize(ConfigManager::inst()->value(
 			"audioengine", "framesperaudiobuffer").toInt()),
 	m_sampleRate(ConfigManager::inst()->value(
 			"audioengine", "samplerate").toInt()),
+	m_renderAheadPeriods(ConfigManager::inst()->value(
+			"audioengine", "renderahead", "0").toInt()),
+	m_profileJobs(ConfigManager::inst()->value(
+			"audioengine", "profilejobs", "0").toInt() != 0),
 	m_midiAutoQuantize(ConfigManager::inst()->value(
 			"midi", "autoquantize", "0").toInt() != 0),
+	m_measureMidiLatency(ConfigManager::inst()->value(
+			"midi", "measurelatency", "0").toInt() != 0),
 	m_workingDir(QDir::toNativeSeparators(ConfigManager::inst()->workingDir())),
 	m_vstDir(QDir::toNativeSeparators(ConfigManager::inst()->vstDir())),
 	m_ladspaDir(QDir::toNativeSeparators(ConfigManager::inst()->ladspaDir())),
@@ -477,10 +491,36 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 		m_disableAutoQuit, SLOT(toggleDisableAutoQuit(bool)), false);
 
 
+	// Samples group
+	auto samplesBox = new QGroupBox{tr("Samples"), performance_w};
+	samplesBox->setToolTip(tr("Keep the decoded audio of long samples in a temporary file and read it "
+		"from disk while playing, instead of keeping all of it in memory."));
+	auto samplesLayout = new QVBoxLayout{samplesBox};
+	samplesLayout->addWidget(new QLabel{tr("Stream samples from disk which decode to more than:"), samplesBox});
+
+	auto streamingThresholdSpinBox = new QSpinBox{samplesBox};
+	streamingThresholdSpinBox->setRange(0, 1024 * 1024);
+	streamingThresholdSpinBox->setSingleStep(64);
+	streamingThresholdSpinBox->setSuffix(tr(" MiB"));
+	streamingThresholdSpinBox->setSpecialValueText(tr("Never"));
+	streamingThresholdSpinBox->setValue(m_sampleStreamingThreshold);
+	connect(streamingThresholdSpinBox, qOverload<int>(&QSpinBox::valueChanged),
+		this, [this](int threshold) { m_sampleStreamingThreshold = threshold; });
+	samplesLayout->addWidget(streamingThresholdSpinBox);
+
+	auto sampleCacheCheckBox = new QCheckBox{tr("Keep decoded compressed samples on disk"), samplesBox};
+	sampleCacheCheckBox->setToolTip(tr("Saves decoding FLAC, OGG and MP3 files again the next time "
+		"they are loaded, using up to %1 MiB in %2.").arg(SampleCache::sizeLimit()).arg(SampleCache::directory()));
+	sampleCacheCheckBox->setChecked(m_sampleCache);
+	connect(sampleCacheCheckBox, &QCheckBox::toggled, this, [this](bool enabled) { m_sampleCache = enabled; });
+	samplesLayout->addWidget(sampleCacheCheckBox);
+
+
 	// Performance layout ordering.
 	performance_layout->addWidget(autoSaveBox);
 	performance_layout->addWidget(uiFxBox);
 	performance_layout->addWidget(pluginsBox);
+	performance_layout->addWidget(samplesBox);
 	performance_layout->addStretch();
 
 
@@ -660,12 +700,58 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 
 	setBufferSize(m_bufferSizeSlider->value());
 
+	// Render ahead group
+	auto renderAheadBox = new QGroupBox{tr("Render ahead"), audio_w};
+	renderAheadBox->setToolTip(tr("Render audio in a separate thread, up to this many periods ahead of "
+		"the audio interface. This avoids dropouts caused by short load peaks at the cost of latency."));
+
+	m_renderAheadSlider = new QSlider{Qt::Horizontal};
+	m_renderAheadSlider->setRange(0, AudioEngine::MaxRenderAheadPeriods);
+	m_renderAheadSlider->setTickPosition(QSlider::TicksBelow);
+
+	auto renderAheadLabel = new QLabel{renderAheadBox};
+	auto renderAheadLayout = new QVBoxLayout{renderAheadBox};
+	renderAheadLayout->addWidget(m_renderAheadSlider);
+	renderAheadLayout->addWidget(renderAheadLabel);
+
+	auto setRenderAhead = [this, renderAheadLabel](int periods)
+	{
+		m_renderAheadPeriods = std::clamp(periods, 0, AudioEngine::MaxRenderAheadPeriods);
+		m_renderAheadSlider->setValue(m_renderAheadPeriods);
+		if (m_renderAheadPeriods == 0)
+		{
+			renderAheadLabel->setText(tr("Disabled"));
+			return;
+		}
+		const auto frames = m_renderAheadPeriods * std::min<int>(m_bufferSize, DEFAULT_BUFFER_SIZE);
+		renderAheadLabel->setText(tr("Periods: %1\nAdditional latency: %2 ms").arg(m_renderAheadPeriods).arg(
+			1000.0f * frames / Engine::audioEngine()->outputSampleRate(), 0, 'f', 1));
+	};
+
+	setRenderAhead(m_renderAheadPeriods);
+
+	connect(m_renderAheadSlider, &QSlider::valueChanged, this, &SetupDialog::showRestartWarning);
+	connect(m_renderAheadSlider, &QSlider::valueChanged, this, setRenderAhead);
+
+
+	// Profiling group
+	auto profilingBox = new QGroupBox{tr("Profiling"), audio_w};
+	auto profilingLayout = new QVBoxLayout{profilingBox};
+	{
+		auto box = addCheckBox(tr("Time individual jobs"), profilingBox, profilingLayout,
+			m_profileJobs, SLOT(toggleJobProfiling(bool)), false);
+		box->setToolTip(tr("If enabled, the tooltip of the CPU load indicator shows which instruments, effects "
+			"and mixer channels take the most time. Adds a little overhead to every job."));
+	}
+
 
 	// Audio layout ordering.
 	audio_layout->addWidget(audioInterfaceBox);
 	audio_layout->addWidget(as_w);
 	audio_layout->addWidget(sampleRateBox);
 	audio_layout->addWidget(bufferSizeBox);
+	audio_layout->addWidget(renderAheadBox);
+	audio_layout->addWidget(profilingBox);
 	audio_layout->addStretch();
 
 
@@ -784,6 +870,13 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 								false);
 		box->setToolTip(tr("If enabled, notes will be automatically quantized when recording them from a MIDI controller. If disabled, they are always recorded at the highest possible resolution."));
 	}
+	{
+		auto *box = addCheckBox(tr("Measure latency of MIDI input"),
+								midiRecordingTab, midiRecordingLayout,
+								m_measureMidiLatency, SLOT(toggleMidiLatencyMeasurement(bool)),
+								false);
+		box->setToolTip(tr("If enabled, the tooltip of the CPU load indicator shows how long notes played on a MIDI controller take until they start."));
+	}
 
 	// MIDI layout ordering.
 	midi_layout->addWidget(midiInterfaceBox);
@@ -1025,6 +1118,10 @@ void SetupDialog::accept()
 					QString::number(m_vstAlwaysOnTop));
 	ConfigManager::inst()->setValue("ui", "disableautoquit",
 					QString::number(m_disableAutoQuit));
+	ConfigManager::inst()->setValue("app", "samplestreamingthreshold",
+					QString::number(m_sampleStreamingThreshold));
+	ConfigManager::inst()->setValue("app", "samplecache",
+					QString::number(m_sampleCache));
 	ConfigManager::inst()->setValue("audioengine", "audiodev",
 					m_audioIfaceNames[m_audioInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("app", "nanhandler",
@@ -1033,11 +1130,23 @@ void SetupDialog::accept()
 					QString::number(m_sampleRate));
 	ConfigManager::inst()->setValue("audioengine", "framesperaudiobuffer",
 					QString::number(m_bufferSize));
+	ConfigManager::inst()->setValue("audioengine", "renderahead",
+					QString::number(m_renderAheadPeriods));
+	ConfigManager::inst()->setValue("audioengine", "profilejobs", QString::number(m_profileJobs));
+	if (m_profileJobs != Engine::audioEngine()->profiler().jobProfiling())
+	{
+		Engine::audioEngine()->profiler().setJobProfiling(m_profileJobs);
+	}
 	ConfigManager::inst()->setValue("audioengine", "mididev",
 					m_midiIfaceNames[m_midiInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("midi", "midiautoassign",
 					m_assignableMidiDevices->currentText());
 	ConfigManager::inst()->setValue("midi", "autoquantize", QString::number(m_midiAutoQuantize));
+	ConfigManager::inst()->setValue("midi", "measurelatency", QString::number(m_measureMidiLatency));
+	if (m_measureMidiLatency != Engine::audioEngine()->profiler().midiLatencyMeasurement())
+	{
+		Engine::audioEngine()->profiler().setMidiLatencyMeasurement(m_measureMidiLatency);
+	}
 
 
 	ConfigManager::inst()->setWorkingDir(QDir::fromNativeSeparators(m_workingDir));
@@ -1306,6 +1415,12 @@ void SetupDialog::resetBufferSize()
 }
 
 
+void SetupDialog::toggleJobProfiling(bool enabled)
+{
+	m_profileJobs = enabled;
+}
+
+
 // MIDI settings slots.
 
 void SetupDialog::midiInterfaceChanged(const QString & iface)
@@ -1324,6 +1439,11 @@ void SetupDialog::toggleMidiAutoQuantization(bool enabled)
 	m_midiAutoQuantize = enabled;
 }
 
+void SetupDialog::toggleMidiLatencyMeasurement(bool enabled)
+{
+	m_measureMidiLatency = enabled;
+}
+
 
 // Paths settings slots.
 
@@ -31,6 +31,8 @@
 #include "CPULoadWidget.h"
 #include "embed.h"
 #include "Engine.h"
+#include "NotePlayHandle.h"
+#include "SampleBuffer.h"
 
 
 namespace lmms::gui
@@ -98,12 +100,56 @@ void CPULoadWidget::updateCpuLoad()
 	if (new_load != m_currentLoad)
 	{
 		auto engine = Engine::audioEngine();
+		const auto buffers = engine->profiler().bufferStatistics();
+		auto renderAheadInfo = QString{};
+		if (engine->renderAheadPeriods() > 0)
+		{
+			const auto renderAhead = engine->renderAheadStatistics();
+			renderAheadInfo = "\n" + tr("Render ahead: %1 underruns, %2 late periods")
+				.arg(renderAhead.underruns).arg(renderAhead.xruns);
+		}
+		auto midiLatencyInfo = QString{};
+		if (engine->profiler().midiLatencyMeasurement())
+		{
+			const auto latency = engine->profiler().midiLatencyStatistics();
+			midiLatencyInfo = "\n" + tr("MIDI input latency: %1 / %2 / %3 ms (min / avg / max of %4 notes)")
+				.arg(latency.minLatency, 0, 'f', 1).arg(latency.averageLatency, 0, 'f', 1)
+				.arg(latency.maxLatency, 0, 'f', 1).arg(latency.notes);
+		}
+		if (const auto dropped = engine->droppedMidiInput(); dropped > 0)
+		{
+			midiLatencyInfo += "\n" + tr("MIDI input events dropped: %1").arg(dropped);
+		}
+		auto jobsInfo = QString{};
+		if (engine->profiler().jobProfiling())
+		{
+			constexpr auto MaxJobs = std::size_t{5};
+			const auto jobs = engine->profiler().jobStatistics();
+			jobsInfo = "\n" + tr("Most expensive jobs (avg / 99th percentile):");
+			for (auto i = std::size_t{0}; i < std::min(jobs.size(), MaxJobs); ++i)
+			{
+				jobsInfo += "\n" + tr(" - %1: %2 / %3 µs").arg(jobs[i].name)
+					.arg(jobs[i].averageTime, 0, 'f', 0).arg(jobs[i].p99Time, 0, 'f', 0);
+			}
+		}
+		auto sharedSamplesInfo = QString{};
+		if (const auto sharedBytes = SampleBuffer::sharedBytes(); sharedBytes > 0)
+		{
+			sharedSamplesInfo = "\n" + tr("Memory saved by sharing samples: %1 MiB")
+				.arg(sharedBytes / (1024. * 1024.), 0, 'f', 1);
+		}
 		setToolTip(
 			tr("DSP total: %1%").arg(new_load) + "\n"
 			+ tr(" - Notes and setup: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::NoteSetup)) + "\n"
-			+ tr(" - Instruments: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Instruments)) + "\n"
-			+ tr(" - Effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Effects)) + "\n"
-			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing))
+			+ tr(" - Instruments and effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Processing)) + "\n"
+			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing)) + "\n"
+			+ tr("Buffers: %1 of %2 in use (peak %3, %4 misses)")
+				.arg(buffers.inUse).arg(buffers.capacity).arg(buffers.highWaterMark).arg(buffers.misses) + "\n"
+			+ tr("Notes allocated outside the pool: %1").arg(NotePlayHandleManager::misses())
+			+ renderAheadInfo
+			+ midiLatencyInfo
+			+ jobsInfo
+			+ sharedSamplesInfo
 		);
 		m_currentLoad = new_load;
 		m_changed = true;
@@ -23,6 +23,10 @@
  */
 #include "InstrumentTrack.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "AudioEngine.h"
 #include "AutomationClip.h"
 #include "ConfigManager.h"
@@ -115,6 +119,43 @@ InstrumentTrack::InstrumentTrack(TrackContainer* tc) :
 
 
 
+int InstrumentTrack::maxPolyphony() const
+{
+	// sweep over note starts and ends of each clip
+	auto maxNotes = 0;
+	auto events = std::vector<std::pair<tick_t, int>>{};
+	for (const auto clip : getClips())
+	{
+		events.clear();
+		for (const auto note : static_cast<const MidiClip*>(clip)->notes())
+		{
+			// step notes have no length, but still play for a moment
+			events.emplace_back(note->pos(), 1);
+			events.emplace_back(note->pos() + std::max<tick_t>(note->length(), 1), -1);
+		}
+		// ends sort before starts at the same position
+		std::sort(events.begin(), events.end());
+
+		auto notes = 0;
+		for (const auto& event : events)
+		{
+			notes += event.second;
+			maxNotes = std::max(maxNotes, notes);
+		}
+	}
+
+	auto notesPerNote = m_noteStacking.notesPerNote();
+	if (isArpeggioEnabled())
+	{
+		// the base note plus overlapping arpeggio notes, each stacked
+		notesPerNote = 1 + 2 * notesPerNote;
+	}
+	return maxNotes * notesPerNote;
+}
+
+
+
+
 bool InstrumentTrack::keyRangeImport() const
 {
 	return m_microtuner.enabled() && m_microtuner.keyRangeImport();
@@ -204,6 +245,9 @@ float InstrumentTrack::baseFreq() const
 
 InstrumentTrack::~InstrumentTrack()
 {
+	// queued events must not reach processInEvent() while the track is destroyed
+	m_midiPort.unregister();
+
 	// De-assign midi device
 	if (m_hasAutoMidiDev)
 	{
@@ -703,22 +747,20 @@ bool InstrumentTrack::play( const TimePos & _start, const f_cnt_t _frames,
 	}
 	const float frames_per_tick = Engine::framesPerTick();
 
-	clipVector clips;
+	clipVector patternClip;
 	class PatternTrack * pattern_track = nullptr;
 	if( _clip_num >= 0 )
 	{
 		Clip * clip = getClip( _clip_num );
-		clips.push_back( clip );
+		patternClip.push_back( clip );
 		if (trackContainer() == Engine::patternStore())
 		{
 			pattern_track = PatternTrack::findPatternTrack(_clip_num);
 		}
 	}
-	else
-	{
-		getClipsInRange( clips, _start, _start + static_cast<int>(
-					_frames / frames_per_tick ) );
-	}
+	const clipVector& clips = _clip_num >= 0
+		? patternClip
+		: clipsAt(_start, static_cast<int>(_frames / frames_per_tick));
 
 	// Handle automation: detuning
 	for (const auto& processHandle : m_processHandles)
@@ -750,36 +792,11 @@ bool InstrumentTrack::play( const TimePos & _start, const f_cnt_t _frames,
 			cur_start -= c->startPosition() + c->startTimeOffset();
 		}
 
-		// get all notes from the given clip...
-		const NoteVector & notes = c->notes();
-		// ...and set our index to zero
-		auto nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-		if( cur_start > 0 )
-		{
-			// skip notes which end before start-bar
-			while( nit != notes.end() && ( *nit )->endPos() < cur_start )
-			{
-				++nit;
-			}
-		}
-
-		while (nit != notes.end() && (*nit)->pos() < c->length() - c->startTimeOffset())
+		const auto clipEnd = c->length() - c->startTimeOffset();
+		const auto playNote = [&](const Note* currentNote)
 		{
-			const auto currentNote = *nit;
-			// Skip any notes note at the current time pos or not overlapping with the start.
-			if (!(currentNote->pos() == cur_start
-				|| (cur_start == -c->startTimeOffset() && (*nit)->pos() < cur_start && (*nit)->endPos() > cur_start)))
-			{
-				++nit;
-				continue;
-			}
-
 			// Calculate the overlap of the note over the clip end.
-			const auto noteOverlap = std::max(0, currentNote->endPos() - (c->length() - c->startTimeOffset()));
+			const auto noteOverlap = std::max(0, currentNote->endPos() - clipEnd);
 			// If the note is a Step Note, frames will be 0 so the NotePlayHandle
 			// plays for the whole length of the sample
 			const auto noteFrames = currentNote->type() == Note::Type::Step
@@ -798,7 +815,22 @@ bool InstrumentTrack::play( const TimePos & _start, const f_cnt_t _frames,
 
 			Engine::audioEngine()->addPlayHandle( notePlayHandle );
 			played_a_note = true;
-			++nit;
+		};
+
+		// notes are looked up from a cursor kept by the clip, so
+		// playing on only looks at the notes starting right now
+		if (cur_start >= clipEnd) { continue; }
+		if (cur_start == -c->startTimeOffset())
+		{
+			// starting with the clip, so also play notes which began before its visible part
+			for (const Note* currentNote : c->notesOverlapping(cur_start))
+			{
+				playNote(currentNote);
+			}
+		}
+		for (const Note* currentNote : c->notesStartingAt(cur_start))
+		{
+			playNote(currentNote);
 		}
 	}
 	unlock();
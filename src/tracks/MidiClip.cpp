@@ -114,6 +114,8 @@ void MidiClip::init()
 {
 	connect( Engine::getSong(), SIGNAL(timeSignatureChanged(int,int)),
 				this, SLOT(changeTimeSignature()));
+	// notes are moved and resized without telling the clip, but the editors emit this afterwards
+	connect(this, &MidiClip::dataChanged, [this] { invalidateSchedule(); });
 	saveJournallingState( false );
 
 	updateLength();
@@ -186,6 +188,7 @@ Note * MidiClip::addNote( const Note & _new_note, const bool _quant_pos )
 
 	instrumentTrack()->lock();
 	m_notes.insert(std::upper_bound(m_notes.begin(), m_notes.end(), new_note, Note::lessThan), new_note);
+	invalidateSchedule();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -204,6 +207,7 @@ NoteVector::const_iterator MidiClip::removeNote(NoteVector::const_iterator it)
 	instrumentTrack()->lock();
 	delete *it;
 	auto new_it = m_notes.erase(it);
+	invalidateSchedule();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -223,6 +227,7 @@ NoteVector::const_iterator MidiClip::removeNote(Note* note)
 		delete *it;
 		it = m_notes.erase(it);
 	}
+	invalidateSchedule();
 
 	instrumentTrack()->unlock();
 
@@ -254,6 +259,7 @@ void MidiClip::rearrangeAllNotes()
 {
 	// sort notes by start time
 	std::sort(m_notes.begin(), m_notes.end(), Note::lessThan);
+	invalidateSchedule();
 }
 
 
@@ -266,6 +272,7 @@ void MidiClip::clearNotes()
 		delete note;
 	}
 	m_notes.clear();
+	invalidateSchedule();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -276,6 +283,74 @@ void MidiClip::clearNotes()
 
 
 
+auto MidiClip::notesStartingAt(const TimePos& time) -> std::span<Note* const>
+{
+	updateSchedule();
+
+	const auto& positions = m_schedule.positions;
+	auto& cursor = m_schedule.cursor;
+	const tick_t ticks = time.getTicks();
+
+	if (cursor > 0 && positions[cursor - 1] >= ticks)
+	{
+		// jumped back, e.g. when looping
+		cursor = std::lower_bound(positions.begin(), positions.begin() + cursor, ticks) - positions.begin();
+	}
+	else if (cursor < positions.size() && positions[cursor] < ticks)
+	{
+		cursor = std::lower_bound(positions.begin() + cursor, positions.end(), ticks) - positions.begin();
+	}
+
+	auto last = cursor;
+	while (last < positions.size() && positions[last] == ticks) { ++last; }
+	return {m_schedule.notes.data() + cursor, last - cursor};
+}
+
+
+
+
+auto MidiClip::notesOverlapping(const TimePos& time) -> const NoteVector&
+{
+	updateSchedule();
+
+	const tick_t ticks = time.getTicks();
+	const auto& positions = m_schedule.positions;
+	const auto& ends = m_schedule.ends;
+	const auto count = std::lower_bound(positions.begin(), positions.end(), ticks) - positions.begin();
+
+	m_schedule.overlapping.clear();
+	for (auto index = std::size_t{0}; index < static_cast<std::size_t>(count); ++index)
+	{
+		if (ends[index] > ticks) { m_schedule.overlapping.push_back(m_schedule.notes[index]); }
+	}
+	return m_schedule.overlapping;
+}
+
+
+
+
+void MidiClip::updateSchedule()
+{
+	if (!m_scheduleOutdated.exchange(false, std::memory_order_acquire)) { return; }
+
+	auto& schedule = m_schedule;
+	schedule.notes = m_notes;
+	// m_notes is only sorted again after editing
+	std::stable_sort(schedule.notes.begin(), schedule.notes.end(), Note::lessThan);
+
+	schedule.positions.resize(schedule.notes.size());
+	schedule.ends.resize(schedule.notes.size());
+	for (auto index = std::size_t{0}; index < schedule.notes.size(); ++index)
+	{
+		schedule.positions[index] = schedule.notes[index]->pos().getTicks();
+		schedule.ends[index] = schedule.notes[index]->endPos().getTicks();
+	}
+	schedule.cursor = 0;
+}
+
+
+
+
 Note * MidiClip::addStepNote( int step )
 {
 	Note stepNote = Note(TimePos(DefaultTicksPerBar / 16), TimePos::stepPosition(step));
@@ -507,6 +582,7 @@ void MidiClip::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
         }
+	invalidateSchedule();
 
 	m_steps = _this.attribute( "steps" ).toInt();
 	if( m_steps == 0 )
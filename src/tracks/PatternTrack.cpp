@@ -99,8 +99,7 @@ bool PatternTrack::play( const TimePos & _start, const f_cnt_t _frames,
 		return Engine::patternStore()->play(_start, _frames, _offset, s_infoMap[this]);
 	}
 
-	clipVector clips;
-	getClipsInRange( clips, _start, _start + static_cast<int>( _frames / Engine::framesPerTick() ) );
+	const clipVector& clips = clipsAt(_start, static_cast<int>(_frames / Engine::framesPerTick()));
 
 	if( clips.size() == 0 )
 	{
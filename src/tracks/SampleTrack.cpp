@@ -25,6 +25,8 @@
  
 #include "SampleTrack.h"
 
+#include <algorithm>
+
 #include <QDomElement>
 
 #include "EffectChain.h"
@@ -98,12 +100,23 @@ bool SampleTrack::play( const TimePos & _start, const f_cnt_t _frames,
 	else
 	{
 		bool nowPlaying = false;
-		for( int i = 0; i < numOfClips(); ++i )
+		const auto isPlayingAt = [&_start](const SampleClip* sClip)
+		{
+			return _start >= sClip->startPosition() && _start < sClip->endPosition();
+		};
+
+		if (m_resetPlayingClips.exchange(false)) { m_playingClips.clear(); }
+		for (const auto& sClip : m_playingClips)
+		{
+			if (sClip && !isPlayingAt(sClip)) { sClip->setIsPlaying(false); }
+		}
+		std::erase_if(m_playingClips, [](const auto& sClip) { return !sClip || !sClip->isPlaying(); });
+
+		for (Clip* clip : clipsAt(_start, 0))
 		{
-			Clip * clip = getClip( i );
 			auto sClip = dynamic_cast<SampleClip*>(clip);
 
-			if( _start >= sClip->startPosition() && _start < sClip->endPosition() )
+			if (isPlayingAt(sClip))
 			{
 				if( sClip->isPlaying() == false && _start >= (sClip->startPosition() + sClip->startTimeOffset()) )
 				{
@@ -124,14 +137,35 @@ bool SampleTrack::play( const TimePos & _start, const f_cnt_t _frames,
 						nowPlaying = true;
 					}
 				}
-			}
-			else
-			{
-				sClip->setIsPlaying( false );
+				if (sClip->isPlaying()
+					&& std::find(m_playingClips.begin(), m_playingClips.end(), sClip) == m_playingClips.end())
+				{
+					m_playingClips.emplace_back(sClip);
+				}
 			}
 			nowPlaying = nowPlaying || sClip->isPlaying();
 		}
 		setPlaying(nowPlaying);
+
+		// have streamed samples read from disk before their clips start playing. Looks again once half of
+		// the window was played, so each clip is still asked for at least half a window ahead, or after a jump.
+		const auto prefetchTicks = static_cast<tick_t>(SampleStream::PrefetchSeconds
+			* Engine::audioEngine()->outputSampleRate() / Engine::framesPerTick());
+		if (_start < m_prefetchStart || _start >= m_nextPrefetch)
+		{
+			m_prefetchStart = _start;
+			m_nextPrefetch = _start + std::max<tick_t>(prefetchTicks / 2, 1);
+			for (Clip* clip : clipsAt(_start, prefetchTicks))
+			{
+				auto sClip = static_cast<SampleClip*>(clip);
+				const auto offset = std::max(sClip->startTimeOffset(), TimePos{0});
+				if (!sClip->isMuted() && !sClip->isPlaying() && sClip->startPosition() + offset > _start)
+				{
+					const auto framesPerTick = Engine::framesPerTick(sClip->sample().sampleRate());
+					sClip->sample().prefetchUpcoming(static_cast<int>(framesPerTick * (offset - sClip->startTimeOffset())));
+				}
+			}
+		}
 	}
 
 	for (const auto& clip : clips)
@@ -238,6 +272,8 @@ void SampleTrack::setPlayingClips( bool isPlaying )
 		auto sClip = dynamic_cast<SampleClip*>(clip);
 		sClip->setIsPlaying( isPlaying );
 	}
+	// may be called from any thread while play() walks the list
+	m_resetPlayingClips = true;
 }
 
 
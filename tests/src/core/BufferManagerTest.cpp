@@ -0,0 +1,132 @@
+/*
+ * BufferManagerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "BufferManager.h"
+#include "Hardware.h"
+#include "SampleFrame.h"
+
+#include <QObject>
+#include <QtTest>
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+using lmms::BufferManager;
+using lmms::SampleFrame;
+
+class BufferManagerTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	static constexpr auto Frames = lmms::f_cnt_t{256};
+
+	static void releaseAll(std::vector<SampleFrame*>& buffers)
+	{
+		for (auto buffer : buffers) { BufferManager::release(buffer); }
+		buffers.clear();
+	}
+
+private slots:
+	void initTestCase()
+	{
+		BufferManager::init(Frames);
+	}
+
+	//! Verifies acquired buffers are distinct, start on their own cache line and can hold a period
+	void Acquire_SeveralBuffers_AreDistinctAndAligned()
+	{
+		const auto inUse = BufferManager::statistics().inUse;
+
+		auto buffers = std::vector<SampleFrame*>{};
+		for (auto i = 0; i < 8; ++i)
+		{
+			auto buffer = BufferManager::acquire();
+			QVERIFY(buffer != nullptr);
+			QCOMPARE(reinterpret_cast<std::uintptr_t>(buffer) % lmms::hardware_destructive_interference_size,
+				std::uintptr_t{0});
+			std::fill_n(buffer, Frames, SampleFrame{static_cast<float>(i)});
+			buffers.push_back(buffer);
+		}
+
+		QCOMPARE(std::set(buffers.begin(), buffers.end()).size(), buffers.size());
+		for (auto i = 0; i < 8; ++i)
+		{
+			QCOMPARE(buffers[i][Frames - 1].left(), static_cast<float>(i));
+		}
+		QCOMPARE(BufferManager::statistics().inUse, inUse + 8);
+
+		releaseAll(buffers);
+		QCOMPARE(BufferManager::statistics().inUse, inUse);
+	}
+
+	//! Verifies a released buffer is handed out again
+	void Release_Buffer_IsReused()
+	{
+		const auto first = BufferManager::acquire();
+		BufferManager::release(first);
+
+		const auto second = BufferManager::acquire();
+		QCOMPARE(second, first);
+		BufferManager::release(second);
+	}
+
+	//! Verifies more buffers than the pool holds are still served, by growing the pool or from the heap
+	void Acquire_MoreThanCapacity_ServesAll()
+	{
+		const auto before = BufferManager::statistics();
+
+		auto buffers = std::vector<SampleFrame*>{};
+		for (auto i = std::size_t{0}; i < before.capacity + 16; ++i)
+		{
+			buffers.push_back(BufferManager::acquire());
+			QVERIFY(buffers.back() != nullptr);
+		}
+		QCOMPARE(std::set(buffers.begin(), buffers.end()).size(), buffers.size());
+
+		const auto after = BufferManager::statistics();
+		QVERIFY(after.capacity > before.capacity || after.misses > before.misses);
+		QVERIFY(after.highWaterMark >= before.inUse + buffers.size());
+
+		releaseAll(buffers);
+		QCOMPARE(BufferManager::statistics().inUse, before.inUse);
+	}
+
+	//! Verifies periods larger than the pool's buffers are allocated on the heap and counted as misses
+	void Acquire_LargerPeriod_AllocatesOnHeap()
+	{
+		const auto misses = BufferManager::statistics().misses;
+		BufferManager::init(Frames * 2);
+
+		const auto buffer = BufferManager::acquire();
+		QVERIFY(buffer != nullptr);
+		std::fill_n(buffer, Frames * 2, SampleFrame{});
+		QCOMPARE(BufferManager::statistics().misses, misses + 1);
+		BufferManager::release(buffer);
+
+		BufferManager::init(Frames);
+	}
+};
+
+QTEST_GUILESS_MAIN(BufferManagerTest)
+#include "BufferManagerTest.moc"
@@ -0,0 +1,142 @@
+/*
+ * LatencyCompensatorTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LatencyCompensator.h"
+
+#include <QObject>
+#include <QtTest>
+#include <vector>
+
+using lmms::f_cnt_t;
+using lmms::LatencyCompensator;
+using lmms::SampleFrame;
+
+class LatencyCompensatorTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	//! Frames counting up from 1, so each one can be told apart
+	static auto ramp(f_cnt_t frames) -> std::vector<SampleFrame>
+	{
+		auto result = std::vector<SampleFrame>{};
+		for (f_cnt_t f = 0; f < frames; ++f)
+		{
+			result.emplace_back(static_cast<float>(f + 1), -static_cast<float>(f + 1));
+		}
+		return result;
+	}
+
+private slots:
+	//! Verifies the signal comes out unchanged without a delay
+	void Process_NoDelay_PassesThrough()
+	{
+		auto compensator = LatencyCompensator{};
+		const auto in = ramp(8);
+		auto out = std::vector<SampleFrame>(8);
+
+		compensator.process(in.data(), out.data(), 8);
+
+		for (f_cnt_t f = 0; f < 8; ++f)
+		{
+			QCOMPARE(out[f].left(), in[f].left());
+		}
+		QVERIFY(!compensator.hasSignal());
+	}
+
+	//! Verifies the signal comes out the delay later, also across several calls and in place
+	void Process_Delay_ShiftsSignal()
+	{
+		auto compensator = LatencyCompensator{};
+		compensator.setDelay(3);
+		auto buffer = ramp(8);
+
+		compensator.process(buffer.data(), buffer.data(), 4);
+		compensator.process(buffer.data() + 4, buffer.data() + 4, 4);
+
+		for (f_cnt_t f = 0; f < 3; ++f)
+		{
+			QCOMPARE(buffer[f].left(), 0.f);
+		}
+		for (f_cnt_t f = 3; f < 8; ++f)
+		{
+			QCOMPARE(buffer[f].left(), static_cast<float>(f - 2));
+			QCOMPARE(buffer[f].right(), -static_cast<float>(f - 2));
+		}
+		QVERIFY(compensator.hasSignal());
+	}
+
+	//! Verifies the delayed signal still comes out when there is no more input
+	void Process_SilentInput_FlushesDelayedSignal()
+	{
+		auto compensator = LatencyCompensator{};
+		compensator.setDelay(4);
+		const auto in = ramp(4);
+		auto out = std::vector<SampleFrame>(4);
+
+		compensator.process(in.data(), out.data(), 4);
+		compensator.process(nullptr, out.data(), 2);
+		QCOMPARE(out[0].left(), 1.f);
+		QCOMPARE(out[1].left(), 2.f);
+		QVERIFY(compensator.hasSignal());
+
+		compensator.process(nullptr, out.data(), 2);
+		QCOMPARE(out[1].left(), 4.f);
+		QVERIFY(!compensator.hasSignal());
+	}
+
+	//! Verifies changing the delay drops the delayed signal and applies the new delay
+	void SetDelay_Changed_RestartsWithNewDelay()
+	{
+		auto compensator = LatencyCompensator{};
+		compensator.setDelay(2);
+		const auto in = ramp(4);
+		auto out = std::vector<SampleFrame>(4);
+		compensator.process(in.data(), out.data(), 4);
+
+		compensator.setDelay(5);
+		QCOMPARE(compensator.delay(), f_cnt_t{5});
+		QVERIFY(!compensator.hasSignal());
+
+		compensator.process(in.data(), out.data(), 4);
+		for (const auto& frame : out)
+		{
+			QCOMPARE(frame.left(), 0.f);
+		}
+
+		compensator.setDelay(1);
+		compensator.process(in.data(), out.data(), 4);
+		QCOMPARE(out[0].left(), 0.f);
+		QCOMPARE(out[1].left(), 1.f);
+	}
+
+	//! Verifies delays longer than the reserved buffer are limited to it
+	void SetDelay_TooLong_IsLimited()
+	{
+		auto compensator = LatencyCompensator{};
+		compensator.setDelay(LatencyCompensator::MaxDelay * 2);
+		QCOMPARE(compensator.delay(), LatencyCompensator::MaxDelay);
+	}
+};
+
+QTEST_GUILESS_MAIN(LatencyCompensatorTest)
+#include "LatencyCompensatorTest.moc"
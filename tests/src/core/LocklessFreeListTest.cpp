@@ -0,0 +1,137 @@
+/*
+ * LocklessFreeListTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LocklessFreeList.h"
+
+#include <QObject>
+#include <QtTest>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using lmms::LocalFreeListCache;
+using lmms::LocklessFreeList;
+
+class LocklessFreeListTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	//! A list holding the slots 0 to @p count - 1, pushed as one chain
+	static void fill(LocklessFreeList& list, std::uint32_t count)
+	{
+		for (auto index = std::uint32_t{0}; index + 1 < count; ++index)
+		{
+			list.link(index, index + 1);
+		}
+		list.pushChain(0, count - 1, count);
+	}
+
+private slots:
+	//! Verifies every slot is popped once and an exhausted list reports Empty
+	void Pop_AllSlots_ThenEmpty()
+	{
+		auto list = LocklessFreeList{4};
+		fill(list, 4);
+		QCOMPARE(list.size(), std::size_t{4});
+
+		for (auto index = std::uint32_t{0}; index < 4; ++index)
+		{
+			QCOMPARE(list.pop(), index);
+		}
+		QCOMPARE(list.pop(), LocklessFreeList::Empty);
+		QCOMPARE(list.size(), std::size_t{0});
+	}
+
+	//! Verifies a pushed slot is popped again first
+	void Push_AfterExhaustion_ReusesSlot()
+	{
+		auto list = LocklessFreeList{2};
+		fill(list, 2);
+		list.pop();
+		const auto slot = list.pop();
+		QCOMPARE(list.pop(), LocklessFreeList::Empty);
+
+		list.push(slot);
+		QCOMPARE(list.size(), std::size_t{1});
+		QCOMPARE(list.pop(), slot);
+		QCOMPARE(list.pop(), LocklessFreeList::Empty);
+	}
+
+	//! Verifies a thread's cache hands out its own slots first and returns them to the list when it overflows
+	void LocalCache_Overflow_FlushesToList()
+	{
+		auto list = LocklessFreeList{8};
+		auto cache = LocalFreeListCache<4>{};
+
+		for (auto index = std::uint32_t{0}; index < 4; ++index)
+		{
+			cache.push(list, index);
+		}
+		QCOMPARE(list.size(), std::size_t{0});
+
+		// full, so the older half goes to the list
+		cache.push(list, 4);
+		QCOMPARE(list.size(), std::size_t{2});
+
+		QCOMPARE(cache.pop(list), std::uint32_t{4});
+		QCOMPARE(cache.pop(list), std::uint32_t{3});
+		QCOMPARE(cache.pop(list), std::uint32_t{2});
+		QCOMPARE(cache.pop(list), std::uint32_t{0});
+		QCOMPARE(cache.pop(list), std::uint32_t{1});
+		QCOMPARE(cache.pop(list), LocklessFreeList::Empty);
+	}
+
+	//! Verifies no slot is handed out twice while several threads pop and push at once
+	void PopPush_Concurrently_NeverSharesSlot()
+	{
+		constexpr auto Slots = std::uint32_t{64};
+		constexpr auto Rounds = 100000;
+		auto list = LocklessFreeList{Slots};
+		fill(list, Slots);
+		auto owners = std::vector<std::atomic_int>(Slots);
+		auto shared = std::atomic_bool{false};
+
+		auto threads = std::vector<std::thread>{};
+		for (auto t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&] {
+				for (auto round = 0; round < Rounds; ++round)
+				{
+					const auto slot = list.pop();
+					if (slot == LocklessFreeList::Empty) { continue; }
+					if (owners[slot].fetch_add(1) != 0) { shared = true; }
+					owners[slot].fetch_sub(1);
+					list.push(slot);
+				}
+			});
+		}
+		for (auto& thread : threads) { thread.join(); }
+
+		QVERIFY(!shared);
+		QCOMPARE(list.size(), std::size_t{Slots});
+	}
+};
+
+QTEST_GUILESS_MAIN(LocklessFreeListTest)
+#include "LocklessFreeListTest.moc"
@@ -0,0 +1,108 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpers.h"
+
+#include <QObject>
+#include <QtTest>
+#include <cstdlib>
+#include <vector>
+
+using lmms::int_sample_t;
+using lmms::sample_t;
+
+class MixHelpersTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	//! Odd, so both the vectorized loop and the one for the remaining samples run
+	static constexpr auto Samples = std::size_t{19};
+
+	static auto convert(const std::vector<sample_t>& src, const float* dither = nullptr) -> std::vector<int_sample_t>
+	{
+		auto dst = std::vector<int_sample_t>(src.size());
+		lmms::MixHelpers::convertToS16(dst.data(), src.data(), dither, src.size());
+		return dst;
+	}
+
+private slots:
+	//! Verifies samples are scaled and rounded to the nearest integer
+	void ConvertToS16_InRange_Rounds()
+	{
+		auto src = std::vector<sample_t>(Samples, 0.5f);
+		src[0] = 0.f;
+		src[Samples - 1] = -0.25f;
+
+		const auto dst = convert(src);
+
+		QCOMPARE(dst[0], int_sample_t{0});
+		QCOMPARE(dst[1], int_sample_t{16384});
+		QCOMPARE(dst[Samples - 1], int_sample_t{-8192});
+	}
+
+	//! Verifies samples beyond full scale are clipped instead of wrapping around, also with dither pushing them out
+	void ConvertToS16_OutOfRange_Clips()
+	{
+		auto src = std::vector<sample_t>(Samples);
+		for (auto i = std::size_t{0}; i < Samples; ++i)
+		{
+			src[i] = i % 2 == 0 ? 2.f + i : -2.f - i;
+		}
+		const auto dither = std::vector<float>(Samples, 0.99f);
+		const auto negativeDither = std::vector<float>(Samples, -0.99f);
+
+		for (const auto& dst : {convert(src), convert(src, dither.data()), convert(src, negativeDither.data())})
+		{
+			for (auto i = std::size_t{0}; i < Samples; ++i)
+			{
+				QCOMPARE(dst[i], src[i] > 0 ? int_sample_t{32767} : int_sample_t{-32768});
+			}
+		}
+	}
+
+	//! Verifies dither of less than one LSB changes samples by one step at most
+	void ConvertToS16_Dither_StaysWithinOneStep()
+	{
+		const auto src = std::vector<sample_t>(Samples, 0.25f); // 8191.75
+		auto dither = std::vector<float>(Samples);
+		for (auto i = std::size_t{0}; i < Samples; ++i)
+		{
+			dither[i] = -0.99f + 1.98f * i / (Samples - 1);
+		}
+
+		const auto plain = convert(src);
+		const auto dithered = convert(src, dither.data());
+
+		QCOMPARE(plain[0], int_sample_t{8192});
+		auto changed = false;
+		for (auto i = std::size_t{0}; i < Samples; ++i)
+		{
+			QVERIFY(std::abs(dithered[i] - plain[i]) <= 1);
+			changed = changed || dithered[i] != plain[i];
+		}
+		QVERIFY(changed);
+	}
+};
+
+QTEST_GUILESS_MAIN(MixHelpersTest)
+#include "MixHelpersTest.moc"
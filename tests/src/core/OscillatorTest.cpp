@@ -0,0 +1,137 @@
+/*
+ * OscillatorTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <array>
+#include <cmath>
+
+#include <QObject>
+#include <QtTest>
+
+#include "Oscillator.h"
+
+namespace
+{
+
+using lmms::Oscillator;
+using WaveShape = Oscillator::WaveShape;
+
+constexpr auto Frames = lmms::f_cnt_t{256};
+constexpr auto Increment = 1.0f / 4410.0f;
+
+//! How LFO buffers were filled before Oscillator::fillLfo(), one sample at a time
+void fillLfoPerSample(WaveShape shape, float* buffer, float phase, float increment, lmms::f_cnt_t frames)
+{
+	for (lmms::f_cnt_t frame = 0; frame < frames; ++frame)
+	{
+		switch (shape)
+		{
+			case WaveShape::Triangle: buffer[frame] = Oscillator::triangleSample(phase); break;
+			case WaveShape::Saw: buffer[frame] = Oscillator::sawSample(phase); break;
+			case WaveShape::Square: buffer[frame] = Oscillator::squareSample(phase); break;
+			case WaveShape::MoogSaw: buffer[frame] = Oscillator::moogSawSample(phase); break;
+			case WaveShape::Exponential: buffer[frame] = Oscillator::expSample(phase); break;
+			case WaveShape::Sine:
+			default: buffer[frame] = Oscillator::sinSample(phase); break;
+		}
+		phase += increment;
+	}
+}
+
+} // namespace
+
+Q_DECLARE_METATYPE(lmms::Oscillator::WaveShape)
+
+class OscillatorTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void FillLfoTest_data()
+	{
+		QTest::addColumn<WaveShape>("shape");
+		QTest::newRow("sine") << WaveShape::Sine;
+		QTest::newRow("triangle") << WaveShape::Triangle;
+		QTest::newRow("saw") << WaveShape::Saw;
+		QTest::newRow("square") << WaveShape::Square;
+		QTest::newRow("moog saw") << WaveShape::MoogSaw;
+		QTest::newRow("exponential") << WaveShape::Exponential;
+	}
+
+	void FillLfoTest()
+	{
+		QFETCH(WaveShape, shape);
+
+		auto buffer = std::array<float, 1001>{};
+		for (float phase = -1.5f; phase < 1.5f; phase += 0.1f)
+		{
+			const float increment = 0.0037f;
+			Oscillator::fillLfo(shape, buffer.data(), phase, increment, buffer.size());
+			for (std::size_t frame = 0; frame < buffer.size(); ++frame)
+			{
+				const float framePhase = phase + frame * increment;
+				auto expected = 0.0f;
+				fillLfoPerSample(shape, &expected, framePhase, 0.0f, 1);
+				// square waves may flip a sample early or late at their edges, as the phase is rounded differently
+				const float fraction = framePhase - std::floor(framePhase);
+				const bool nearEdge = shape == WaveShape::Square && (std::abs(fraction - 0.5f) <= increment
+					|| fraction <= increment || fraction >= 1.0f - increment);
+				if (std::abs(buffer[frame] - expected) > 1e-4f && !nearEdge)
+				{
+					QFAIL(qPrintable(QString{"frame %1 of phase %2: %3 instead of %4"}
+						.arg(frame).arg(phase).arg(buffer[frame]).arg(expected)));
+				}
+			}
+		}
+	}
+
+	void FillLfoBenchmark_data()
+	{
+		FillLfoTest_data();
+	}
+
+	void FillLfoBenchmark()
+	{
+		QFETCH(WaveShape, shape);
+		auto buffer = std::array<float, Frames>{};
+		QBENCHMARK
+		{
+			Oscillator::fillLfo(shape, buffer.data(), 0.25f, Increment, Frames);
+		}
+	}
+
+	void FillLfoPerSampleBenchmark_data()
+	{
+		FillLfoTest_data();
+	}
+
+	void FillLfoPerSampleBenchmark()
+	{
+		QFETCH(WaveShape, shape);
+		auto buffer = std::array<float, Frames>{};
+		QBENCHMARK
+		{
+			fillLfoPerSample(shape, buffer.data(), 0.25f, Increment, Frames);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(OscillatorTest)
+#include "OscillatorTest.moc"
@@ -0,0 +1,113 @@
+/*
+ * RemoteEventRingTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RemotePluginBase.h"
+
+#include <QtTest>
+#include <memory>
+#include <vector>
+
+using lmms::RemoteEvent;
+using lmms::RemoteEventRing;
+
+class RemoteEventRingTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	static auto event(int offset) -> RemoteEvent
+	{
+		auto event = RemoteEvent{.type = RemoteEvent::Type::Parameter, .offset = offset};
+		event.parameter = {0, 0.f};
+		return event;
+	}
+
+	static auto makeRing(std::uint32_t position) -> std::unique_ptr<RemoteEventRing>
+	{
+		auto ring = std::make_unique<RemoteEventRing>();
+		ring->writeIndex = position;
+		ring->readIndex = position;
+		return ring;
+	}
+
+private slots:
+	//! Verifies the ring takes exactly its capacity and refuses further events
+	void Push_Full_Fails()
+	{
+		auto ring = makeRing(0);
+		for (auto i = std::uint32_t{0}; i < RemoteEventRing::Capacity; ++i)
+		{
+			QVERIFY(ring->push(event(static_cast<int>(i))));
+		}
+
+		QVERIFY(!ring->push(event(-1)));
+		QCOMPARE(ring->writePosition(), RemoteEventRing::Capacity);
+	}
+
+	//! Verifies events which fell back to a batch are processed after those in the ring and before later ones,
+	//! following the protocol of RemotePlugin::sendEvent() and RemotePluginClient's IdEvents handler
+	void DrainUntil_Overflow_KeepsOrder()
+	{
+		// close to the end of the index range, so the indices wrap around
+		auto ring = makeRing(0xfffffff0);
+		auto next = 0;
+
+		// host: fills the ring, then the following events go to the batch until it's sent
+		while (ring->push(event(next))) { ++next; }
+		const auto batchPosition = ring->writePosition();
+		auto batch = std::vector<RemoteEvent>{};
+		for (auto i = 0; i < 10; ++i) { batch.push_back(event(next++)); }
+
+		// client: processing the ring makes room, and the host pushes again after the batch was sent
+		auto processed = std::vector<int>{};
+		const auto process = [&](const RemoteEvent& e) { processed.push_back(e.offset); };
+		ring->drainUntil(batchPosition, process);
+		for (const auto& e : batch) { process(e); }
+		for (auto i = 0; i < 10; ++i) { QVERIFY(ring->push(event(next++))); }
+		ring->drain(process);
+
+		QCOMPARE(static_cast<int>(processed.size()), next);
+		for (auto i = 0; i < next; ++i)
+		{
+			QCOMPARE(processed[i], i);
+		}
+	}
+
+	//! Verifies a batch doesn't process events again which were drained before it arrived
+	void DrainUntil_AlreadyDrained_ProcessesNothing()
+	{
+		auto ring = makeRing(0);
+		QVERIFY(ring->push(event(0)));
+		const auto position = ring->writePosition();
+		QVERIFY(ring->push(event(1)));
+
+		auto processed = 0;
+		ring->drain([&](const RemoteEvent&) { ++processed; });
+		ring->drainUntil(position, [&](const RemoteEvent&) { ++processed; });
+
+		QCOMPARE(processed, 2);
+		QVERIFY(ring->empty());
+	}
+};
+
+QTEST_GUILESS_MAIN(RemoteEventRingTest)
+#include "RemoteEventRingTest.moc"
@@ -0,0 +1,141 @@
+/*
+ * SampleBufferTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleBuffer.h"
+
+#include <QtTest>
+#include <vector>
+
+using lmms::SampleBuffer;
+using lmms::SampleFrame;
+
+class SampleBufferTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	static auto frames() -> std::vector<SampleFrame>
+	{
+		return {{0.1f, 0.2f}, {0.3f, 0.4f}, {-0.5f, 0.6f}};
+	}
+
+	static auto toBase64(const std::vector<SampleFrame>& data) -> QString
+	{
+		return SampleBuffer{data.data(), data.size(), 44100}.toBase64();
+	}
+
+private slots:
+	//! Verifies identical embedded samples share one buffer while it is in use, and count as saved until released
+	void FromBase64_SameData_SharesBuffer()
+	{
+		const auto base64 = toBase64(frames());
+		const auto sharedBytes = SampleBuffer::sharedBytes();
+
+		const auto first = SampleBuffer::fromBase64(base64, 44100);
+		auto second = SampleBuffer::fromBase64(base64, 44100);
+		auto third = SampleBuffer::fromBase64(base64, 44100);
+
+		QVERIFY(first == second);
+		QVERIFY(first == third);
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes + 2 * frames().size() * sizeof(SampleFrame));
+
+		third.reset();
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes + frames().size() * sizeof(SampleFrame));
+
+		second.reset();
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes);
+	}
+
+	//! Verifies copies of a buffer, e.g. in a thumbnail or a copied Sample, don't count as saved, unlike another handle
+	void FromBase64_CopiedBuffer_DoesNotCountAsShared()
+	{
+		const auto base64 = toBase64(frames());
+		const auto sharedBytes = SampleBuffer::sharedBytes();
+
+		const auto first = SampleBuffer::fromBase64(base64, 32000);
+		auto copy = first;
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes);
+
+		auto second = SampleBuffer::fromBase64(base64, 32000);
+		QVERIFY(second == first);
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes + frames().size() * sizeof(SampleFrame));
+
+		copy.reset();
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes + frames().size() * sizeof(SampleFrame));
+
+		second.reset();
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes);
+	}
+
+	//! Verifies the same data at another sample rate gets a buffer of its own
+	void FromBase64_OtherSampleRate_DoesNotShareBuffer()
+	{
+		const auto base64 = toBase64(frames());
+
+		const auto first = SampleBuffer::fromBase64(base64, 44100);
+		const auto second = SampleBuffer::fromBase64(base64, 48000);
+
+		QVERIFY(first != second);
+		QCOMPARE(second->sampleRate(), lmms::sample_rate_t{48000});
+	}
+
+	//! Verifies different data gets a buffer of its own
+	void FromBase64_OtherData_DoesNotShareBuffer()
+	{
+		auto otherFrames = frames();
+		otherFrames[1] = SampleFrame{0.7f, 0.8f};
+
+		const auto first = SampleBuffer::fromBase64(toBase64(frames()), 44100);
+		const auto second = SampleBuffer::fromBase64(toBase64(otherFrames), 44100);
+
+		QVERIFY(first != second);
+		QCOMPARE(second->data()[1].left(), 0.7f);
+	}
+
+	//! Verifies buffers which aren't in use anymore are decoded again
+	void FromBase64_ReleasedBuffer_IsDecodedAgain()
+	{
+		const auto base64 = toBase64(frames());
+		SampleBuffer::fromBase64(base64, 22050);
+		const auto sharedBytes = SampleBuffer::sharedBytes();
+
+		const auto buffer = SampleBuffer::fromBase64(base64, 22050);
+
+		QCOMPARE(SampleBuffer::sharedBytes(), sharedBytes);
+		QCOMPARE(buffer->size(), frames().size());
+	}
+
+	//! Verifies a mono buffer keeps one channel and is played and embedded as stereo
+	void Frame_MonoBuffer_SpreadsToBothChannels()
+	{
+		const auto buffer = SampleBuffer{std::vector{0.1f, -0.3f}, std::vector{SampleFrame{1.f}}, 44100};
+
+		QCOMPARE(buffer.channels(), 1);
+		QCOMPARE(buffer.size(), std::size_t{2});
+		QCOMPARE(buffer.frame(1).left(), -0.3f);
+		QCOMPARE(buffer.frame(1).right(), -0.3f);
+		QCOMPARE(buffer.toBase64(), toBase64({SampleFrame{0.1f}, SampleFrame{-0.3f}}));
+	}
+};
+
+QTEST_GUILESS_MAIN(SampleBufferTest)
+#include "SampleBufferTest.moc"
@@ -0,0 +1,339 @@
+/*
+ * SampleDecoderTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Engine.h"
+#include "SampleBuffer.h"
+#include "SampleDecoder.h"
+#include "lmmsconfig.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <optional>
+#include <sndfile.h>
+#include <thread>
+#include <vector>
+
+using lmms::Engine;
+using lmms::SampleBuffer;
+using lmms::SampleDecoder;
+using lmms::SampleFrame;
+
+class SampleDecoderTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	static constexpr auto SampleRate = 44100;
+	static constexpr auto Frames = std::size_t{1000};
+	static constexpr auto MixLevel = 0.7071f;
+
+	//! Write @p channels interleaved channels of @p samples to @p fileName, or return false if that's not supported
+	bool writeFile(const QString& fileName, int format, int channels, const std::vector<float>& samples,
+		const std::vector<int>& channelMap = {})
+	{
+		auto info = SF_INFO{};
+		info.samplerate = SampleRate;
+		info.channels = channels;
+		info.format = format;
+
+		SNDFILE* file = sf_open(m_directory.filePath(fileName).toLocal8Bit().constData(), SFM_WRITE, &info);
+		if (!file) { return false; }
+
+		if (!channelMap.empty())
+		{
+			auto map = channelMap;
+			sf_command(file, SFC_SET_CHANNEL_MAP_INFO, map.data(), static_cast<int>(map.size() * sizeof(int)));
+		}
+		const auto frames = static_cast<sf_count_t>(samples.size() / channels);
+		const auto written = sf_writef_float(file, samples.data(), frames);
+		sf_close(file);
+		return written == frames;
+	}
+
+	//! Frames with a constant value per channel
+	static auto constantSamples(const std::vector<float>& values) -> std::vector<float>
+	{
+		auto samples = std::vector<float>{};
+		for (auto frame = std::size_t{0}; frame < Frames; ++frame)
+		{
+			samples.insert(samples.end(), values.begin(), values.end());
+		}
+		return samples;
+	}
+
+	static void compareFrames(const std::vector<SampleFrame>& frames, SampleFrame expected)
+	{
+		QCOMPARE(frames.size(), Frames);
+		for (const auto& frame : frames)
+		{
+			QVERIFY(std::abs(frame.left() - expected.left()) < 1e-5f);
+			QVERIFY(std::abs(frame.right() - expected.right()) < 1e-5f);
+		}
+	}
+
+	static auto sameFrames(const std::vector<SampleFrame>& frames, const std::vector<SampleFrame>& expected) -> bool
+	{
+		return std::equal(frames.begin(), frames.end(), expected.begin(), expected.end(),
+			[](const SampleFrame& a, const SampleFrame& b) { return a.left() == b.left() && a.right() == b.right(); });
+	}
+
+	//! The stereo frames a decoded sample is played as
+	static auto playedFrames(SampleDecoder::Result result) -> std::vector<SampleFrame>
+	{
+		if (result.levels.empty()) { return std::move(result.data); }
+
+		const auto buffer = SampleBuffer{std::move(result.samples), std::move(result.levels), result.sampleRate};
+		auto frames = std::vector<SampleFrame>{};
+		for (auto i = std::size_t{0}; i < buffer.size(); ++i)
+		{
+			frames.push_back(buffer.frame(i));
+		}
+		return frames;
+	}
+
+	//! Frames of the 5.1 test file: front left and right, center, bass, back left and right
+	static auto surroundSamples() -> std::vector<float>
+	{
+		return constantSamples({0.1f, 0.2f, 0.3f, 0.4f, 0.05f, 0.06f});
+	}
+
+	static auto surroundMap() -> std::vector<int>
+	{
+		return {SF_CHANNEL_MAP_FRONT_LEFT, SF_CHANNEL_MAP_FRONT_RIGHT, SF_CHANNEL_MAP_FRONT_CENTER,
+			SF_CHANNEL_MAP_LFE, SF_CHANNEL_MAP_REAR_LEFT, SF_CHANNEL_MAP_REAR_RIGHT};
+	}
+
+	static auto surroundFrame() -> SampleFrame
+	{
+		return {0.1f + MixLevel * 0.3f + MixLevel * 0.05f, 0.2f + MixLevel * 0.3f + MixLevel * 0.06f};
+	}
+
+	//! Power per frame of the sine in the Vorbis test files, lossy encoding only adds a little noise
+	static constexpr auto SinePower = 0.125f;
+
+	//! Write a Vorbis file with a sine in @p loudChannel and silence in the other ones
+	bool writeVorbisFile(const QString& fileName, int channels, int loudChannel)
+	{
+		auto samples = std::vector<float>{};
+		for (auto frame = std::size_t{0}; frame < Frames; ++frame)
+		{
+			for (auto channel = 0; channel < channels; ++channel)
+			{
+				samples.push_back(channel == loudChannel
+					? 0.5f * std::sin(2 * std::numbers::pi_v<float> * 441.f * frame / SampleRate)
+					: 0.f);
+			}
+		}
+		return writeFile(fileName, SF_FORMAT_OGG | SF_FORMAT_VORBIS, channels, samples);
+	}
+
+	//! Mean power of @p channel in #Frames frames of interleaved @p samples
+	static auto power(const float* samples, std::size_t channels, std::size_t channel) -> float
+	{
+		auto sum = 0.f;
+		for (auto frame = std::size_t{0}; frame < Frames; ++frame)
+		{
+			const auto sample = samples[frame * channels + channel];
+			sum += sample * sample;
+		}
+		return sum / Frames;
+	}
+
+	//! Write a DrumSynth file with only a tone of @p frequency Hz, lasting @p length samples at 44100 Hz
+	bool writeDrumSynthFile(const QString& fileName, int frequency, int length)
+	{
+		auto file = QFile{m_directory.filePath(fileName)};
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) { return false; }
+
+		const auto content = QString{"[General]\nVersion=DrumSynth v2.0\nStretch=100.0\n\n"
+			"[Tone]\nOn=1\nLevel=128\nF1=%1\nF2=%1\nDroop=0\nPhase=0\nEnvelope=0,100 %2,100 %3,0\n"}
+			.arg(frequency).arg(length / 2).arg(length);
+		return file.write(content.toLatin1()) > 0;
+	}
+
+	QTemporaryDir m_directory;
+
+private slots:
+	void initTestCase()
+	{
+		QVERIFY(m_directory.isValid());
+
+		// DrumSynth files are generated at the engine's sample rate
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		Engine::destroy();
+	}
+
+	//! Verifies a mono file is kept mono and played in both channels
+	void Decode_MonoWav_KeepsChannel()
+	{
+		QVERIFY(writeFile("mono.wav", SF_FORMAT_WAV | SF_FORMAT_FLOAT, 1, constantSamples({0.25f})));
+
+		auto result = SampleDecoder::decode(m_directory.filePath("mono.wav"));
+
+		QVERIFY(result);
+		QCOMPARE(result->sampleRate, SampleRate);
+		QVERIFY(result->data.empty());
+		QCOMPARE(result->samples, constantSamples({0.25f}));
+		compareFrames(playedFrames(std::move(*result)), {0.25f, 0.25f});
+	}
+
+	//! Verifies a stereo file is decoded as it is
+	void Decode_StereoWav_KeepsChannels()
+	{
+		QVERIFY(writeFile("stereo.wav", SF_FORMAT_WAV | SF_FORMAT_FLOAT, 2, constantSamples({0.25f, -0.5f})));
+
+		const auto result = SampleDecoder::decode(m_directory.filePath("stereo.wav"));
+
+		QVERIFY(result);
+		QVERIFY(result->levels.empty());
+		compareFrames(result->data, {0.25f, -0.5f});
+	}
+
+	//! Verifies a 5.1 file keeps all channels and is played mixed down by its channel map, without the bass channel
+	void Decode_SurroundWav_KeepsChannels()
+	{
+		QVERIFY(writeFile("surround.wav", SF_FORMAT_WAVEX | SF_FORMAT_FLOAT, 6, surroundSamples(), surroundMap()));
+
+		auto result = SampleDecoder::decode(m_directory.filePath("surround.wav"));
+
+		QVERIFY(result);
+		QCOMPARE(result->levels.size(), std::size_t{6});
+		QCOMPARE(result->samples, surroundSamples());
+		compareFrames(playedFrames(std::move(*result)), surroundFrame());
+	}
+
+	//! Verifies streaming a 5.1 file gives the same frames as decoding it into memory
+	void DecodeIntoDevice_SurroundWav_MixesDown()
+	{
+		QVERIFY(writeFile("streamed.wav", SF_FORMAT_WAVEX | SF_FORMAT_FLOAT, 6, surroundSamples(), surroundMap()));
+
+		auto buffer = QBuffer{};
+		QVERIFY(buffer.open(QIODevice::ReadWrite));
+		const auto sampleRate = SampleDecoder::decode(m_directory.filePath("streamed.wav"), buffer);
+
+		QVERIFY(sampleRate);
+		QCOMPARE(*sampleRate, SampleRate);
+		const auto bytes = buffer.data();
+		const auto data = reinterpret_cast<const SampleFrame*>(bytes.constData());
+		compareFrames({data, data + bytes.size() / sizeof(SampleFrame)}, surroundFrame());
+	}
+
+	//! Verifies the channels of a Vorbis file end up in their place, whichever library decodes it
+	void Decode_StereoVorbis_KeepsChannels()
+	{
+		if (!writeVorbisFile("stereo.ogg", 2, 0)) { QSKIP("libsndfile can't write Vorbis files"); }
+
+		const auto result = SampleDecoder::decode(m_directory.filePath("stereo.ogg"));
+
+		QVERIFY(result);
+		QVERIFY(result->levels.empty());
+		QCOMPARE(result->data.size(), Frames);
+		const auto samples = &result->data.data()->left();
+		QVERIFY(std::abs(power(samples, 2, 0) - SinePower) < 0.01f);
+		QVERIFY(power(samples, 2, 1) < 0.001f);
+	}
+
+	//! Verifies two DrumSynth files generated at the same time come out like they do one after another
+	void Decode_DrumSynthConcurrently_MatchesSerial()
+	{
+		QVERIFY(writeDrumSynthFile("low.ds", 100, 20000));
+		QVERIFY(writeDrumSynthFile("high.ds", 1000, 30000));
+		const auto low = m_directory.filePath("low.ds");
+		const auto high = m_directory.filePath("high.ds");
+
+		const auto expectedLow = SampleDecoder::decode(low);
+		const auto expectedHigh = SampleDecoder::decode(high);
+		QVERIFY(expectedLow);
+		QVERIFY(expectedHigh);
+		QVERIFY(expectedLow->data.size() != expectedHigh->data.size());
+
+		for (auto round = 0; round < 10; ++round)
+		{
+			auto resultLow = std::optional<SampleDecoder::Result>{};
+			auto resultHigh = std::optional<SampleDecoder::Result>{};
+			auto thread = std::thread{[&] { resultLow = SampleDecoder::decode(low); }};
+			resultHigh = SampleDecoder::decode(high);
+			thread.join();
+
+			QVERIFY(resultLow);
+			QVERIFY(resultHigh);
+			QVERIFY(sameFrames(resultLow->data, expectedLow->data));
+			QVERIFY(sameFrames(resultHigh->data, expectedHigh->data));
+		}
+	}
+
+#ifdef LMMS_HAVE_OGGVORBIS
+	//! Verifies libvorbisfile, which returns one array per channel, puts the channels of a stereo file in place
+	void DecodeWithVorbisFile_StereoVorbis_KeepsChannels()
+	{
+		if (!writeVorbisFile("vorbisfile.ogg", 2, 1)) { QSKIP("libsndfile can't write Vorbis files"); }
+
+		const auto result
+			= SampleDecoder::decode(m_directory.filePath("vorbisfile.ogg"), SampleDecoder::Library::OggVorbis);
+
+		QVERIFY(result);
+		QVERIFY(result->levels.empty());
+		QCOMPARE(result->data.size(), Frames);
+		const auto samples = &result->data.data()->left();
+		QVERIFY(power(samples, 2, 0) < 0.001f);
+		QVERIFY(std::abs(power(samples, 2, 1) - SinePower) < 0.01f);
+	}
+
+	//! Verifies libvorbisfile interleaves a file with more channels and places them in the Vorbis channel order
+	void DecodeWithVorbisFile_ThreeChannelVorbis_KeepsChannelOrder()
+	{
+		if (!writeVorbisFile("three.ogg", 3, 2)) { QSKIP("libsndfile can't write Vorbis files"); }
+
+		const auto result
+			= SampleDecoder::decode(m_directory.filePath("three.ogg"), SampleDecoder::Library::OggVorbis);
+
+		QVERIFY(result);
+		QVERIFY(result->data.empty());
+		QCOMPARE(result->samples.size(), Frames * 3);
+
+		// left, center and right, see the Vorbis I specification, section 4.3.9
+		const auto levels = std::vector<SampleFrame>{{1.f, 0.f}, {MixLevel, MixLevel}, {0.f, 1.f}};
+		QCOMPARE(result->levels.size(), levels.size());
+		for (auto channel = std::size_t{0}; channel < levels.size(); ++channel)
+		{
+			QVERIFY(std::abs(result->levels[channel].left() - levels[channel].left()) < 1e-4f);
+			QVERIFY(std::abs(result->levels[channel].right() - levels[channel].right()) < 1e-4f);
+		}
+
+		QVERIFY(power(result->samples.data(), 3, 0) < 0.001f);
+		QVERIFY(power(result->samples.data(), 3, 1) < 0.001f);
+		QVERIFY(std::abs(power(result->samples.data(), 3, 2) - SinePower) < 0.01f);
+	}
+#endif // LMMS_HAVE_OGGVORBIS
+};
+
+QTEST_GUILESS_MAIN(SampleDecoderTest)
+#include "SampleDecoderTest.moc"
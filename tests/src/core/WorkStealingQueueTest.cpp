@@ -0,0 +1,106 @@
+/*
+ * WorkStealingQueueTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "WorkStealingQueue.h"
+
+#include <QObject>
+#include <QtTest>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using lmms::WorkStealingQueue;
+
+class WorkStealingQueueTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void capacityTest()
+	{
+		// Capacity is rounded up to a power of two
+		auto q = WorkStealingQueue<int>(5);
+		QCOMPARE(q.capacity(), std::size_t{8});
+
+		for (int i = 0; i < 8; ++i) { QVERIFY(q.push(i)); }
+		QVERIFY(!q.push(8));
+		QCOMPARE(q.size(), std::size_t{8});
+	}
+
+	void ownerIsLifoThiefIsFifoTest()
+	{
+		auto q = WorkStealingQueue<int>(8);
+		q.push(1);
+		q.push(2);
+		q.push(3);
+
+		int item = 0;
+		QVERIFY(q.pop(item));
+		QCOMPARE(item, 3);
+		QVERIFY(q.steal(item));
+		QCOMPARE(item, 1);
+		QVERIFY(q.pop(item));
+		QCOMPARE(item, 2);
+
+		QVERIFY(q.empty());
+		QVERIFY(!q.pop(item));
+		QVERIFY(!q.steal(item));
+	}
+
+	void concurrentStealTest()
+	{
+		// Every item must be taken exactly once, no matter who takes it
+		constexpr int Items = 100000;
+		auto q = WorkStealingQueue<int>(64);
+		auto taken = std::vector<std::atomic_int>(Items);
+		auto done = std::atomic_bool{false};
+
+		auto thieves = std::vector<std::thread>{};
+		for (int t = 0; t < 3; ++t)
+		{
+			thieves.emplace_back([&] {
+				int item = 0;
+				while (!done || !q.empty())
+				{
+					if (q.steal(item)) { ++taken[item]; }
+				}
+			});
+		}
+
+		int item = 0;
+		for (int i = 0; i < Items; ++i)
+		{
+			while (!q.push(i))
+			{
+				if (q.pop(item)) { ++taken[item]; }
+			}
+		}
+		while (q.pop(item)) { ++taken[item]; }
+
+		done = true;
+		for (auto& thief : thieves) { thief.join(); }
+
+		for (const auto& count : taken) { QCOMPARE(count.load(), 1); }
+	}
+};
+
+QTEST_GUILESS_MAIN(WorkStealingQueueTest)
+#include "WorkStealingQueueTest.moc"
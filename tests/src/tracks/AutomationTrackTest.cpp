@@ -85,6 +85,32 @@ private slots:
 		QCOMPARE(c.valueAt(150), 1.0f);
 	}
 
+	void testClipRenderValues()
+	{
+		using namespace lmms;
+
+		AutomationClip c(nullptr);
+		c.setProgressionType(AutomationClip::ProgressionType::Linear);
+		c.putValue(0, 0.0, false);
+		c.putValue(100, 1.0, false);
+
+		// from before the clip's start to after its last node, a quarter tick apart
+		float values[12];
+		c.renderValues(98.5f, 0.25f, values, 12);
+
+		QCOMPARE(values[0], 0.985f);
+		QCOMPARE(values[2], 0.99f);
+		QCOMPARE(values[5], 0.9975f);
+		QCOMPARE(values[6], 1.0f);
+		QCOMPARE(values[11], 1.0f);
+
+		for (int tick = 0; tick < 100; tick += 10)
+		{
+			c.renderValues(tick, 1.f, values, 1);
+			QCOMPARE(values[0], c.valueAt(tick));
+		}
+	}
+
 	void testClips()
 	{
 		using namespace lmms;